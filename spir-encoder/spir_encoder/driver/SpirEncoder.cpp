@@ -0,0 +1,362 @@
+//===------------------------- SpirEncoder.cpp ---------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+
+
+#include "encoder/LLVMVersion.h"
+#include "encoder/SpirBitcodeWriter.h"
+#include "encoder/SpirEncoderStats.h"
+#include "encoder/SpirThreading.h"
+#ifdef SPIR_ENCODER_VERIFY
+#include "validation/SpirValidation.h"
+#endif
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/SourceMgr.h>
+#if LLVM_VERSION < 3500
+#include <llvm/Support/Threading.h>
+#endif
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+// Command line arguments.
+static cl::opt<std::string>
+InputFilename(cl::Positional, cl::desc("<input bitcode file>"));
+static cl::opt<std::string>
+OutputFilename(cl::Positional, cl::desc("<output bitcode file>"));
+static cl::opt<std::string>
+BatchFilename("batch", cl::value_desc("manifest"),
+              cl::desc("Convert the files listed in <manifest>, one "
+                       "'<input> <output>' pair per line"));
+static cl::opt<unsigned>
+Jobs("j", cl::desc("Number of files converted in parallel in batch mode, "
+                   "0 for one per hardware thread (default = 0)"),
+     cl::init(0));
+// LLVM already defines -stats for its pass statistics.
+static cl::opt<bool>
+Stats("encoder-stats", cl::desc("Print size and timing statistics on the "
+                                "blocks of the encoded modules"));
+enum StatsFormatTy { StatsText, StatsJSON };
+static cl::opt<StatsFormatTy>
+StatsFormat("encoder-stats-format",
+            cl::desc("Format of the -encoder-stats report:"),
+            cl::values(clEnumValN(StatsText, "text", "a table (default)"),
+                       clEnumValN(StatsJSON, "json", "a JSON object"),
+                       clEnumValEnd),
+            cl::init(StatsText));
+#ifdef SPIR_ENCODER_VERIFY
+static cl::opt<bool>
+Verify("verify", cl::desc("Check the encoded module with the SPIR verifier, "
+                          "and only write the output file if it is valid"));
+#endif
+
+namespace {
+/// An input file and the file its re-encoded module is written to.
+struct FilePair {
+  string Input;
+  string Output;
+};
+}
+
+#ifdef SPIR_ENCODER_VERIFY
+/// Parse the encoded module back from memory and run the SPIR verifier on
+/// it. Returns false and sets Error if the module is not valid SPIR.
+static bool VerifyEncoded(const string &Input,
+                          const SmallVectorImpl<char> &Encoded, string &Error)
+{
+  // The module is parsed in a context of its own, as its named types would
+  // otherwise be renamed to avoid clashing with the original module's.
+  LLVMContext Context;
+  SMDiagnostic ErrInfo;
+  Module *M = ParseIR(MemoryBuffer::getMemBuffer(
+    StringRef(Encoded.data(), Encoded.size()), Input, false), ErrInfo, Context);
+  if (!M)
+  {
+    Error = Input + ": cannot parse the encoded module: " +
+            ErrInfo.getMessage().str();
+    return false;
+  }
+
+  SPIR::SpirValidation Validation;
+  Validation.runOnModule(*M);
+  const SPIR::ErrorPrinter *EP = Validation.getErrorPrinter();
+  bool Valid = !EP->hasErrors();
+  if (!Valid)
+  {
+    raw_string_ostream ErrStream(Error);
+    ErrStream << Input << ": the encoded module is not a valid SPIR module:\n";
+    EP->print(ErrStream, false);
+    ErrStream.flush();
+  }
+  delete M;
+  return Valid;
+}
+#endif
+
+/// Re-encode the module in Input to Output, using the given context, and
+/// add the statistics of the encoded blocks to Stats if it is not null.
+/// Returns false and sets Error if the conversion failed.
+static bool EncodeFile(const char *ProgName, const string &Input,
+                       const string &Output, LLVMContext &Context,
+                       SPIR::EncoderStats *Stats, string &Error)
+{
+  // Load bitcode module from file
+  SMDiagnostic ErrInfo;
+  Module *M = ParseIRFile(Input, ErrInfo, Context);
+  if (!M)
+  {
+    raw_string_ostream ErrStream(Error);
+    ErrInfo.print(ProgName, ErrStream);
+    ErrStream.flush();
+    return false;
+  }
+
+  // With -verify, the module is encoded into memory and checked before the
+  // output file is created, so that invalid modules leave no output behind.
+  SmallVector<char, 0> Encoded;
+#ifdef SPIR_ENCODER_VERIFY
+  if (Verify)
+  {
+    {
+      raw_svector_ostream EncodedStream(Encoded);
+      SPIR::WriteBitcodeToFile_SPIR(M, EncodedStream, Stats);
+    }
+    delete M;
+    M = 0;
+    if (!VerifyEncoded(Input, Encoded, Error))
+      return false;
+  }
+#endif
+
+  // Open output file
+  raw_fd_ostream Out(Output.c_str(), Error, sys::fs::F_None);
+  if (!Error.empty())
+  {
+    delete M;
+    return false;
+  }
+
+  // Output re-encoded module
+  if (M)
+  {
+    SPIR::WriteBitcodeToFile_SPIR(M, Out, Stats);
+    delete M;
+  }
+  else
+  {
+    Out.write(Encoded.data(), Encoded.size());
+  }
+
+  Out.close();
+  if (Out.has_error())
+  {
+    Error = "error writing " + Output;
+    Out.clear_error();
+    return false;
+  }
+  return true;
+}
+
+/// Print an error message returned by EncodeFile.
+static void PrintError(const string &Error)
+{
+  cerr << Error;
+  if (!Error.empty() && Error[Error.size() - 1] != '\n')
+    cerr << endl;
+}
+
+/// Print the -encoder-stats report.
+static void PrintStats(const SPIR::EncoderStats &Stats)
+{
+  if (StatsFormat == StatsJSON)
+    Stats.printJSON(outs());
+  else
+    Stats.print(outs());
+}
+
+/// Read the input/output pairs listed in the manifest. Blank lines and lines
+/// starting with '#' are ignored.
+static bool ReadManifest(const string &Path, vector<FilePair> &Files)
+{
+  ifstream Manifest(Path.c_str());
+  if (!Manifest)
+  {
+    cerr << "cannot open " << Path << endl;
+    return false;
+  }
+
+  string Text;
+  for (unsigned LineNo = 1; getline(Manifest, Text); ++LineNo)
+  {
+    StringRef Line = StringRef(Text).trim();
+    if (Line.empty() || Line[0] == '#')
+      continue;
+    size_t Sep = Line.find_first_of(" \t");
+    StringRef Output;
+    if (Sep != StringRef::npos)
+      Output = Line.substr(Sep).trim();
+    if (Output.empty())
+    {
+      cerr << Path << ":" << LineNo << ": expected '<input> <output>'"
+           << endl;
+      return false;
+    }
+    FilePair Pair;
+    Pair.Input = Line.substr(0, Sep).str();
+    Pair.Output = Output.str();
+    Files.push_back(Pair);
+  }
+  return true;
+}
+
+namespace {
+/// The files of a batch and the conversion results, shared by the workers.
+struct Batch {
+  const char *ProgName;
+  const vector<FilePair> *Files;
+  unsigned NumFailed;
+  /// Statistics of the converted files, with -encoder-stats.
+  SPIR::EncoderStats *Stats;
+#if SPIR_ENCODER_PARALLEL
+  /// Next file to convert.
+  std::atomic<size_t> Next;
+  /// Serializes status reports.
+  std::mutex Lock;
+#else
+  size_t Next;
+#endif
+};
+}
+
+/// Convert files of the batch until none are left, reporting the status of
+/// each. Each file is loaded in a context of its own: named struct types of
+/// a context are uniqued by name, so later modules would see theirs renamed,
+/// and types live as long as the context that created them.
+static void ConvertFiles(Batch *B)
+{
+  for (size_t I = B->Next++; I < B->Files->size(); I = B->Next++)
+  {
+    const FilePair &File = (*B->Files)[I];
+    string Error;
+    SPIR::EncoderStats FileStats;
+    LLVMContext Context;
+    bool Success = EncodeFile(B->ProgName, File.Input, File.Output, Context,
+                              B->Stats ? &FileStats : 0, Error);
+#if SPIR_ENCODER_PARALLEL
+    std::lock_guard<std::mutex> Guard(B->Lock);
+#endif
+    if (B->Stats)
+      B->Stats->merge(FileStats);
+    if (Success)
+    {
+      cout << "OK " << File.Input << " -> " << File.Output << endl;
+    }
+    else
+    {
+      ++B->NumFailed;
+      cout << "FAILED " << File.Input << endl;
+      PrintError(Error);
+    }
+  }
+}
+
+/// Convert all the files in the manifest. Returns 0 if all of them were
+/// converted, 1 otherwise.
+static int RunBatch(const char *ProgName)
+{
+  vector<FilePair> Files;
+  if (!ReadManifest(BatchFilename, Files))
+    return 1;
+
+  Batch B;
+  B.ProgName = ProgName;
+  B.Files = &Files;
+  B.NumFailed = 0;
+  SPIR::EncoderStats BatchStats;
+  B.Stats = Stats ? &BatchStats : 0;
+  B.Next = 0;
+
+#if SPIR_ENCODER_PARALLEL
+  unsigned NumThreads = Jobs;
+  if (NumThreads == 0)
+    NumThreads = std::max(std::thread::hardware_concurrency(), 1U);
+  if (NumThreads > Files.size())
+    NumThreads = (unsigned)Files.size();
+
+#if LLVM_VERSION < 3500
+  // LLVM 3.4 only guards its global state once multithreading is enabled.
+  if (NumThreads > 1 && !llvm_start_multithreaded())
+    NumThreads = 1;
+#endif
+
+  // The calling thread is one of the workers.
+  vector<std::thread> Threads;
+  for (unsigned t = 1; t < NumThreads; ++t)
+    Threads.push_back(std::thread(ConvertFiles, &B));
+  ConvertFiles(&B);
+  for (unsigned t = 0; t < Threads.size(); ++t)
+    Threads[t].join();
+#else
+  ConvertFiles(&B);
+#endif
+
+  cout << Files.size() - B.NumFailed << " of " << Files.size()
+       << " files converted" << endl;
+  if (Stats)
+    PrintStats(BatchStats);
+  return B.NumFailed ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+  // Parse command line arguments
+  cl::ParseCommandLineOptions(argc, argv, "SPIR Encoder");
+
+  if (!BatchFilename.empty())
+  {
+    if (!InputFilename.empty())
+    {
+      cerr << argv[0] << ": input files can't be given with -batch" << endl;
+      return 1;
+    }
+    return RunBatch(argv[0]);
+  }
+
+  if (InputFilename.empty() || OutputFilename.empty())
+  {
+    cerr << argv[0] << ": expected <input bitcode file> "
+         << "<output bitcode file> or -batch <manifest>" << endl;
+    return 1;
+  }
+
+  string Error;
+  SPIR::EncoderStats FileStats;
+  if (!EncodeFile(argv[0], InputFilename, OutputFilename,
+                  getGlobalContext(), Stats ? &FileStats : 0, Error))
+  {
+    PrintError(Error);
+    return 1;
+  }
+  if (Stats)
+    PrintStats(FileStats);
+
+  return 0;
+}
@@ -0,0 +1,246 @@
+//===------------------------ AbbrevProfile.cpp --------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+
+#include "AbbrevProfile.h"
+#include "LLVMBitCodes.h"
+
+#include "llvm/Support/MathExtras.h"
+
+#include <cstring>
+
+using namespace llvm;
+
+namespace SPIR
+{
+  AbbrevProfile::WidthHistogram::WidthHistogram()
+    : NumValues(0), MaxWidth(0) {
+    memset(Count, 0, sizeof(Count));
+  }
+
+  void AbbrevProfile::WidthHistogram::add(uint64_t V) {
+    unsigned Width = V ? Log2_64(V) + 1 : 0;
+    ++Count[Width];
+    ++NumValues;
+    MaxWidth = std::max(MaxWidth, Width);
+  }
+
+  void AbbrevProfile::WidthHistogram::add(const WidthHistogram &Other) {
+    for (unsigned w = 0; w != NumWidths; ++w)
+      Count[w] += Other.Count[w];
+    NumValues += Other.NumValues;
+    MaxWidth = std::max(MaxWidth, Other.MaxWidth);
+  }
+
+  AbbrevProfile::CodeProfile::CodeProfile()
+    : NumRecords(0), MinOps(0), MaxOps(0), UnabbrevBits(0), Char6From(0) {
+    memset(Literal, 0, sizeof(Literal));
+    memset(NotLiteral, 0, sizeof(NotLiteral));
+    memset(TailLengthBits, 0, sizeof(TailLengthBits));
+  }
+
+  void AbbrevProfile::addBlock(unsigned BlockID, unsigned CodeLen,
+                               unsigned NumAbbrevs) {
+    BlockProfile &Block = Blocks[BlockID];
+    if (!Block.CodeLen || CodeLen < Block.CodeLen)
+      Block.CodeLen = CodeLen;
+    Block.MaxAbbrevs = std::max(Block.MaxAbbrevs, NumAbbrevs);
+    // END_BLOCK.
+    ++Block.NumCodes;
+  }
+
+  uint64_t AbbrevProfile::VBRBits(uint64_t V, unsigned Width) {
+    if (!V)
+      return Width;
+    unsigned Bits = Log2_64(V) + 1;
+    return (Bits + Width - 2) / (Width - 1) * Width;
+  }
+
+  // Sets Op to the cheapest encoding of NumValues values, of which Count[w]
+  // are w bits wide, and returns their size in bits with that encoding. Char6
+  // is only considered if AllowChar6 is set.
+  static uint64_t selectEncoding(const uint64_t *Count, uint64_t NumValues,
+                                 unsigned MaxWidth, bool AllowChar6,
+                                 BitCodeAbbrevOp &Op) {
+    // Fixed fields are emitted with at most 32 bits, and a zero width would
+    // not be understood by old readers.
+    uint64_t Best = ~0ULL;
+    if (MaxWidth <= 32) {
+      unsigned Width = std::max(MaxWidth, 1U);
+      Best = Width * NumValues;
+      Op = BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, Width);
+    }
+    if (AllowChar6 && 6 * NumValues < Best) {
+      Best = 6 * NumValues;
+      Op = BitCodeAbbrevOp(BitCodeAbbrevOp::Char6);
+    }
+    for (unsigned Width = 2; Width <= 32; ++Width) {
+      uint64_t Bits = Count[0] * Width;
+      for (unsigned w = 1; w <= MaxWidth; ++w)
+        Bits += Count[w] * ((w + Width - 2) / (Width - 1) * Width);
+      if (Bits < Best) {
+        Best = Bits;
+        Op = BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, Width);
+      }
+    }
+    return Best;
+  }
+
+  // Returns the number of bits of the DEFINE_ABBREV record of Abbv in the
+  // BLOCKINFO block.
+  static uint64_t definitionBits(const BitCodeAbbrev *Abbv) {
+    uint64_t Bits = 2 + AbbrevProfile::VBRBits(Abbv->getNumOperandInfos(), 5);
+    for (unsigned i = 0, e = Abbv->getNumOperandInfos(); i != e; ++i) {
+      const BitCodeAbbrevOp &Op = Abbv->getOperandInfo(i);
+      if (Op.isLiteral()) {
+        Bits += 1 + AbbrevProfile::VBRBits(Op.getLiteralValue(), 8);
+      } else {
+        Bits += 1 + 3;
+        if (Op.hasEncodingData())
+          Bits += AbbrevProfile::VBRBits(Op.getEncodingData(), 5);
+      }
+    }
+    return Bits;
+  }
+
+  /// Select the abbreviation that encodes the records of Profile with the
+  /// fewest bits, and set Savings to the bits it saves, including the cost
+  /// of its definition. The records start with MaxScalarOps or fewer
+  /// operands with an encoding of their own, and may end with an array.
+  BitCodeAbbrev *AbbrevProfile::selectAbbrev(unsigned Code,
+                                             const CodeProfile &Profile,
+                                             int64_t &Savings) {
+    SmallVector<BitCodeAbbrevOp, MaxScalarOps> Scalars;
+    uint64_t ScalarBits[MaxScalarOps];
+    unsigned MaxK = std::min(Profile.MinOps, MaxScalarOps);
+    for (unsigned i = 0; i != MaxK; ++i) {
+      if (!Profile.NotLiteral[i]) {
+        Scalars.push_back(BitCodeAbbrevOp(Profile.Literal[i]));
+        ScalarBits[i] = 0;
+        continue;
+      }
+      const WidthHistogram &H = Profile.Ops[i];
+      BitCodeAbbrevOp Op(BitCodeAbbrevOp::VBR, 6);
+      ScalarBits[i] = selectEncoding(H.Count, H.NumValues, H.MaxWidth, false,
+                                     Op);
+      Scalars.push_back(Op);
+    }
+
+    // Try each number of leading scalar operands, the other operands are
+    // encoded as an array unless all records have exactly K operands.
+    uint64_t BestBits = ~0ULL;
+    unsigned BestK = 0;
+    bool BestArray = false;
+    BitCodeAbbrevOp BestElt(BitCodeAbbrevOp::VBR, 6);
+    uint64_t ScalarsBits = 0;
+    for (unsigned K = 0; K <= MaxK; ++K) {
+      if (K)
+        ScalarsBits += ScalarBits[K - 1];
+      bool NeedArray = !(Profile.MinOps == Profile.MaxOps &&
+                         K == Profile.MinOps);
+      uint64_t Bits = ScalarsBits;
+      BitCodeAbbrevOp Elt(BitCodeAbbrevOp::VBR, 6);
+      if (NeedArray) {
+        WidthHistogram Tail = Profile.Rest;
+        for (unsigned i = K; i < MaxScalarOps; ++i)
+          Tail.add(Profile.Ops[i]);
+        Bits += Profile.TailLengthBits[K];
+        Bits += selectEncoding(Tail.Count, Tail.NumValues, Tail.MaxWidth,
+                               K >= Profile.Char6From, Elt);
+      }
+      if (Bits < BestBits) {
+        BestBits = Bits;
+        BestK = K;
+        BestArray = NeedArray;
+        BestElt = Elt;
+      }
+    }
+
+    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+    Abbv->Add(BitCodeAbbrevOp(Code));
+    for (unsigned i = 0; i != BestK; ++i)
+      Abbv->Add(Scalars[i]);
+    if (BestArray) {
+      Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+      Abbv->Add(BestElt);
+    }
+    Savings = (int64_t)Profile.UnabbrevBits - (int64_t)BestBits -
+              (int64_t)definitionBits(Abbv);
+    return Abbv;
+  }
+
+  namespace {
+    /// An abbreviation and the bits it saves.
+    struct Candidate {
+      int64_t Savings;
+      AbbrevProfile::RecordAbbrev Abbrev;
+      bool operator<(const Candidate &Other) const {
+        if (Savings != Other.Savings)
+          return Savings > Other.Savings;
+        return Abbrev.Code < Other.Abbrev.Code;
+      }
+    };
+  }
+
+  void AbbrevProfile::selectAbbrevs(std::vector<BlockAbbrevs> &Result) const {
+    for (std::map<unsigned, BlockProfile>::const_iterator
+           I = Blocks.begin(), E = Blocks.end(); I != E; ++I) {
+      unsigned BlockID = I->first;
+      const BlockProfile &Block = I->second;
+      if (BlockID == bitc::BLOCKINFO_BLOCK_ID ||
+          BlockID == bitc::MODULE_BLOCK_ID || !Block.CodeLen)
+        continue;
+
+      std::vector<Candidate> Candidates;
+      for (std::map<unsigned, CodeProfile>::const_iterator
+             CI = Block.Codes.begin(), CE = Block.Codes.end(); CI != CE;
+           ++CI) {
+        Candidate C;
+        C.Abbrev.Code = CI->first;
+        C.Abbrev.Abbrev = selectAbbrev(CI->first, CI->second, C.Savings);
+        if (C.Savings > 0)
+          Candidates.push_back(C);
+        else
+          C.Abbrev.Abbrev->dropRef();
+      }
+      std::sort(Candidates.begin(), Candidates.end());
+
+      // A wider code leaves room for more abbreviations, but costs a bit for
+      // every code of the blocks.
+      int64_t BestGain = 0;
+      unsigned BestCodeLen = Block.CodeLen;
+      size_t BestCount = 0;
+      for (unsigned CodeLen = Block.CodeLen;
+           CodeLen <= Block.CodeLen + 2 && CodeLen <= 8; ++CodeLen) {
+        int64_t Slots = (int64_t)(1U << CodeLen) -
+                        bitc::FIRST_APPLICATION_ABBREV - Block.MaxAbbrevs;
+        size_t Count = (size_t)std::max(std::min(Slots,
+                                   (int64_t)Candidates.size()), (int64_t)0);
+        int64_t Gain = -(int64_t)((CodeLen - Block.CodeLen) * Block.NumCodes);
+        for (size_t i = 0; i != Count; ++i)
+          Gain += Candidates[i].Savings;
+        if (Gain > BestGain) {
+          BestGain = Gain;
+          BestCodeLen = CodeLen;
+          BestCount = Count;
+        }
+      }
+
+      if (BestCount) {
+        BlockAbbrevs Selected;
+        Selected.BlockID = BlockID;
+        Selected.CodeLen = BestCodeLen;
+        for (size_t i = 0; i != BestCount; ++i)
+          Selected.Abbrevs.push_back(Candidates[i].Abbrev);
+        Result.push_back(Selected);
+      }
+      for (size_t i = BestCount; i != Candidates.size(); ++i)
+        Candidates[i].Abbrev.Abbrev->dropRef();
+    }
+  }
+}
@@ -0,0 +1,175 @@
+//===------------------------- AbbrevProfile.h ---------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Selection of abbreviations fitted to the records of a module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SPIR_ABBREV_PROFILE_H
+#define SPIR_ABBREV_PROFILE_H
+
+#include "BitCodes.h"
+#include "llvm/ADT/SmallVector.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace SPIR
+{
+  /// Shapes of the unabbreviated records emitted in each block, from which
+  /// abbreviations fitted to a module are selected. A BitstreamWriter given
+  /// a profile fills it as the module is encoded.
+  class AbbrevProfile
+  {
+  public:
+    /// Number of leading record operands that may get an encoding of their
+    /// own in an abbreviation. The following operands are encoded as an
+    /// array.
+    static const unsigned MaxScalarOps = 6;
+
+    /// An abbreviation selected for the records with a given code.
+    struct RecordAbbrev
+    {
+      unsigned Code;
+      llvm::BitCodeAbbrev *Abbrev;
+    };
+
+    /// The abbreviations selected for the blocks with a given ID, and the
+    /// code width these blocks need to hold them.
+    struct BlockAbbrevs
+    {
+      unsigned BlockID;
+      unsigned CodeLen;
+      std::vector<RecordAbbrev> Abbrevs;
+    };
+
+    /// Add a block with the given ID, that used CodeLen bit codes and had
+    /// NumAbbrevs abbreviations when it was exited.
+    void addBlock(unsigned BlockID, unsigned CodeLen, unsigned NumAbbrevs);
+
+    /// Add a record emitted with an abbreviation in a block with the given
+    /// ID. Only its code is accounted for.
+    void addAbbreviatedRecord(unsigned BlockID)
+    {
+      ++Blocks[BlockID].NumCodes;
+    }
+
+    /// Add an unabbreviated record emitted in a block with the given ID.
+    template<typename uintty>
+    void addRecord(unsigned BlockID, unsigned Code,
+                   const llvm::SmallVectorImpl<uintty> &Vals)
+    {
+      BlockProfile &Block = Blocks[BlockID];
+      ++Block.NumCodes;
+      CodeProfile &Profile = Block.Codes[Code];
+      Profile.add(Code, Vals.begin(), Vals.end());
+    }
+
+    /// Select the abbreviations worth defining in the BLOCKINFO block for
+    /// each block ID, except the ones of the MODULE and BLOCKINFO blocks,
+    /// which are entered before BLOCKINFO is emitted. The caller owns the
+    /// returned abbreviations.
+    void selectAbbrevs(std::vector<BlockAbbrevs> &Result) const;
+
+    /// Number of bits of V when emitted as a VBR with Width bits chunks.
+    static uint64_t VBRBits(uint64_t V, unsigned Width);
+
+  private:
+    /// Number of distinct operand widths, from 0 to 64 bits.
+    static const unsigned NumWidths = 65;
+
+    /// Widths of the values of a set of operands.
+    struct WidthHistogram
+    {
+      WidthHistogram();
+      void add(uint64_t V);
+      void add(const WidthHistogram &Other);
+
+      uint64_t Count[NumWidths];
+      uint64_t NumValues;
+      unsigned MaxWidth;
+    };
+
+    /// Shapes of the unabbreviated records with a given code.
+    struct CodeProfile
+    {
+      CodeProfile();
+
+      template<typename IterTy>
+      void add(unsigned Code, IterTy Begin, IterTy End)
+      {
+        unsigned NumOps = (unsigned)(End - Begin);
+        if (!NumRecords++) {
+          MinOps = MaxOps = NumOps;
+          for (unsigned i = 0; i != MaxScalarOps && i != NumOps; ++i)
+            Literal[i] = Begin[i];
+        }
+        MinOps = std::min(MinOps, NumOps);
+        MaxOps = std::max(MaxOps, NumOps);
+
+        UnabbrevBits += VBRBits(Code, 6) + VBRBits(NumOps, 6);
+        for (unsigned i = 0; i != NumOps; ++i) {
+          uint64_t V = Begin[i];
+          UnabbrevBits += VBRBits(V, 6);
+          if (i < MaxScalarOps) {
+            Ops[i].add(V);
+            if (V != Literal[i])
+              NotLiteral[i] = true;
+          } else {
+            Rest.add(V);
+          }
+          if (V >= 256 || !llvm::BitCodeAbbrevOp::isChar6((char)V))
+            Char6From = std::max(Char6From, i + 1);
+        }
+        for (unsigned i = 0; i <= MaxScalarOps && i <= NumOps; ++i)
+          TailLengthBits[i] += VBRBits(NumOps - i, 6);
+      }
+
+      uint64_t NumRecords;
+      unsigned MinOps, MaxOps;
+      /// Bits of the records when emitted unabbreviated, without the code.
+      uint64_t UnabbrevBits;
+      /// Widths of the leading operands, and of the operands after them.
+      WidthHistogram Ops[MaxScalarOps];
+      WidthHistogram Rest;
+      /// Value of the leading operands in the first record, and whether the
+      /// operands of other records differ from it.
+      uint64_t Literal[MaxScalarOps];
+      bool NotLiteral[MaxScalarOps];
+      /// Bits of the array length of the records when their operands from
+      /// the i-th one on are encoded as an array.
+      uint64_t TailLengthBits[MaxScalarOps + 1];
+      /// Index of the first operand after which all operands of all records
+      /// are Char6 characters.
+      unsigned Char6From;
+    };
+
+    /// Records of the blocks with a given ID.
+    struct BlockProfile
+    {
+      BlockProfile() : CodeLen(0), MaxAbbrevs(0), NumCodes(0) {}
+
+      /// Smallest code width of the blocks.
+      unsigned CodeLen;
+      /// Largest number of abbreviations defined in one of the blocks.
+      unsigned MaxAbbrevs;
+      /// Number of codes emitted in the blocks.
+      uint64_t NumCodes;
+      std::map<unsigned, CodeProfile> Codes;
+    };
+
+    static llvm::BitCodeAbbrev *selectAbbrev(unsigned Code,
+                                             const CodeProfile &Profile,
+                                             int64_t &Savings);
+
+    std::map<unsigned, BlockProfile> Blocks;
+  };
+}
+
+#endif // SPIR_ABBREV_PROFILE_H
@@ -19,9 +19,11 @@
 #define LLVM_BITCODE_BITCODES_H
 
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/ErrorHandling.h"
 #include <cassert>
+#include <cstring>
 
 namespace llvm {
 namespace bitc {
@@ -153,6 +155,58 @@ public:
     llvm_unreachable("Not a value Char6 character!");
   }
 
+  /// StringClass - The most compact array element encoding that can hold
+  /// every character of a string.
+  enum StringClass {
+    Char6String,   // Every character isChar6.
+    Fixed7String,  // Every character fits in 7 bits.
+    Fixed8String
+  };
+
+  /// ClassifyString - Return the StringClass of Str. The characters are
+  /// tested eight at a time, as the bytes of a 64-bit word.
+  static StringClass ClassifyString(StringRef Str) {
+    const uint64_t HighBits = 0x8080808080808080ULL;
+    const char *P = Str.data(), *E = P + Str.size();
+    bool AllChar6 = true;
+    for (; E - P >= 8; P += 8) {
+      uint64_t Word;
+      memcpy(&Word, P, sizeof(Word));
+      if (Word & HighBits)
+        return Fixed8String;
+      if (AllChar6)
+        AllChar6 = (Char6Bytes(Word) == HighBits);
+    }
+    for (; P != E; ++P) {
+      if ((unsigned char)*P & 128)
+        return Fixed8String;
+      if (AllChar6)
+        AllChar6 = isChar6(*P);
+    }
+    return AllChar6 ? Char6String : Fixed7String;
+  }
+
+private:
+  /// BytesInRange - Set the high bit of each byte of Word, all of which must
+  /// be 7-bit, that lies in [Lo, Hi], and clear every other bit. No byte
+  /// carries into the next one, so the byte order of Word does not matter.
+  static uint64_t BytesInRange(uint64_t Word, unsigned char Lo,
+                               unsigned char Hi) {
+    const uint64_t Ones = 0x0101010101010101ULL;
+    uint64_t AtLeastLo = Word + Ones * (0x80 - Lo);
+    uint64_t AboveHi = Word + Ones * (0x7F - Hi);
+    return AtLeastLo & ~AboveHi & (Ones * 0x80);
+  }
+
+  /// Char6Bytes - Set the high bit of each byte of the 7-bit Word that
+  /// isChar6, and clear every other bit.
+  static uint64_t Char6Bytes(uint64_t Word) {
+    // Setting bit 5 folds the upper case letters onto the lower case ones,
+    // and nothing else onto them.
+    uint64_t Lower = Word | 0x2020202020202020ULL;
+    return BytesInRange(Lower, 'a', 'z') | BytesInRange(Word, '0', '9') |
+           BytesInRange(Word, '.', '.') | BytesInRange(Word, '_', '_');
+  }
 };
 
 template <> struct isPodLike<BitCodeAbbrevOp> { static const bool value=true; };
@@ -0,0 +1,942 @@
+//===- BitstreamWriter.h - Low-level bitstream writer interface -*- C++ -*-===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// This header defines the BitstreamWriter class.  This class can be used to
+// write an arbitrary bitstream, regardless of its contents.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef BITSTREAM_WRITER_H
+#define BITSTREAM_WRITER_H
+
+#include "AbbrevProfile.h"
+#include "BitCodes.h"
+#include "SpirEncoderStats.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstring>
+#include <vector>
+
+namespace llvm {
+
+class BitstreamWriter {
+  /// Out - The bitstream that has not been written to FS yet, or the whole
+  /// bitstream when the writer is not streaming.
+  SmallVectorImpl<char> &Out;
+
+  /// FS - When streaming, the file that completed blocks are flushed to once
+  /// Out grows past FlushThreshold bytes. Null otherwise.
+  raw_fd_ostream *FS;
+
+  /// FSStart - The offset in FS at which the bitstream starts.
+  uint64_t FSStart;
+
+  /// FlushedBytes - The number of bytes of the bitstream already written to
+  /// FS. Out holds the bytes that follow them.
+  uint64_t FlushedBytes;
+
+  /// FlushThreshold - The buffer size, in bytes, past which completed blocks
+  /// are flushed to FS.
+  size_t FlushThreshold;
+
+  /// CurBit - Always between 0 and 63 inclusive, specifies the next bit to use.
+  unsigned CurBit;
+
+  /// CurValue - The current value.  Only bits < CurBit are valid. Bits are
+  /// accumulated 64 at a time and stored with a single write.
+  uint64_t CurValue;
+
+  /// CurCodeSize - This is the declared size of code values used for the
+  /// current block, in bits.
+  unsigned CurCodeSize;
+
+  /// BlockInfoCurBID - When emitting a BLOCKINFO_BLOCK, this is the currently
+  /// selected BLOCK ID.
+  unsigned BlockInfoCurBID;
+
+  /// CurAbbrevs - Abbrevs installed at in this block.
+  std::vector<BitCodeAbbrev*> CurAbbrevs;
+
+  /// Stats - The statistics updated as blocks and records are emitted, or
+  /// null.
+  SPIR::EncoderStats *Stats;
+
+  /// Profile - The profile the unabbreviated records are added to, or null.
+  SPIR::AbbrevProfile *Profile;
+
+  struct Block {
+    unsigned PrevCodeSize;
+    unsigned StartSizeWord;
+    std::vector<BitCodeAbbrev*> PrevAbbrevs;
+    unsigned BlockID;
+    /// Index of the BlockInfoRecords entry of the block, ~0U if none.
+    unsigned InfoIdx;
+    /// The position and time at which the block was entered, and the bits
+    /// and time of its nested blocks. Only kept when collecting statistics.
+    uint64_t StartBit;
+    uint64_t NestedBits;
+    double StartTime;
+    double NestedTime;
+    Block(unsigned PCS, unsigned SSW, unsigned ID)
+      : PrevCodeSize(PCS), StartSizeWord(SSW), BlockID(ID), InfoIdx(~0U),
+        StartBit(0), NestedBits(0), StartTime(0), NestedTime(0) {}
+  };
+
+  /// BlockScope - This tracks the current blocks that we have entered.
+  std::vector<Block> BlockScope;
+
+  /// BlockInfo - This contains information emitted to BLOCKINFO_BLOCK blocks.
+  /// These describe abbreviations that all blocks of the specified ID inherit.
+  struct BlockInfo {
+    unsigned BlockID;
+    std::vector<BitCodeAbbrev*> Abbrevs;
+    /// RecordAbbrevs - The abbrev used for the unabbreviated records of each
+    /// code that fit it, 0 if none. See SetRecordAbbrev.
+    std::vector<unsigned> RecordAbbrevs;
+    /// MinCodeLen - The smallest code width of the blocks.
+    unsigned MinCodeLen;
+    BlockInfo() : BlockID(0), MinCodeLen(0) {}
+  };
+  std::vector<BlockInfo> BlockInfoRecords;
+
+  // BackpatchWord - Backpatch a 32-bit word in the output with the specified
+  // value.
+  void BackpatchWord(uint64_t ByteNo, unsigned NewWord) {
+    if (ByteNo < FlushedBytes) {
+      // The word has already been flushed, patch it in place in the file.
+      // Flushes happen at word boundaries, so it can't be split between the
+      // file and the buffer.
+      assert(ByteNo + 4 <= FlushedBytes && "Split backpatch word");
+      char Bytes[4] = {
+        (char)(NewWord >>  0),
+        (char)(NewWord >>  8),
+        (char)(NewWord >> 16),
+        (char)(NewWord >> 24) };
+      FS->seek(FSStart + ByteNo);
+      FS->write(Bytes, 4);
+      FS->seek(FSStart + FlushedBytes);
+      return;
+    }
+    size_t Idx = (size_t)(ByteNo - FlushedBytes);
+    Out[Idx++] = (unsigned char)(NewWord >>  0);
+    Out[Idx++] = (unsigned char)(NewWord >>  8);
+    Out[Idx++] = (unsigned char)(NewWord >> 16);
+    Out[Idx  ] = (unsigned char)(NewWord >> 24);
+  }
+
+  void WriteByte(unsigned char Value) {
+    Out.push_back(Value);
+  }
+
+  /// ReserveBytes - Make room for at least NumBytes more bytes in Out, so they
+  /// can be stored through a pointer.
+  void ReserveBytes(size_t NumBytes) {
+    if (Out.capacity() - Out.size() < NumBytes)
+      Out.reserve(Out.capacity() * 2 + NumBytes);
+  }
+
+  /// WriteLE - Append the NumBytes low bytes of Value in little endian order.
+  void WriteLE(uint64_t Value, unsigned NumBytes) {
+    ReserveBytes(8);
+    char *Ptr = Out.end();
+    if (sys::IsLittleEndianHost) {
+      memcpy(Ptr, &Value, 8);
+    } else {
+      for (unsigned i = 0; i != 8; ++i)
+        Ptr[i] = (char)(Value >> (i * 8));
+    }
+    Out.set_size(Out.size() + NumBytes);
+  }
+
+  void WriteWord(unsigned Value) {
+    WriteLE(Value, 4);
+  }
+
+  /// WriteBytesAligned - Append Len bytes from Data, then zero bytes up to the next
+  /// 32-bit boundary.
+  void WriteBytesAligned(const char *Data, size_t Len) {
+    Out.append(Data, Data + Len);
+    Out.append((size_t)((4 - (GetBufferOffset() & 3)) & 3), '\0');
+  }
+
+  /// CountRecord - Update the statistics of the current block for a record.
+  void CountRecord(bool Abbreviated) {
+    if (!Stats || BlockScope.empty())
+      return;
+    SPIR::BlockStats &S = Stats->Blocks[BlockScope.back().BlockID];
+    ++S.NumRecords;
+    if (Abbreviated)
+      ++S.NumAbbreviated;
+  }
+
+  uint64_t GetBufferOffset() const {
+    return FlushedBytes + Out.size();
+  }
+
+  unsigned GetWordIndex() const {
+    uint64_t Offset = GetBufferOffset();
+    assert((Offset & 3) == 0 && "Not 32-bit aligned");
+    return (unsigned)(Offset / 4);
+  }
+
+public:
+  explicit BitstreamWriter(SmallVectorImpl<char> &O)
+    : Out(O), FS(0), FSStart(0), FlushedBytes(0), FlushThreshold(0),
+      CurBit(0), CurValue(0), CurCodeSize(2), Stats(0), Profile(0) {}
+
+  /// BitstreamWriter - Create a streaming writer. The bitstream is built in
+  /// O, and whenever a block is exited with at least Threshold bytes
+  /// buffered, the buffer is written to F, which must support seeking. Block
+  /// size words that were already written are patched in place in F, so the
+  /// buffer only holds the blocks emitted since the last flush. Call
+  /// FlushToFile once the bitstream is complete.
+  BitstreamWriter(SmallVectorImpl<char> &O, raw_fd_ostream &F,
+                  size_t Threshold)
+    : Out(O), FS(&F), FSStart(F.tell()), FlushedBytes(0),
+      FlushThreshold(Threshold), CurBit(0), CurValue(0), CurCodeSize(2),
+      Stats(0), Profile(0) {
+    assert(F.supportsSeeking() && "Streaming needs a seekable stream");
+  }
+
+  ~BitstreamWriter() {
+    assert(CurBit == 0 && "Unflused data remaining");
+    assert(BlockScope.empty() && CurAbbrevs.empty() && "Block imbalance");
+
+    // Free the BlockInfoRecords.
+    while (!BlockInfoRecords.empty()) {
+      BlockInfo &Info = BlockInfoRecords.back();
+      // Free blockinfo abbrev info.
+      for (unsigned i = 0, e = static_cast<unsigned>(Info.Abbrevs.size());
+           i != e; ++i)
+        Info.Abbrevs[i]->dropRef();
+      BlockInfoRecords.pop_back();
+    }
+  }
+
+  /// \brief Retrieve the current position in the stream, in bits.
+  uint64_t GetCurrentBitNo() const { return GetBufferOffset() * 8 + CurBit; }
+
+  /// GetBufferedBytes - Return the bytes of the bitstream in [Start, End).
+  /// They must be complete and not flushed to a file yet.
+  StringRef GetBufferedBytes(uint64_t Start, uint64_t End) const {
+    assert(Start >= FlushedBytes && Start <= End &&
+           End <= GetBufferOffset() && "Bytes not in the buffer");
+    return StringRef(Out.data() + (size_t)(Start - FlushedBytes),
+                     (size_t)(End - Start));
+  }
+
+  /// SetStats - Collect statistics on the blocks emitted from now on into S,
+  /// or stop collecting them if S is null.
+  void SetStats(SPIR::EncoderStats *S) { Stats = S; }
+
+  SPIR::EncoderStats *GetStats() const { return Stats; }
+
+  /// SetAbbrevProfile - Add the shapes of the unabbreviated records emitted
+  /// from now on to P, or stop if P is null.
+  void SetAbbrevProfile(SPIR::AbbrevProfile *P) { Profile = P; }
+
+  SPIR::AbbrevProfile *GetAbbrevProfile() const { return Profile; }
+
+  /// GetTime - The wall time, in seconds.
+  static double GetTime() {
+    sys::TimeValue Now = sys::TimeValue::now();
+    return Now.seconds() + Now.nanoseconds() / 1e9;
+  }
+
+  /// FlushToFile - When streaming, write the buffered bitstream to the file.
+  /// The bitstream must be at a word boundary.
+  void FlushToFile() {
+    if (!FS || Out.empty())
+      return;
+    assert(CurBit == 0 && "Flushing a partial word");
+    FS->write(&Out.front(), Out.size());
+    FlushedBytes += Out.size();
+    Out.clear();
+  }
+
+  /// InitSplice - Prepare this empty writer to emit blocks that are spliced
+  /// into the current block of Parent with SpliceBlocks: copy the code size
+  /// of that block and the BLOCKINFO abbrevs, with their record codes.
+  /// Writers set up from the same parent share no state, so they can be used
+  /// on different threads; the statistics of Parent are not shared either.
+  void InitSplice(const BitstreamWriter &Parent) {
+    assert(GetBufferOffset() == 0 && CurBit == 0 && BlockScope.empty() &&
+           "Writer already in use");
+    CurCodeSize = Parent.CurCodeSize;
+    for (unsigned i = 0, e = static_cast<unsigned>(
+           Parent.BlockInfoRecords.size()); i != e; ++i) {
+      const BlockInfo &From = Parent.BlockInfoRecords[i];
+      BlockInfo &Info = getOrCreateBlockInfo(From.BlockID);
+      for (unsigned j = 0, je = static_cast<unsigned>(From.Abbrevs.size());
+           j != je; ++j) {
+        BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+        for (unsigned k = 0, ke = From.Abbrevs[j]->getNumOperandInfos();
+             k != ke; ++k)
+          Abbv->Add(From.Abbrevs[j]->getOperandInfo(k));
+        Info.Abbrevs.push_back(Abbv);
+      }
+      Info.RecordAbbrevs = From.RecordAbbrevs;
+      Info.MinCodeLen = From.MinCodeLen;
+    }
+  }
+
+  /// SpliceBlocks - Append complete blocks emitted by a writer set up with
+  /// InitSplice(*this). Blocks are position independent once they start at a
+  /// word boundary, so the stream must be word aligned. Seconds is the wall
+  /// time spent emitting the blocks, which the statistics count in the
+  /// spliced blocks rather than in the current one.
+  void SpliceBlocks(const SmallVectorImpl<char> &Blocks, double Seconds = 0) {
+    assert(CurBit % 32 == 0 && "Splicing at an unaligned position");
+    assert((Blocks.size() & 3) == 0 && "Incomplete blocks");
+    FlushToWord();
+    Out.append(Blocks.begin(), Blocks.end());
+    if (Stats && !BlockScope.empty()) {
+      BlockScope.back().NestedBits += Blocks.size() * 8;
+      BlockScope.back().NestedTime += Seconds;
+    }
+    if (FS && Out.size() >= FlushThreshold)
+      FlushToFile();
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Basic Primitives for emitting bits to the stream.
+  //===--------------------------------------------------------------------===//
+
+private:
+  /// EmitBits - Emit the NumBits (1 to 64) low bits of Val, the other bits
+  /// must be clear.
+  void EmitBits(uint64_t Val, unsigned NumBits) {
+    CurValue |= Val << CurBit;
+    if (CurBit + NumBits < 64) {
+      CurBit += NumBits;
+      return;
+    }
+
+    // Add the current two words.
+    WriteLE(CurValue, 8);
+
+    if (CurBit)
+      CurValue = Val >> (64-CurBit);
+    else
+      CurValue = 0;
+    CurBit = (CurBit+NumBits) & 63;
+  }
+
+public:
+  void Emit(uint32_t Val, unsigned NumBits) {
+    assert(NumBits && NumBits <= 32 && "Invalid value size!");
+    assert((Val & ~(~0U >> (32-NumBits))) == 0 && "High bits set!");
+    EmitBits(Val, NumBits);
+  }
+
+  void Emit64(uint64_t Val, unsigned NumBits) {
+    if (NumBits <= 32)
+      Emit((uint32_t)Val, NumBits);
+    else {
+      Emit((uint32_t)Val, 32);
+      Emit((uint32_t)(Val >> 32), NumBits-32);
+    }
+  }
+
+  void FlushToWord() {
+    if (CurBit) {
+      WriteLE(CurValue, CurBit > 32 ? 8 : 4);
+      CurBit = 0;
+      CurValue = 0;
+    }
+  }
+
+  void EmitVBR(uint32_t Val, unsigned NumBits) {
+    assert(NumBits > 1 && NumBits <= 32 && "Invalid VBR size!");
+    uint32_t Threshold = 1U << (NumBits-1);
+
+    // Most values fit in a single chunk.
+    if (Val < Threshold) {
+      EmitBits(Val, NumBits);
+      return;
+    }
+
+    // Build the VBR encoding, NumBits-1 bits at a time. A 32-bit value needs
+    // at most 64 bits for any chunk size, so it is emitted at once.
+    uint64_t Chunks = 0;
+    unsigned ChunksBits = 0;
+    while (Val >= Threshold) {
+      Chunks |= (uint64_t)((Val & (Threshold-1)) | Threshold) << ChunksBits;
+      ChunksBits += NumBits;
+      Val >>= NumBits-1;
+    }
+    Chunks |= (uint64_t)Val << ChunksBits;
+    EmitBits(Chunks, ChunksBits + NumBits);
+  }
+
+  void EmitVBR64(uint64_t Val, unsigned NumBits) {
+    assert(NumBits <= 32 && "Too many bits to emit!");
+    if ((uint32_t)Val == Val)
+      return EmitVBR((uint32_t)Val, NumBits);
+
+    uint32_t Threshold = 1U << (NumBits-1);
+
+    // Emit the bits with VBR encoding, NumBits-1 bits at a time.
+    while (Val >= Threshold) {
+      Emit(((uint32_t)Val & ((1 << (NumBits-1))-1)) |
+           (1 << (NumBits-1)), NumBits);
+      Val >>= NumBits-1;
+    }
+
+    Emit((uint32_t)Val, NumBits);
+  }
+
+  /// EmitCode - Emit the specified code.
+  void EmitCode(unsigned Val) {
+    Emit(Val, CurCodeSize);
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Block Manipulation
+  //===--------------------------------------------------------------------===//
+
+  /// getBlockInfo - If there is block info for the specified ID, return it,
+  /// otherwise return null.
+  BlockInfo *getBlockInfo(unsigned BlockID) {
+    // Common case, the most recent entry matches BlockID.
+    if (!BlockInfoRecords.empty() && BlockInfoRecords.back().BlockID == BlockID)
+      return &BlockInfoRecords.back();
+
+    for (unsigned i = 0, e = static_cast<unsigned>(BlockInfoRecords.size());
+         i != e; ++i)
+      if (BlockInfoRecords[i].BlockID == BlockID)
+        return &BlockInfoRecords[i];
+    return 0;
+  }
+
+  void EnterSubblock(unsigned BlockID, unsigned CodeLen) {
+    uint64_t StartBit = GetCurrentBitNo();
+    BlockInfo *Info = getBlockInfo(BlockID);
+    if (Info && Info->MinCodeLen > CodeLen)
+      CodeLen = Info->MinCodeLen;
+
+    // Block header:
+    //    [ENTER_SUBBLOCK, blockid, newcodelen, <align4bytes>, blocklen]
+    EmitCode(bitc::ENTER_SUBBLOCK);
+    EmitVBR(BlockID, bitc::BlockIDWidth);
+    EmitVBR(CodeLen, bitc::CodeLenWidth);
+    FlushToWord();
+
+    unsigned BlockSizeWordIndex = GetWordIndex();
+    unsigned OldCodeSize = CurCodeSize;
+
+    // Emit a placeholder, which will be replaced when the block is popped.
+    Emit(0, bitc::BlockSizeWidth);
+
+    CurCodeSize = CodeLen;
+
+    // Push the outer block's abbrev set onto the stack, start out with an
+    // empty abbrev set.
+    BlockScope.push_back(Block(OldCodeSize, BlockSizeWordIndex, BlockID));
+    BlockScope.back().PrevAbbrevs.swap(CurAbbrevs);
+    if (Stats) {
+      ++Stats->get(BlockID).NumBlocks;
+      BlockScope.back().StartBit = StartBit;
+      BlockScope.back().StartTime = GetTime();
+    }
+
+    // If there is a blockinfo for this BlockID, add all the predefined abbrevs
+    // to the abbrev list.
+    if (Info) {
+      BlockScope.back().InfoIdx =
+        static_cast<unsigned>(Info - &BlockInfoRecords[0]);
+      for (unsigned i = 0, e = static_cast<unsigned>(Info->Abbrevs.size());
+           i != e; ++i) {
+        CurAbbrevs.push_back(Info->Abbrevs[i]);
+        Info->Abbrevs[i]->addRef();
+      }
+    }
+  }
+
+  void ExitBlock() {
+    assert(!BlockScope.empty() && "Block scope imbalance!");
+
+    if (Profile)
+      Profile->addBlock(BlockScope.back().BlockID, CurCodeSize,
+                        static_cast<unsigned>(CurAbbrevs.size()));
+
+    // Delete all abbrevs.
+    for (unsigned i = 0, e = static_cast<unsigned>(CurAbbrevs.size());
+         i != e; ++i)
+      CurAbbrevs[i]->dropRef();
+
+    const Block &B = BlockScope.back();
+
+    // Block tail:
+    //    [END_BLOCK, <align4bytes>]
+    EmitCode(bitc::END_BLOCK);
+    FlushToWord();
+
+    // Compute the size of the block, in words, not counting the size field.
+    unsigned SizeInWords = GetWordIndex() - B.StartSizeWord - 1;
+    uint64_t ByteNo = (uint64_t)B.StartSizeWord*4;
+
+    // Update the block size field in the header of this sub-block.
+    BackpatchWord(ByteNo, SizeInWords);
+
+    if (Stats) {
+      // Count the bits and time of this block without its nested blocks,
+      // which are counted in the enclosing block.
+      uint64_t Bits = GetCurrentBitNo() - B.StartBit;
+      double Time = GetTime() - B.StartTime;
+      SPIR::BlockStats &S = Stats->Blocks[B.BlockID];
+      S.NumBits += Bits - B.NestedBits;
+      S.Seconds += Time - B.NestedTime;
+      if (BlockScope.size() > 1) {
+        Block &Parent = BlockScope[BlockScope.size() - 2];
+        Parent.NestedBits += Bits;
+        Parent.NestedTime += Time;
+      }
+    }
+
+    // Restore the inner block's code size and abbrev table.
+    CurCodeSize = B.PrevCodeSize;
+    BlockScope.back().PrevAbbrevs.swap(CurAbbrevs);
+    BlockScope.pop_back();
+
+    // The block is complete, write it out if enough has been buffered.
+    if (FS && Out.size() >= FlushThreshold)
+      FlushToFile();
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Record Emission
+  //===--------------------------------------------------------------------===//
+
+private:
+  /// EmitAbbreviatedLiteral - Emit a literal value according to its abbrev
+  /// record.  This is a no-op, since the abbrev specifies the literal to use.
+  template<typename uintty>
+  void EmitAbbreviatedLiteral(const BitCodeAbbrevOp &Op, uintty V) {
+    assert(Op.isLiteral() && "Not a literal");
+    // If the abbrev specifies the literal value to use, don't emit
+    // anything.
+    assert(V == Op.getLiteralValue() &&
+           "Invalid abbrev for record!");
+  }
+
+  /// EmitAbbreviatedField - Emit a single scalar field value with the specified
+  /// encoding.
+  template<typename uintty>
+  void EmitAbbreviatedField(const BitCodeAbbrevOp &Op, uintty V) {
+    assert(!Op.isLiteral() && "Literals should use EmitAbbreviatedLiteral!");
+
+    // Encode the value as we are commanded.
+    switch (Op.getEncoding()) {
+    default: llvm_unreachable("Unknown encoding!");
+    case BitCodeAbbrevOp::Fixed:
+      if (Op.getEncodingData())
+        Emit((unsigned)V, (unsigned)Op.getEncodingData());
+      break;
+    case BitCodeAbbrevOp::VBR:
+      if (Op.getEncodingData())
+        EmitVBR64(V, (unsigned)Op.getEncodingData());
+      break;
+    case BitCodeAbbrevOp::Char6:
+      Emit(BitCodeAbbrevOp::EncodeChar6((char)V), 6);
+      break;
+    }
+  }
+
+  /// EmitPackedArray - Emit the array elements in [I, E) with a fixed width
+  /// (Char6 when IsChar6) encoding, packing as many elements as fit into a
+  /// single 64-bit emission.
+  template<typename IterTy>
+  void EmitPackedArray(IterTy I, IterTy E, unsigned Width, bool IsChar6) {
+    if (!Width)
+      return;
+    assert(Width <= 32 && "Invalid value size!");
+    uint64_t Chunk = 0;
+    unsigned ChunkBits = 0;
+    for (; I != E; ++I) {
+      uint64_t V = IsChar6 ? BitCodeAbbrevOp::EncodeChar6((char)*I)
+                           : (uint64_t)*I;
+      assert((V >> Width) == 0 && "High bits set!");
+      if (ChunkBits + Width > 64) {
+        EmitBits(Chunk, ChunkBits);
+        Chunk = 0;
+        ChunkBits = 0;
+      }
+      Chunk |= V << ChunkBits;
+      ChunkBits += Width;
+    }
+    if (ChunkBits)
+      EmitBits(Chunk, ChunkBits);
+  }
+
+  /// EmitArrayElements - Emit the array elements in [I, E) with the specified
+  /// element encoding.
+  template<typename IterTy>
+  void EmitArrayElements(const BitCodeAbbrevOp &EltEnc, IterTy I, IterTy E) {
+    if (EltEnc.getEncoding() == BitCodeAbbrevOp::Fixed)
+      return EmitPackedArray(I, E, (unsigned)EltEnc.getEncodingData(), false);
+    if (EltEnc.getEncoding() == BitCodeAbbrevOp::Char6)
+      return EmitPackedArray(I, E, 6, true);
+    for (; I != E; ++I)
+      EmitAbbreviatedField(EltEnc, *I);
+  }
+
+  /// EmitRecordWithAbbrevImpl - This is the core implementation of the record
+  /// emission code.  If BlobData is non-null, then it specifies an array of
+  /// data that should be emitted as part of the Blob or Array operand that is
+  /// known to exist at the end of the record.
+  template<typename uintty>
+  void EmitRecordWithAbbrevImpl(unsigned Abbrev, SmallVectorImpl<uintty> &Vals,
+                                StringRef Blob) {
+    const char *BlobData = Blob.data();
+    unsigned BlobLen = (unsigned) Blob.size();
+    unsigned AbbrevNo = Abbrev-bitc::FIRST_APPLICATION_ABBREV;
+    assert(AbbrevNo < CurAbbrevs.size() && "Invalid abbrev #!");
+    BitCodeAbbrev *Abbv = CurAbbrevs[AbbrevNo];
+
+    CountRecord(true);
+    if (Profile && !BlockScope.empty())
+      Profile->addAbbreviatedRecord(BlockScope.back().BlockID);
+    EmitCode(Abbrev);
+
+    unsigned RecordIdx = 0;
+    for (unsigned i = 0, e = static_cast<unsigned>(Abbv->getNumOperandInfos());
+         i != e; ++i) {
+      const BitCodeAbbrevOp &Op = Abbv->getOperandInfo(i);
+      if (Op.isLiteral()) {
+        assert(RecordIdx < Vals.size() && "Invalid abbrev/record");
+        EmitAbbreviatedLiteral(Op, Vals[RecordIdx]);
+        ++RecordIdx;
+      } else if (Op.getEncoding() == BitCodeAbbrevOp::Array) {
+        // Array case.
+        assert(i+2 == e && "array op not second to last?");
+        const BitCodeAbbrevOp &EltEnc = Abbv->getOperandInfo(++i);
+
+        // If this record has blob data, emit it, otherwise we must have record
+        // entries to encode this way.
+        if (BlobData) {
+          assert(RecordIdx == Vals.size() &&
+                 "Blob data and record entries specified for array!");
+          // Emit a vbr6 to indicate the number of elements present.
+          EmitVBR(static_cast<uint32_t>(BlobLen), 6);
+
+          // Emit each field.
+          const unsigned char *Data = (const unsigned char *)BlobData;
+          EmitArrayElements(EltEnc, Data, Data + BlobLen);
+
+          // Know that blob data is consumed for assertion below.
+          BlobData = 0;
+        } else {
+          // Emit a vbr6 to indicate the number of elements present.
+          EmitVBR(static_cast<uint32_t>(Vals.size()-RecordIdx), 6);
+
+          // Emit each field.
+          EmitArrayElements(EltEnc, Vals.begin() + RecordIdx, Vals.end());
+          RecordIdx = Vals.size();
+        }
+      } else if (Op.getEncoding() == BitCodeAbbrevOp::Blob) {
+        // If this record has blob data, emit it, otherwise we must have record
+        // entries to encode this way.
+
+        // Emit a vbr6 to indicate the number of elements present.
+        if (BlobData) {
+          EmitVBR(static_cast<uint32_t>(BlobLen), 6);
+          assert(RecordIdx == Vals.size() &&
+                 "Blob data and record entries specified for blob operand!");
+        } else {
+          EmitVBR(static_cast<uint32_t>(Vals.size()-RecordIdx), 6);
+        }
+        
+        // Flush to a 32-bit alignment boundary.
+        FlushToWord();
+
+        // Emit each field as a literal byte.
+        if (BlobData) {
+          WriteBytesAligned(BlobData, BlobLen);
+
+          // Know that blob data is consumed for assertion below.
+          BlobData = 0;
+        } else {
+          for (unsigned e = Vals.size(); RecordIdx != e; ++RecordIdx) {
+            assert(Vals[RecordIdx] < 256 && "Value too large to emit as blob");
+            WriteByte((unsigned char)Vals[RecordIdx]);
+          }
+
+          // Align end to 32-bits.
+          while (GetBufferOffset() & 3)
+            WriteByte(0);
+        }
+      } else {  // Single scalar field.
+        assert(RecordIdx < Vals.size() && "Invalid abbrev/record");
+        EmitAbbreviatedField(Op, Vals[RecordIdx]);
+        ++RecordIdx;
+      }
+    }
+    assert(RecordIdx == Vals.size() && "Not all record operands emitted!");
+    assert(BlobData == 0 &&
+           "Blob data specified for record that doesn't use it!");
+  }
+
+  /// GetRecordAbbrev - Return the abbrev set with SetRecordAbbrev for the
+  /// records with the given code in the current block, 0 if none.
+  unsigned GetRecordAbbrev(unsigned Code) const {
+    if (BlockScope.empty() || BlockScope.back().InfoIdx == ~0U)
+      return 0;
+    const std::vector<unsigned> &RecordAbbrevs =
+      BlockInfoRecords[BlockScope.back().InfoIdx].RecordAbbrevs;
+    return Code < RecordAbbrevs.size() ? RecordAbbrevs[Code] : 0;
+  }
+
+  /// FitsAbbrevOp - Return true if V can be emitted with the given scalar
+  /// operand or array element encoding.
+  static bool FitsAbbrevOp(const BitCodeAbbrevOp &Op, uint64_t V) {
+    if (Op.isLiteral())
+      return V == Op.getLiteralValue();
+    switch (Op.getEncoding()) {
+    case BitCodeAbbrevOp::Fixed:
+      return (V >> Op.getEncodingData()) == 0;
+    case BitCodeAbbrevOp::VBR:
+      return true;
+    case BitCodeAbbrevOp::Char6:
+      return V < 256 && BitCodeAbbrevOp::isChar6((char)V);
+    default:
+      return false;
+    }
+  }
+
+  /// EmitRecordWithCodeAbbrev - Emit a record of the given code with Abbrev,
+  /// an abbrev starting with the literal code and made of scalar operands
+  /// and an optional array. Return false without emitting anything if the
+  /// operands don't fit the abbrev.
+  template<typename uintty>
+  bool EmitRecordWithCodeAbbrev(unsigned Abbrev, unsigned Code,
+                                const SmallVectorImpl<uintty> &Vals) {
+    const BitCodeAbbrev *Abbv =
+      CurAbbrevs[Abbrev - bitc::FIRST_APPLICATION_ABBREV];
+    unsigned NumOps = Abbv->getNumOperandInfos();
+    assert(Abbv->getOperandInfo(0).isLiteral() &&
+           Abbv->getOperandInfo(0).getLiteralValue() == Code &&
+           "Abbrev doesn't match the record code");
+    (void)Code;
+
+    // Check that all the operands fit first.
+    size_t Idx = 0;
+    for (unsigned i = 1; i != NumOps; ++i) {
+      const BitCodeAbbrevOp &Op = Abbv->getOperandInfo(i);
+      if (Op.isEncoding() && Op.getEncoding() == BitCodeAbbrevOp::Array) {
+        const BitCodeAbbrevOp &EltEnc = Abbv->getOperandInfo(i + 1);
+        for (; Idx != Vals.size(); ++Idx)
+          if (!FitsAbbrevOp(EltEnc, Vals[Idx]))
+            return false;
+        break;
+      }
+      if (Idx == Vals.size() || !FitsAbbrevOp(Op, Vals[Idx]))
+        return false;
+      ++Idx;
+    }
+    if (Idx != Vals.size())
+      return false;
+
+    EmitCode(Abbrev);
+    Idx = 0;
+    for (unsigned i = 1; i != NumOps; ++i) {
+      const BitCodeAbbrevOp &Op = Abbv->getOperandInfo(i);
+      if (Op.isLiteral()) {
+        ++Idx;
+      } else if (Op.getEncoding() == BitCodeAbbrevOp::Array) {
+        EmitVBR(static_cast<uint32_t>(Vals.size() - Idx), 6);
+        EmitArrayElements(Abbv->getOperandInfo(i + 1), Vals.begin() + Idx,
+                          Vals.end());
+        break;
+      } else {
+        EmitAbbreviatedField(Op, Vals[Idx++]);
+      }
+    }
+    return true;
+  }
+
+public:
+
+  /// EmitRecord - Emit the specified record to the stream, using an abbrev if
+  /// we have one to compress the output.
+  template<typename uintty>
+  void EmitRecord(unsigned Code, SmallVectorImpl<uintty> &Vals,
+                  unsigned Abbrev = 0) {
+    if (!Abbrev) {
+      if (Profile && !BlockScope.empty()) {
+        Profile->addRecord(BlockScope.back().BlockID, Code, Vals);
+      } else if (unsigned CodeAbbrev = GetRecordAbbrev(Code)) {
+        // Use the abbrev selected for the records of this code if they fit.
+        if (EmitRecordWithCodeAbbrev(CodeAbbrev, Code, Vals)) {
+          CountRecord(true);
+          return;
+        }
+      }
+
+      // If we don't have an abbrev to use, emit this in its fully unabbreviated
+      // form.
+      CountRecord(false);
+      EmitCode(bitc::UNABBREV_RECORD);
+      EmitVBR(Code, 6);
+      EmitVBR(static_cast<uint32_t>(Vals.size()), 6);
+      for (unsigned i = 0, e = static_cast<unsigned>(Vals.size()); i != e; ++i)
+        EmitVBR64(Vals[i], 6);
+      return;
+    }
+
+    // Insert the code into Vals to treat it uniformly.
+    Vals.insert(Vals.begin(), Code);
+
+    EmitRecordWithAbbrev(Abbrev, Vals);
+  }
+
+  /// EmitRecordWithAbbrev - Emit a record with the specified abbreviation.
+  /// Unlike EmitRecord, the code for the record should be included in Vals as
+  /// the first entry.
+  template<typename uintty>
+  void EmitRecordWithAbbrev(unsigned Abbrev, SmallVectorImpl<uintty> &Vals) {
+    EmitRecordWithAbbrevImpl(Abbrev, Vals, StringRef());
+  }
+
+  /// EmitRecordWithBlob - Emit the specified record to the stream, using an
+  /// abbrev that includes a blob at the end.  The blob data to emit is
+  /// specified by the pointer and length specified at the end.  In contrast to
+  /// EmitRecord, this routine expects that the first entry in Vals is the code
+  /// of the record.
+  template<typename uintty>
+  void EmitRecordWithBlob(unsigned Abbrev, SmallVectorImpl<uintty> &Vals,
+                          StringRef Blob) {
+    EmitRecordWithAbbrevImpl(Abbrev, Vals, Blob);
+  }
+  template<typename uintty>
+  void EmitRecordWithBlob(unsigned Abbrev, SmallVectorImpl<uintty> &Vals,
+                          const char *BlobData, unsigned BlobLen) {
+    return EmitRecordWithAbbrevImpl(Abbrev, Vals, StringRef(BlobData, BlobLen));
+  }
+
+  /// EmitRecordWithArray - Just like EmitRecordWithBlob, works with records
+  /// that end with an array.
+  template<typename uintty>
+  void EmitRecordWithArray(unsigned Abbrev, SmallVectorImpl<uintty> &Vals,
+                          StringRef Array) {
+    EmitRecordWithAbbrevImpl(Abbrev, Vals, Array);
+  }
+  template<typename uintty>
+  void EmitRecordWithArray(unsigned Abbrev, SmallVectorImpl<uintty> &Vals,
+                          const char *ArrayData, unsigned ArrayLen) {
+    return EmitRecordWithAbbrevImpl(Abbrev, Vals, StringRef(ArrayData, 
+                                                            ArrayLen));
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Abbrev Emission
+  //===--------------------------------------------------------------------===//
+
+private:
+  // Emit the abbreviation as a DEFINE_ABBREV record.
+  void EncodeAbbrev(BitCodeAbbrev *Abbv) {
+    EmitCode(bitc::DEFINE_ABBREV);
+    EmitVBR(Abbv->getNumOperandInfos(), 5);
+    for (unsigned i = 0, e = static_cast<unsigned>(Abbv->getNumOperandInfos());
+         i != e; ++i) {
+      const BitCodeAbbrevOp &Op = Abbv->getOperandInfo(i);
+      Emit(Op.isLiteral(), 1);
+      if (Op.isLiteral()) {
+        EmitVBR64(Op.getLiteralValue(), 8);
+      } else {
+        Emit(Op.getEncoding(), 3);
+        if (Op.hasEncodingData())
+          EmitVBR64(Op.getEncodingData(), 5);
+      }
+    }
+  }
+public:
+
+  /// EmitAbbrev - This emits an abbreviation to the stream.  Note that this
+  /// method takes ownership of the specified abbrev.
+  unsigned EmitAbbrev(BitCodeAbbrev *Abbv) {
+    // Emit the abbreviation as a record.
+    EncodeAbbrev(Abbv);
+    CurAbbrevs.push_back(Abbv);
+    return static_cast<unsigned>(CurAbbrevs.size())-1 +
+      bitc::FIRST_APPLICATION_ABBREV;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // BlockInfo Block Emission
+  //===--------------------------------------------------------------------===//
+
+  /// EnterBlockInfoBlock - Start emitting the BLOCKINFO_BLOCK.
+  void EnterBlockInfoBlock(unsigned CodeWidth) {
+    EnterSubblock(bitc::BLOCKINFO_BLOCK_ID, CodeWidth);
+    BlockInfoCurBID = ~0U;
+  }
+private:
+  /// SwitchToBlockID - If we aren't already talking about the specified block
+  /// ID, emit a BLOCKINFO_CODE_SETBID record.
+  void SwitchToBlockID(unsigned BlockID) {
+    if (BlockInfoCurBID == BlockID) return;
+    SmallVector<unsigned, 2> V;
+    V.push_back(BlockID);
+    EmitRecord(bitc::BLOCKINFO_CODE_SETBID, V);
+    BlockInfoCurBID = BlockID;
+  }
+
+  BlockInfo &getOrCreateBlockInfo(unsigned BlockID) {
+    if (BlockInfo *BI = getBlockInfo(BlockID))
+      return *BI;
+
+    // Otherwise, add a new record.
+    BlockInfoRecords.push_back(BlockInfo());
+    BlockInfoRecords.back().BlockID = BlockID;
+    return BlockInfoRecords.back();
+  }
+
+public:
+
+  /// EmitBlockInfoAbbrev - Emit a DEFINE_ABBREV record for the specified
+  /// BlockID.
+  unsigned EmitBlockInfoAbbrev(unsigned BlockID, BitCodeAbbrev *Abbv) {
+    SwitchToBlockID(BlockID);
+    EncodeAbbrev(Abbv);
+
+    // Add the abbrev to the specified block record.
+    BlockInfo &Info = getOrCreateBlockInfo(BlockID);
+    Info.Abbrevs.push_back(Abbv);
+
+    return Info.Abbrevs.size()-1+bitc::FIRST_APPLICATION_ABBREV;
+  }
+
+  /// SetRecordAbbrev - Emit the records with the given code that are passed
+  /// to EmitRecord without an abbrev with the BLOCKINFO abbrev AbbrevID of
+  /// BlockID, when they fit it. The abbrev must start with the literal code,
+  /// followed by scalar operands and an optional array. Only applies to the
+  /// blocks entered afterwards.
+  void SetRecordAbbrev(unsigned BlockID, unsigned Code, unsigned AbbrevID) {
+    std::vector<unsigned> &RecordAbbrevs =
+      getOrCreateBlockInfo(BlockID).RecordAbbrevs;
+    if (Code >= RecordAbbrevs.size())
+      RecordAbbrevs.resize(Code + 1, 0);
+    RecordAbbrevs[Code] = AbbrevID;
+  }
+
+  /// SetMinCodeLen - Use codes of at least CodeLen bits in the blocks of
+  /// BlockID entered afterwards, to leave room for their BLOCKINFO abbrevs.
+  void SetMinCodeLen(unsigned BlockID, unsigned CodeLen) {
+    getOrCreateBlockInfo(BlockID).MinCodeLen = CodeLen;
+  }
+};
+
+
+} // End llvm namespace
+
+#endif
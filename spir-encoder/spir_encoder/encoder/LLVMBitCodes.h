@@ -320,8 +320,12 @@ namespace bitc {
                                      //         ordering, synchscope]
   };
 
+  // The LLVM 3.2 reader keeps USELIST_CODE_ENTRY records without applying
+  // them, and skips other codes. The records use the layout LLVM adopted
+  // later for USELIST_CODE_DEFAULT and USELIST_CODE_BB.
   enum UseListCodes {
-    USELIST_CODE_ENTRY = 1   // USELIST_CODE_ENTRY: TBD.
+    USELIST_CODE_ENTRY = 1,  // USELIST_CODE_ENTRY: [index..., value-id]
+    USELIST_CODE_BB    = 2   // USELIST_CODE_BB:    [index..., bb-id]
   };
 } // End bitc namespace
 } // End llvm namespace
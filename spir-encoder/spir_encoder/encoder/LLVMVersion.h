@@ -0,0 +1,32 @@
+//===-------------------------- LLVMVersion.h ----------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Version of the LLVM tree the encoder is built in, from the LLVM_VER_MAJOR
+// and LLVM_VER_MINOR definitions set by the build. Code that depends on the
+// LLVM API version tests LLVM_VERSION against 3400 (LLVM 3.4) or 3500
+// (LLVM 3.5).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SPIR_ENCODER_LLVM_VERSION_H
+#define SPIR_ENCODER_LLVM_VERSION_H
+
+#if !defined(LLVM_VER_MAJOR) || !defined(LLVM_VER_MINOR)
+  #error("LLVM_VER_MAJOR and LLVM_VER_MINOR must be defined")
+#endif
+
+#if (LLVM_VER_MAJOR == 3) && (LLVM_VER_MINOR == 4)
+  #define LLVM_VERSION 3400
+#elif (LLVM_VER_MAJOR == 3) && (LLVM_VER_MINOR == 5)
+  #define LLVM_VERSION 3500
+#else
+  #error("unsupported LLVM version")
+#endif
+
+#endif // SPIR_ENCODER_LLVM_VERSION_H
@@ -9,14 +9,22 @@
 //
 // Bitcode writer implementation (LLVM 3.2).
 //
-// Modified to accept and down-encode a module from LLVM 3.5.
+// Modified to accept and down-encode a module from LLVM 3.4 or 3.5.
 //
 //===----------------------------------------------------------------------===//
 
+#include "AbbrevProfile.h"
 #include "BitstreamWriter.h"
 #include "LLVMBitCodes.h"
+#include "LLVMVersion.h"
+#include "SpirBitcodeWriter.h"
+#include "SpirEncoderStats.h"
+#include "SpirThreading.h"
 #include "ValueEnumerator.h"
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/Constants.h"
@@ -29,11 +37,14 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Program.h"
 
+#include <algorithm>
 #include <cctype>
 #include <map>
+
 using namespace llvm;
 
 #define SPIR32_DATALAYOUT                                         \
@@ -49,9 +60,51 @@ using namespace llvm;
 
 static cl::opt<bool>
 EnablePreserveUseListOrdering("enable-bc-uselist-preserve",
-                              cl::desc("Turn on experimental support for "
-                                       "use-list order preservation."),
-                              cl::init(false), cl::Hidden);
+                              cl::desc("Write the order of the use-lists of "
+                                       "values, so that readers can restore "
+                                       "it"),
+                              cl::init(false));
+
+static cl::opt<unsigned>
+EncoderThreads("spir-encoder-threads",
+               cl::desc("Number of threads encoding function bodies, 0 for "
+                        "one per hardware thread (default = 1)"),
+               cl::init(1));
+
+static cl::opt<bool>
+ProfileAbbrevs("spir-encoder-profile-abbrevs",
+               cl::desc("Encode each module twice, to define abbreviations "
+                        "fitted to its most frequent records"),
+               cl::init(false));
+
+static cl::opt<bool>
+DeterministicOutput("spir-encoder-deterministic",
+                    cl::desc("Write the value symbol tables in value order, "
+                             "so that the output only depends on the module "
+                             "and not on the layout of its hash tables"),
+                    cl::init(false));
+
+static cl::opt<bool>
+EmitModuleHash("spir-encoder-module-hash",
+               cl::desc("Add the MD5 hash of the module block in a block "
+                        "that readers skip, for caches to key on (implies "
+                        "-spir-encoder-deterministic)"),
+               cl::init(false));
+
+static cl::opt<bool>
+CompactConstants("spir-encoder-compact-constants",
+                 cl::desc("Write the integer and floating point arrays and "
+                          "vectors of the module constants as fixed width "
+                          "arrays when that is smaller"),
+                 cl::init(false));
+
+/// Size of the bitstream buffered by WriteBitcodeToFile_SPIR when streaming,
+/// completed blocks are written to the file once the buffer grows past it.
+static cl::opt<unsigned>
+StreamFlushThreshold("spir-encoder-stream-threshold", cl::Hidden,
+                     cl::desc("Bytes buffered before the completed blocks "
+                              "are written to the output file"),
+                     cl::init(1024*1024));
 
 /// These are manifest constants used by the bitcode writer. They do not need to
 /// be kept in sync with the reader, but need to be consistent within this file.
@@ -163,17 +216,19 @@ static unsigned GetEncodedSynchScope(SynchronizationScope SynchScope) {
 
 static void WriteStringRecord(unsigned Code, StringRef Str,
                               unsigned AbbrevToUse, BitstreamWriter &Stream) {
-  SmallVector<unsigned, 64> Vals;
-
   // Code: [strchar x N]
-  for (unsigned i = 0, e = Str.size(); i != e; ++i) {
-    if (AbbrevToUse && !BitCodeAbbrevOp::isChar6(Str[i]))
-      AbbrevToUse = 0;
-    Vals.push_back(Str[i]);
+  // AbbrevToUse ends with a Char6 array; the characters go to the stream
+  // straight from Str when they all fit it.
+  if (AbbrevToUse &&
+      BitCodeAbbrevOp::ClassifyString(Str) == BitCodeAbbrevOp::Char6String) {
+    SmallVector<unsigned, 1> Vals(1, Code);
+    Stream.EmitRecordWithArray(AbbrevToUse, Vals, Str);
+    return;
   }
 
   // Emit the finished record.
-  Stream.EmitRecord(Code, Vals, AbbrevToUse);
+  SmallVector<unsigned, 64> Vals(Str.begin(), Str.end());
+  Stream.EmitRecord(Code, Vals, 0);
 }
 
 // Emit information about parameter attributes.
@@ -375,12 +430,20 @@ static unsigned getEncodedLinkage(const GlobalValue *GV) {
   case GlobalValue::AppendingLinkage:                return 2;
   case GlobalValue::InternalLinkage:                 return 3;
   case GlobalValue::LinkOnceAnyLinkage:              return 4;
+#if LLVM_VERSION < 3500
+  case GlobalValue::DLLImportLinkage:                return 5;
+  case GlobalValue::DLLExportLinkage:                return 6;
+#endif
   case GlobalValue::ExternalWeakLinkage:             return 7;
   case GlobalValue::CommonLinkage:                   return 8;
   case GlobalValue::PrivateLinkage:                  return 9;
   case GlobalValue::WeakODRLinkage:                  return 10;
   case GlobalValue::LinkOnceODRLinkage:              return 11;
   case GlobalValue::AvailableExternallyLinkage:      return 12;
+#if LLVM_VERSION < 3500
+  case GlobalValue::LinkerPrivateLinkage:            return 13;
+  case GlobalValue::LinkerPrivateWeakLinkage:        return 14;
+#endif
   }
   llvm_unreachable("Invalid linkage");
 }
@@ -413,6 +476,12 @@ static void WriteModuleInfo(const Module *M, const ValueEnumerator &VE,
   if (!M->getTargetTriple().empty())
     WriteStringRecord(bitc::MODULE_CODE_TRIPLE, M->getTargetTriple(),
                       0/*TODO*/, Stream);
+#if LLVM_VERSION < 3500
+  // LLVM 3.4 keeps the data layout string as given, in the 3.2 syntax.
+  if (!M->getDataLayout().empty())
+    WriteStringRecord(bitc::MODULE_CODE_DATALAYOUT, M->getDataLayout(),
+                      0/*TODO*/, Stream);
+#else
   if (!M->getDataLayoutStr().empty())
   {
     if (M->getTargetTriple().compare(0, 4, "spir") == 0)
@@ -433,6 +502,7 @@ static void WriteModuleInfo(const Module *M, const ValueEnumerator &VE,
                         0/*TODO*/, Stream);
     }
   }
+#endif
   if (!M->getModuleInlineAsm().empty())
     WriteStringRecord(bitc::MODULE_CODE_ASM, M->getModuleInlineAsm(),
                       0/*TODO*/, Stream);
@@ -588,10 +658,76 @@ static uint64_t GetOptimizationFlags(const Value *V) {
   return Flags;
 }
 
+namespace {
+/// MetadataAbbrevs - The abbreviations of the module metadata block. The
+/// function metadata blocks have none.
+struct MetadataAbbrevs {
+  /// METADATA_STRING with 8-bit and char6 characters.
+  unsigned String8Abbrev, String6Abbrev;
+  /// METADATA_NODE with VBR6 and fixed width operands.
+  unsigned NodeVBRAbbrev, NodeFixedAbbrev;
+  /// Width of the operands of NodeFixedAbbrev.
+  unsigned NodeWidth;
+};
+}
+
+/// EnterModuleMetadataBlock - Enter the module metadata block and define its
+/// abbreviations.
+static void EnterModuleMetadataBlock(const ValueEnumerator &VE,
+                                     BitstreamWriter &Stream,
+                                     MetadataAbbrevs &Abbrevs) {
+  Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, 3);
+
+  // Abbrevs for METADATA_STRING: [strchar x N].
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_STRING));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
+  Abbrevs.String8Abbrev = Stream.EmitAbbrev(Abbv);
+
+  Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_STRING));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Char6));
+  Abbrevs.String6Abbrev = Stream.EmitAbbrev(Abbv);
+
+  // Abbrevs for METADATA_NODE: [n x (type num, value num)]. The operands of
+  // the kernel argument info nodes are mostly strings and small constants,
+  // whose numbers fit VBR6. The fixed width abbrev holds any type, value or
+  // metadata number of the module, for the nodes referring to later ones.
+  Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_NODE));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+  Abbrevs.NodeVBRAbbrev = Stream.EmitAbbrev(Abbv);
+
+  size_t NumIDs = std::max(VE.getTypes().size(),
+                           std::max(VE.getValues().size(),
+                                    VE.getMDValues().size()));
+  Abbrevs.NodeWidth = std::max(Log2_32_Ceil((uint32_t)NumIDs), 1U);
+  Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_NODE));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, Abbrevs.NodeWidth));
+  Abbrevs.NodeFixedAbbrev = Stream.EmitAbbrev(Abbv);
+}
+
+/// GetMDNodeAbbrev - Return the smaller of the METADATA_NODE abbrevs for the
+/// operands in Record.
+static unsigned GetMDNodeAbbrev(const SmallVectorImpl<uint64_t> &Record,
+                                const MetadataAbbrevs &Abbrevs) {
+  uint64_t VBRBits = 0;
+  for (unsigned i = 0, e = Record.size(); i != e; ++i)
+    VBRBits += SPIR::AbbrevProfile::VBRBits(Record[i], 6);
+  uint64_t FixedBits = (uint64_t)Record.size() * Abbrevs.NodeWidth;
+  return FixedBits < VBRBits ? Abbrevs.NodeFixedAbbrev : Abbrevs.NodeVBRAbbrev;
+}
+
 static void WriteMDNode(const MDNode *N,
                         const ValueEnumerator &VE,
                         BitstreamWriter &Stream,
-                        SmallVector<uint64_t, 64> &Record) {
+                        SmallVector<uint64_t, 64> &Record,
+                        const MetadataAbbrevs *Abbrevs) {
   for (unsigned i = 0, e = N->getNumOperands(); i != e; ++i) {
     if (N->getOperand(i)) {
       Record.push_back(VE.getTypeID(N->getOperand(i)->getType()));
@@ -603,47 +739,98 @@ static void WriteMDNode(const MDNode *N,
   }
   unsigned MDCode = N->isFunctionLocal() ? bitc::METADATA_FN_NODE :
                                            bitc::METADATA_NODE;
-  Stream.EmitRecord(MDCode, Record, 0);
+  unsigned AbbrevToUse = 0;
+  if (Abbrevs && MDCode == bitc::METADATA_NODE)
+    AbbrevToUse = GetMDNodeAbbrev(Record, *Abbrevs);
+  Stream.EmitRecord(MDCode, Record, AbbrevToUse);
   Record.clear();
 }
 
+/// CountKernelMetadata - Add the bits of the metadata of each kernel of M to
+/// Stats, given the bits of the record of each module metadata value. The
+/// records reachable from the node of a kernel in opencl.kernels are counted
+/// for the first kernel reaching them, so strings shared by the kernels, such
+/// as the names of the argument info nodes, are counted once.
+static void CountKernelMetadata(const Module *M, const ValueEnumerator &VE,
+                                const std::vector<uint64_t> &RecordBits,
+                                SPIR::EncoderStats &Stats) {
+  const NamedMDNode *Kernels = M->getNamedMetadata("opencl.kernels");
+  if (!Kernels)
+    return;
+
+  std::vector<bool> Counted(RecordBits.size());
+  SmallVector<const Value *, 16> Worklist;
+  for (unsigned i = 0, e = Kernels->getNumOperands(); i != e; ++i) {
+    const MDNode *Kernel = Kernels->getOperand(i);
+    SPIR::KernelMetadataStats KernelStats;
+    if (Kernel->getNumOperands())
+      if (const Function *F = dyn_cast_or_null<Function>(Kernel->getOperand(0)))
+        KernelStats.Name = F->getName();
+
+    Worklist.push_back(Kernel);
+    while (!Worklist.empty()) {
+      const Value *V = Worklist.pop_back_val();
+      unsigned ID = VE.getValueID(V);
+      if (ID >= Counted.size() || Counted[ID])
+        continue;
+      Counted[ID] = true;
+      KernelStats.NumBits += RecordBits[ID];
+
+      if (const MDNode *N = dyn_cast<MDNode>(V))
+        for (unsigned Op = 0, OpE = N->getNumOperands(); Op != OpE; ++Op) {
+          const Value *Operand = N->getOperand(Op);
+          if (Operand && (isa<MDNode>(Operand) || isa<MDString>(Operand)))
+            Worklist.push_back(Operand);
+        }
+    }
+    Stats.KernelMetadata.push_back(KernelStats);
+  }
+}
+
 static void WriteModuleMetadata(const Module *M,
                                 const ValueEnumerator &VE,
                                 BitstreamWriter &Stream) {
   const ValueEnumerator::ValueList &Vals = VE.getMDValues();
   bool StartedMetadataBlock = false;
-  unsigned MDSAbbrev = 0;
+  MetadataAbbrevs Abbrevs;
+  SPIR::EncoderStats *Stats = Stream.GetStats();
+  std::vector<uint64_t> RecordBits(Stats ? Vals.size() : 0);
   SmallVector<uint64_t, 64> Record;
   for (unsigned i = 0, e = Vals.size(); i != e; ++i) {
+    uint64_t Start = Stream.GetCurrentBitNo();
 
     if (const MDNode *N = dyn_cast<MDNode>(Vals[i].first)) {
       if (!N->isFunctionLocal() || !N->getFunction()) {
         if (!StartedMetadataBlock) {
-          Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, 3);
+          EnterModuleMetadataBlock(VE, Stream, Abbrevs);
           StartedMetadataBlock = true;
+          Start = Stream.GetCurrentBitNo();
         }
-        WriteMDNode(N, VE, Stream, Record);
+        WriteMDNode(N, VE, Stream, Record, &Abbrevs);
       }
     } else if (const MDString *MDS = dyn_cast<MDString>(Vals[i].first)) {
       if (!StartedMetadataBlock)  {
-        Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, 3);
-
-        // Abbrev for METADATA_STRING.
-        BitCodeAbbrev *Abbv = new BitCodeAbbrev();
-        Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_STRING));
-        Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
-        Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
-        MDSAbbrev = Stream.EmitAbbrev(Abbv);
+        EnterModuleMetadataBlock(VE, Stream, Abbrevs);
         StartedMetadataBlock = true;
+        Start = Stream.GetCurrentBitNo();
       }
 
       // Code: [strchar x N]
-      Record.append(MDS->begin(), MDS->end());
-
-      // Emit the finished record.
-      Stream.EmitRecord(bitc::METADATA_STRING, Record, MDSAbbrev);
-      Record.clear();
+      StringRef Str = MDS->getString();
+      if (BitCodeAbbrevOp::ClassifyString(Str) ==
+          BitCodeAbbrevOp::Char6String) {
+        SmallVector<unsigned, 1> Code(1, bitc::METADATA_STRING);
+        Stream.EmitRecordWithArray(Abbrevs.String6Abbrev, Code, Str);
+      } else {
+        Record.append(Str.begin(), Str.end());
+        Stream.EmitRecord(bitc::METADATA_STRING, Record,
+                          Abbrevs.String8Abbrev);
+        Record.clear();
+      }
     }
+
+    if (Stats)
+      RecordBits[i] = Stream.GetCurrentBitNo() - Start;
   }
 
   // Write named metadata.
@@ -651,7 +838,7 @@ static void WriteModuleMetadata(const Module *M,
        E = M->named_metadata_end(); I != E; ++I) {
     const NamedMDNode *NMD = I;
     if (!StartedMetadataBlock)  {
-      Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, 3);
+      EnterModuleMetadataBlock(VE, Stream, Abbrevs);
       StartedMetadataBlock = true;
     }
 
@@ -671,6 +858,9 @@ static void WriteModuleMetadata(const Module *M,
 
   if (StartedMetadataBlock)
     Stream.ExitBlock();
+
+  if (Stats)
+    CountKernelMetadata(M, VE, RecordBits, *Stats);
 }
 
 static void WriteFunctionLocalMetadata(const Function &F,
@@ -686,7 +876,7 @@ static void WriteFunctionLocalMetadata(const Function &F,
           Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, 3);
           StartedMetadataBlock = true;
         }
-        WriteMDNode(N, VE, Stream, Record);
+        WriteMDNode(N, VE, Stream, Record, 0);
       }
 
   if (StartedMetadataBlock)
@@ -785,6 +975,40 @@ static void EmitAPInt(SmallVectorImpl<uint64_t> &Vals,
   }
 }
 
+/// DataAbbrevWidths - The element widths of the CST_CODE_DATA abbrevs used with
+/// -spir-encoder-compact-constants. The LLVM 3.2 reader reads fixed width
+/// fields of up to 32 bits.
+static const unsigned DataAbbrevWidths[] = { 8, 16, 32 };
+static const unsigned NumDataAbbrevWidths =
+  sizeof(DataAbbrevWidths) / sizeof(DataAbbrevWidths[0]);
+
+/// GetDataAbbrevWidth - Return the index in DataAbbrevWidths of the smallest
+/// width holding every element of the CST_CODE_DATA record Record, if the
+/// record is smaller with it than unabbreviated. Set BitsSaved to the
+/// difference. Returns NumDataAbbrevWidths if no width is better.
+static unsigned GetDataAbbrevWidth(const SmallVectorImpl<uint64_t> &Record,
+                                   uint64_t &BitsSaved) {
+  // The abbrev id and the number of elements take the same bits both ways.
+  uint64_t UnabbrevBits = SPIR::AbbrevProfile::VBRBits(bitc::CST_CODE_DATA, 6);
+  uint64_t AllBits = 0;
+  for (unsigned i = 0, e = Record.size(); i != e; ++i) {
+    UnabbrevBits += SPIR::AbbrevProfile::VBRBits(Record[i], 6);
+    AllBits |= Record[i];
+  }
+  unsigned MaxWidth = AllBits ? Log2_64(AllBits) + 1 : 0;
+
+  for (unsigned i = 0; i != NumDataAbbrevWidths; ++i) {
+    if (DataAbbrevWidths[i] < MaxWidth)
+      continue;
+    uint64_t Bits = (uint64_t)Record.size() * DataAbbrevWidths[i];
+    if (Bits >= UnabbrevBits)
+      break;
+    BitsSaved = UnabbrevBits - Bits;
+    return i;
+  }
+  return NumDataAbbrevWidths;
+}
+
 static void WriteConstants(unsigned FirstVal, unsigned LastVal,
                            const ValueEnumerator &VE,
                            BitstreamWriter &Stream, bool isGlobal) {
@@ -796,6 +1020,10 @@ static void WriteConstants(unsigned FirstVal, unsigned LastVal,
   unsigned String8Abbrev = 0;
   unsigned CString7Abbrev = 0;
   unsigned CString6Abbrev = 0;
+  // The CST_CODE_DATA abbrevs, defined as they are first used.
+  unsigned DataAbbrevs[NumDataAbbrevWidths] = { 0 };
+  bool PackData = isGlobal && CompactConstants;
+  SPIR::EncoderStats *Stats = Stream.GetStats();
   // If this is a constant pool for the module, emit module-specific abbrevs.
   if (isGlobal) {
     // Abbrev for CST_CODE_AGGREGATE.
@@ -838,6 +1066,8 @@ static void WriteConstants(unsigned FirstVal, unsigned LastVal,
       Stream.EmitRecord(bitc::CST_CODE_SETTYPE, Record,
                         CONSTANTS_SETTYPE_ABBREV);
       Record.clear();
+      if (Stats)
+        ++Stats->Constants.NumSetTypes;
     }
 
     if (const InlineAsm *IA = dyn_cast<InlineAsm>(V)) {
@@ -937,6 +1167,31 @@ static void WriteConstants(unsigned FirstVal, unsigned LastVal,
           Record.push_back(I);
         }
       }
+
+      uint64_t BitsSaved = 0;
+      unsigned Width = PackData ? GetDataAbbrevWidth(Record, BitsSaved)
+                                : NumDataAbbrevWidths;
+      if (Width != NumDataAbbrevWidths) {
+        if (!DataAbbrevs[Width]) {
+          uint64_t Start = Stream.GetCurrentBitNo();
+          BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+          Abbv->Add(BitCodeAbbrevOp(bitc::CST_CODE_DATA));
+          Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+          Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed,
+                                    DataAbbrevWidths[Width]));
+          DataAbbrevs[Width] = Stream.EmitAbbrev(Abbv);
+          if (Stats)
+            Stats->Constants.DataAbbrevBits += Stream.GetCurrentBitNo() - Start;
+        }
+        AbbrevToUse = DataAbbrevs[Width];
+      }
+      if (Stats) {
+        ++Stats->Constants.NumData;
+        if (AbbrevToUse) {
+          ++Stats->Constants.NumPackedData;
+          Stats->Constants.PackedDataBitsSaved += BitsSaved;
+        }
+      }
     } else if (isa<ConstantArray>(C) || isa<ConstantStruct>(C) ||
                isa<ConstantVector>(C)) {
       Code = bitc::CST_CODE_AGGREGATE;
@@ -1367,8 +1622,13 @@ static void WriteInstruction(const Instruction &I, unsigned InstID,
     pushValue(I.getOperand(1), InstID, Vals, VE);         // cmp.
     pushValue(I.getOperand(2), InstID, Vals, VE);         // newval.
     Vals.push_back(cast<AtomicCmpXchgInst>(I).isVolatile());
+#if LLVM_VERSION < 3500
+    Vals.push_back(GetEncodedOrdering(
+                     cast<AtomicCmpXchgInst>(I).getOrdering()));
+#else
     Vals.push_back(GetEncodedOrdering(
                      cast<AtomicCmpXchgInst>(I).getSuccessOrdering()));
+#endif
     Vals.push_back(GetEncodedSynchScope(
                      cast<AtomicCmpXchgInst>(I).getSynchScope()));
     break;
@@ -1435,34 +1695,40 @@ static void WriteValueSymbolTable(const ValueSymbolTable &VST,
   if (VST.empty()) return;
   Stream.EnterSubblock(bitc::VALUE_SYMTAB_BLOCK_ID, 4);
 
-  // FIXME: Set up the abbrev, we know how many values there are!
-  // FIXME: We know if the type names can use 7-bit ascii.
-  SmallVector<unsigned, 64> NameVals;
-
+  // The symbol table is a hash table, which lists the names in an order that
+  // depends on the names added to and removed from it before. Deterministic
+  // output lists them by value ID instead, basic blocks last.
+  typedef std::pair<uint64_t, const ValueName *> Entry;
+  SmallVector<Entry, 64> Entries;
   for (ValueSymbolTable::const_iterator SI = VST.begin(), SE = VST.end();
        SI != SE; ++SI) {
+    uint64_t Key = VE.getValueID(SI->getValue());
+    if (isa<BasicBlock>(SI->getValue()))
+      Key |= 1ULL << 32;
+    Entries.push_back(Entry(Key, &*SI));
+  }
+  if (DeterministicOutput || EmitModuleHash)
+    std::sort(Entries.begin(), Entries.end());
 
-    const ValueName &Name = *SI;
+  // FIXME: Set up the abbrev, we know how many values there are!
+  // FIXME: We know if the type names can use 7-bit ascii.
+  SmallVector<unsigned, 2> NameVals;
+
+  for (unsigned i = 0, e = Entries.size(); i != e; ++i) {
+    const ValueName &Name = *Entries[i].second;
 
     // Figure out the encoding to use for the name.
-    bool is7Bit = true;
-    bool isChar6 = true;
-    for (const char *C = Name.getKeyData(), *E = C+Name.getKeyLength();
-         C != E; ++C) {
-      if (isChar6)
-        isChar6 = BitCodeAbbrevOp::isChar6(*C);
-      if ((unsigned char)*C & 128) {
-        is7Bit = false;
-        break;  // don't bother scanning the rest.
-      }
-    }
+    BitCodeAbbrevOp::StringClass NameClass =
+      BitCodeAbbrevOp::ClassifyString(Name.getKey());
+    bool isChar6 = NameClass == BitCodeAbbrevOp::Char6String;
+    bool is7Bit = NameClass != BitCodeAbbrevOp::Fixed8String;
 
     unsigned AbbrevToUse = VST_ENTRY_8_ABBREV;
 
     // VST_ENTRY:   [valueid, namechar x N]
     // VST_BBENTRY: [bbid, namechar x N]
     unsigned Code;
-    if (isa<BasicBlock>(SI->getValue())) {
+    if (isa<BasicBlock>(Name.getValue())) {
       Code = bitc::VST_CODE_BBENTRY;
       if (isChar6)
         AbbrevToUse = VST_BBENTRY_6_ABBREV;
@@ -1474,20 +1740,280 @@ static void WriteValueSymbolTable(const ValueSymbolTable &VST,
         AbbrevToUse = VST_ENTRY_7_ABBREV;
     }
 
-    NameVals.push_back(VE.getValueID(SI->getValue()));
-    for (const char *P = Name.getKeyData(),
-         *E = Name.getKeyData()+Name.getKeyLength(); P != E; ++P)
-      NameVals.push_back((unsigned char)*P);
-
-    // Emit the finished record.
-    Stream.EmitRecord(Code, NameVals, AbbrevToUse);
+    // Emit the finished record. Every VST abbrev ends with the name array,
+    // which is emitted straight from the symbol table.
+    NameVals.push_back(Code);
+    NameVals.push_back((unsigned)Entries[i].first);  // Drop the block flag.
+    Stream.EmitRecordWithArray(AbbrevToUse, NameVals, Name.getKey());
     NameVals.clear();
   }
   Stream.ExitBlock();
 }
 
-/// WriteFunction - Emit a function body to the module stream.
+namespace {
+/// UseListOrder - The order in which the bitcode reader re-creates the uses
+/// of each value, predicted in a single walk over the module in the order
+/// the reader parses it. The reader creates the uses of a value as it
+/// creates their users, and prepends each one to the use-list. A use of an
+/// instruction defined later in its function is created on a placeholder,
+/// whose uses are moved to the instruction once it is defined. The reader
+/// therefore lists the uses of a value in reverse, followed by its forward
+/// references in order. Uses whose user is not written (e.g. dead constants)
+/// are left out. A constant that refers to a constant later in its constants
+/// block is re-created by the reader once the block is read, which reorders
+/// the uses of its operands and its own; the order of these values is not
+/// predicted, and not written.
+class UseListOrder {
+public:
+  UseListOrder(const Module *M, ValueEnumerator &VE);
+
+  /// getShuffle - Set Shuffle[i] to the position in the in-memory use-list of
+  /// V of its i-th use as listed by the reader. Returns false if the reader
+  /// lists the uses of V in their in-memory order.
+  bool getShuffle(const Value *V, SmallVectorImpl<uint64_t> &Shuffle) const;
+
+  /// getLastFunction - The last function using the function-local constant
+  /// C, whose block holds the use-list order of C.
+  const Function *getLastFunction(const Constant *C) const {
+    return LastFunction.lookup(C);
+  }
+
+private:
+  void addUse(const Use &U, bool Forward);
+  void addOperands(const User *U);
+  void addConstant(const Constant *C, unsigned ID, const ValueEnumerator &VE,
+                   SmallPtrSet<const Constant*, 64> &Created);
+
+  /// Set in Positions for forward references.
+  static const unsigned ForwardRef = 1U << 31;
+
+  /// Rank of each use among the uses of its value that the reader creates
+  /// directly, or among its forward references.
+  DenseMap<const Use*, unsigned> Positions;
+  /// Number of uses of each value created directly and as forward references.
+  DenseMap<const Value*, std::pair<unsigned, unsigned> > NumUses;
+  DenseMap<const Constant*, const Function*> LastFunction;
+  /// Constants the reader re-creates after their constants block.
+  SmallPtrSet<const Constant*, 8> Recreated;
+  /// Values whose use-list order is not predicted.
+  SmallPtrSet<const Value*, 8> Unordered;
+};
+}
+
+UseListOrder::UseListOrder(const Module *M, ValueEnumerator &VE) {
+  // Constants are uniqued, so only their first occurrence creates uses.
+  SmallPtrSet<const Constant*, 64> Created;
+
+  // The module constants block creates the module-level constants in order.
+  const ValueEnumerator::ValueList &ModuleValues = VE.getValues();
+  for (unsigned i = 0, e = ModuleValues.size(); i != e; ++i)
+    if (const Constant *C = dyn_cast<Constant>(ModuleValues[i].first))
+      if (!isa<GlobalValue>(C))
+        addConstant(C, i, VE, Created);
+
+  // Initializers and aliasees are set once the constants are read, from the
+  // last global to the first, then from the last alias to the first.
+  for (Module::const_global_iterator GI = M->global_end(),
+         GB = M->global_begin(); GI != GB;) {
+    --GI;
+    if (GI->hasInitializer())
+      addUse(GI->getOperandUse(0), false);
+  }
+  for (Module::const_alias_iterator AI = M->alias_end(),
+         AB = M->alias_begin(); AI != AB;) {
+    --AI;
+    addUse(AI->getOperandUse(0), false);
+  }
+
+  // Function bodies are read in order: their constants block, then their
+  // instructions.
+  for (Module::const_iterator F = M->begin(), FE = M->end(); F != FE; ++F) {
+    if (F->isDeclaration())
+      continue;
+    VE.incorporateFunction(*F);
+
+    unsigned CstStart, CstEnd;
+    VE.getFunctionConstantRange(CstStart, CstEnd);
+    const ValueEnumerator::ValueList &Values = VE.getValues();
+    for (unsigned i = CstStart; i != CstEnd; ++i)
+      if (const Constant *C = dyn_cast<Constant>(Values[i].first)) {
+        LastFunction[C] = F;
+        addConstant(C, i, VE, Created);
+      }
+
+    // Instructions are numbered from the end of the constants, as in
+    // WriteFunction, so operands numbered from InstID on are defined later.
+    unsigned InstID = CstEnd;
+    for (Function::const_iterator BB = F->begin(), E = F->end(); BB != E;
+         ++BB)
+      for (BasicBlock::const_iterator I = BB->begin(), IE = BB->end();
+           I != IE; ++I) {
+        for (User::const_op_iterator OI = I->op_begin(), OE = I->op_end();
+             OI != OE; ++OI) {
+          const Value *V = OI->get();
+          if (!V || isa<MDNode>(V) || isa<MDString>(V))
+            continue;
+          addUse(*OI, isa<Instruction>(V) && VE.getValueID(V) >= InstID);
+        }
+        if (!I->getType()->isVoidTy())
+          ++InstID;
+      }
+    VE.purgeFunction();
+  }
+}
+
+void UseListOrder::addUse(const Use &U, bool Forward) {
+  std::pair<unsigned, unsigned> &N = NumUses[U.get()];
+  Positions[&U] = Forward ? (N.second++ | ForwardRef) : N.first++;
+}
+
+void UseListOrder::addOperands(const User *U) {
+  for (User::const_op_iterator OI = U->op_begin(), OE = U->op_end();
+       OI != OE; ++OI)
+    if (OI->get())
+      addUse(*OI, false);
+}
+
+/// addConstant - Add the uses of C, the ID-th value of a constants block,
+/// if the reader creates it there. If C refers to a constant later in the
+/// block, or to one re-created, the reader builds it on a placeholder and
+/// re-creates it after the block, so its order and its operands' are left
+/// out.
+void UseListOrder::addConstant(const Constant *C, unsigned ID,
+                               const ValueEnumerator &VE,
+                               SmallPtrSet<const Constant*, 64> &Created) {
+  bool IsRecreated = false;
+  for (User::const_op_iterator OI = C->op_begin(), OE = C->op_end();
+       OI != OE; ++OI) {
+    const Constant *Op = dyn_cast_or_null<Constant>(OI->get());
+    if (Op && !isa<GlobalValue>(Op) &&
+        (VE.getValueID(Op) > ID || Recreated.count(Op)))
+      IsRecreated = true;
+  }
+  if (IsRecreated) {
+    Recreated.insert(C);
+    Unordered.insert(C);
+    for (User::const_op_iterator OI = C->op_begin(), OE = C->op_end();
+         OI != OE; ++OI)
+      if (OI->get())
+        Unordered.insert(OI->get());
+  }
+
+  if (Created.insert(C))
+    addOperands(C);
+}
+
+bool UseListOrder::getShuffle(const Value *V,
+                              SmallVectorImpl<uint64_t> &Shuffle) const {
+  if (Unordered.count(V))
+    return false;
+  DenseMap<const Value*, std::pair<unsigned, unsigned> >::const_iterator N =
+    NumUses.find(V);
+  if (N == NumUses.end())
+    return false;
+  unsigned NumDirect = N->second.first;
+  unsigned Size = NumDirect + N->second.second;
+
+  // One or zero uses can't get out of order.
+  if (Size < 2)
+    return false;
+
+  Shuffle.resize(Size);
+  unsigned Index = 0;
+  bool InOrder = true;
+  for (Value::const_use_iterator UI = V->use_begin(), UE = V->use_end();
+       UI != UE; ++UI) {
+#if LLVM_VERSION < 3500
+    const Use *U = &UI.getUse();
+#else
+    const Use *U = &*UI;
+#endif
+    DenseMap<const Use*, unsigned>::const_iterator P = Positions.find(U);
+    if (P == Positions.end())
+      continue;
+    unsigned Pos = P->second;
+    if (Pos & ForwardRef)
+      Pos = NumDirect + (Pos & ~ForwardRef);
+    else
+      Pos = NumDirect - 1 - Pos;
+    Shuffle[Pos] = Index;
+    InOrder &= Pos == Index;
+    ++Index;
+  }
+  assert(Index == Size && "Use missing from its use-list");
+  return !InOrder;
+}
+
+/// WriteUseList - Emit the use-list order of V if the reader would not
+/// re-create it, entering a USELIST_BLOCK first if InBlock is false.
+static void WriteUseList(const Value *V, const UseListOrder &Order,
+                         const ValueEnumerator &VE, BitstreamWriter &Stream,
+                         SmallVectorImpl<uint64_t> &Record, bool &InBlock) {
+  if (!Order.getShuffle(V, Record))
+    return;
+  if (!InBlock) {
+    Stream.EnterSubblock(bitc::USELIST_BLOCK_ID, 3);
+    InBlock = true;
+  }
+  Record.push_back(VE.getValueID(V));
+  Stream.EmitRecord(isa<BasicBlock>(V) ? bitc::USELIST_CODE_BB
+                                       : bitc::USELIST_CODE_ENTRY, Record);
+}
+
+/// WriteFunctionUseLists - Emit the use-list orders of the function-local
+/// values of F, and of the function-local constants it is the last user of,
+/// in a USELIST_BLOCK nested in its function block.
+static void WriteFunctionUseLists(const Function &F, const UseListOrder &Order,
+                                  const ValueEnumerator &VE,
+                                  BitstreamWriter &Stream) {
+  SmallVector<uint64_t, 64> Record;
+  bool InBlock = false;
+
+  unsigned CstStart, CstEnd;
+  VE.getFunctionConstantRange(CstStart, CstEnd);
+  const ValueEnumerator::ValueList &Values = VE.getValues();
+  for (unsigned i = CstStart; i != CstEnd; ++i) {
+    const Constant *C = dyn_cast<Constant>(Values[i].first);
+    if (C && Order.getLastFunction(C) == &F)
+      WriteUseList(C, Order, VE, Stream, Record, InBlock);
+  }
+  for (Function::const_arg_iterator AI = F.arg_begin(), AE = F.arg_end();
+       AI != AE; ++AI)
+    WriteUseList(AI, Order, VE, Stream, Record, InBlock);
+  for (Function::const_iterator BB = F.begin(), FE = F.end(); BB != FE;
+       ++BB) {
+    WriteUseList(BB, Order, VE, Stream, Record, InBlock);
+    for (BasicBlock::const_iterator II = BB->begin(), IE = BB->end(); II != IE;
+         ++II)
+      WriteUseList(II, Order, VE, Stream, Record, InBlock);
+  }
+
+  if (InBlock)
+    Stream.ExitBlock();
+}
+
+/// WriteModuleUseLists - Emit the use-list orders of the module-level values
+/// in a USELIST_BLOCK, after the function blocks so that the uses in all
+/// functions are read when it is.
+static void WriteModuleUseLists(const UseListOrder &Order,
+                                const ValueEnumerator &VE,
+                                BitstreamWriter &Stream) {
+  SmallVector<uint64_t, 64> Record;
+  bool InBlock = false;
+
+  // Global values, then module-level constants.
+  const ValueEnumerator::ValueList &Values = VE.getValues();
+  for (unsigned i = 0, e = Values.size(); i != e; ++i)
+    WriteUseList(Values[i].first, Order, VE, Stream, Record, InBlock);
+
+  if (InBlock)
+    Stream.ExitBlock();
+}
+
+/// WriteFunction - Emit a function body to the module stream, with the
+/// use-list orders of its values if UseLists is not null.
 static void WriteFunction(const Function &F, ValueEnumerator &VE,
+                          const UseListOrder *UseLists,
                           BitstreamWriter &Stream) {
   Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
   VE.incorporateFunction(F);
@@ -1554,12 +2080,32 @@ static void WriteFunction(const Function &F, ValueEnumerator &VE,
 
   if (NeedsMetadataAttachment)
     WriteMetadataAttachment(F, VE, Stream);
+  if (UseLists)
+    WriteFunctionUseLists(F, *UseLists, VE, Stream);
   VE.purgeFunction();
   Stream.ExitBlock();
 }
 
+/// WriteProfiledAbbrevs - Define the abbreviations selected from the profile
+/// of the module in the BLOCKINFO block, for the records of their code.
+static void WriteProfiledAbbrevs(const SPIR::AbbrevProfile &Profile,
+                                 BitstreamWriter &Stream) {
+  std::vector<SPIR::AbbrevProfile::BlockAbbrevs> Selected;
+  Profile.selectAbbrevs(Selected);
+  for (unsigned i = 0, e = Selected.size(); i != e; ++i) {
+    const SPIR::AbbrevProfile::BlockAbbrevs &Block = Selected[i];
+    for (unsigned j = 0, je = Block.Abbrevs.size(); j != je; ++j) {
+      unsigned AbbrevID = Stream.EmitBlockInfoAbbrev(Block.BlockID,
+                                                     Block.Abbrevs[j].Abbrev);
+      Stream.SetRecordAbbrev(Block.BlockID, Block.Abbrevs[j].Code, AbbrevID);
+    }
+    Stream.SetMinCodeLen(Block.BlockID, Block.CodeLen);
+  }
+}
+
 // Emit blockinfo, which defines the standard abbreviations etc.
-static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
+static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream,
+                           const SPIR::AbbrevProfile *Profile) {
   // We only want to emit block info records for blocks that have multiple
   // instances: CONSTANTS_BLOCK, FUNCTION_BLOCK and VALUE_SYMTAB_BLOCK.
   // Other blocks can define their abbrevs inline.
@@ -1716,102 +2262,155 @@ static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
       llvm_unreachable("Unexpected abbrev ordering!");
   }
 
-  Stream.ExitBlock();
-}
+  // The profiled abbrevs follow the fixed ones, so their IDs don't change.
+  if (Profile)
+    WriteProfiledAbbrevs(*Profile, Stream);
 
-// Sort the Users based on the order in which the reader parses the bitcode
-// file.
-static bool bitcodereader_order(const User *lhs, const User *rhs) {
-  // TODO: Implement.
-  return true;
+  Stream.ExitBlock();
 }
 
-static void WriteUseList(const Value *V, const ValueEnumerator &VE,
-                         BitstreamWriter &Stream) {
-
-  // One or zero uses can't get out of order.
-  if (V->use_empty() || V->hasNUses(1))
-    return;
-
-  // Make a copy of the in-memory use-list for sorting.
-  SmallVector<const User*, 8> UserList(V->user_begin(), V->user_end());
-
-  // Sort the copy based on the order read by the BitcodeReader.
-  std::sort(UserList.begin(), UserList.end(), bitcodereader_order);
-
-  // TODO: Generate a diff between the BitcodeWriter in-memory use-list and the
-  // sorted list (i.e., the expected BitcodeReader in-memory use-list).
-
-  // TODO: Emit the USELIST_CODE_ENTRYs.
+#if SPIR_ENCODER_PARALLEL
+namespace {
+/// FunctionBatch - A range of function bodies encoded in parallel. Each
+/// function block is emitted to its own buffer, by a writer set up to be
+/// spliced into the module stream.
+struct FunctionBatch {
+  const Module *M;
+  const UseListOrder *UseLists;
+  const BitstreamWriter *ModuleStream;
+  const std::vector<const Function*> *Functions;
+  size_t Begin, End;
+  /// Blocks[i] holds the block of function Begin+i.
+  std::vector<SmallVector<char, 0> > *Blocks;
+  /// Next function to encode.
+  std::atomic<size_t> Next;
+};
 }
 
-static void WriteFunctionUseList(const Function *F, ValueEnumerator &VE,
-                                 BitstreamWriter &Stream) {
-  VE.incorporateFunction(*F);
-
-  for (Function::const_arg_iterator AI = F->arg_begin(), AE = F->arg_end();
-       AI != AE; ++AI)
-    WriteUseList(AI, VE, Stream);
-  for (Function::const_iterator BB = F->begin(), FE = F->end(); BB != FE;
-       ++BB) {
-    WriteUseList(BB, VE, Stream);
-    for (BasicBlock::const_iterator II = BB->begin(), IE = BB->end(); II != IE;
-         ++II) {
-      WriteUseList(II, VE, Stream);
-      for (User::const_op_iterator OI = II->op_begin(), E = II->op_end();
-           OI != E; ++OI) {
-        if ((isa<Constant>(*OI) && !isa<GlobalValue>(*OI)) ||
-            isa<InlineAsm>(*OI))
-          WriteUseList(*OI, VE, Stream);
-      }
-    }
+/// EncodeFunctionBatch - Encode functions of the batch until none are left.
+/// The function-local state of the enumerator and the statistics, if any, are
+/// only used by this thread.
+static void EncodeFunctionBatch(FunctionBatch *Batch, ValueEnumerator **VE,
+                                SPIR::EncoderStats *Stats) {
+  // Enumerating the module again gives the same value numbering.
+  if (!*VE)
+    *VE = new ValueEnumerator(Batch->M);
+  for (size_t I = Batch->Next++; I < Batch->End; I = Batch->Next++) {
+    SmallVector<char, 0> &Block = (*Batch->Blocks)[I - Batch->Begin];
+    Block.clear();
+    BitstreamWriter Writer(Block);
+    Writer.InitSplice(*Batch->ModuleStream);
+    Writer.SetStats(Stats);
+    WriteFunction(*(*Batch->Functions)[I], **VE, Batch->UseLists, Writer);
   }
-  VE.purgeFunction();
 }
+#endif
 
-// Emit use-lists.
-static void WriteModuleUseLists(const Module *M, ValueEnumerator &VE,
-                                BitstreamWriter &Stream) {
-  Stream.EnterSubblock(bitc::USELIST_BLOCK_ID, 3);
-
-  // XXX: this modifies the module, but in a way that should never change the
-  // behavior of any pass or codegen in LLVM. The problem is that GVs may
-  // contain entries in the use_list that do not exist in the Module and are
-  // not stored in the .bc file.
-  for (Module::const_global_iterator I = M->global_begin(), E = M->global_end();
-       I != E; ++I)
-    I->removeDeadConstantUsers();
-
-  // Write the global variables.
-  for (Module::const_global_iterator GI = M->global_begin(),
-         GE = M->global_end(); GI != GE; ++GI) {
-    WriteUseList(GI, VE, Stream);
-
-    // Write the global variable initializers.
-    if (GI->hasInitializer())
-      WriteUseList(GI->getInitializer(), VE, Stream);
+/// WriteFunctions - Emit the function bodies, on EncoderThreads threads.
+static void WriteFunctions(const Module *M, ValueEnumerator &VE,
+                           const UseListOrder *UseLists,
+                           BitstreamWriter &Stream) {
+  std::vector<const Function*> Functions;
+  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
+    if (!F->isDeclaration())
+      Functions.push_back(F);
+
+  unsigned NumThreads = EncoderThreads;
+#if SPIR_ENCODER_PARALLEL
+  if (NumThreads == 0)
+    NumThreads = std::max(std::thread::hardware_concurrency(), 1U);
+#else
+  NumThreads = 1;
+#endif
+  if (NumThreads > Functions.size())
+    NumThreads = (unsigned)Functions.size();
+
+  // Blocks encoded by other writers can only be spliced at a word boundary,
+  // which is where the preceding block ended. Records are profiled by the
+  // module writer only.
+  if (NumThreads <= 1 || Stream.GetCurrentBitNo() % 32 ||
+      Stream.GetAbbrevProfile()) {
+    for (size_t i = 0, e = Functions.size(); i != e; ++i)
+      WriteFunction(*Functions[i], VE, UseLists, Stream);
+    return;
   }
 
-  // Write the functions.
-  for (Module::const_iterator FI = M->begin(), FE = M->end(); FI != FE; ++FI) {
-    WriteUseList(FI, VE, Stream);
-    if (!FI->isDeclaration())
-      WriteFunctionUseList(FI, VE, Stream);
+#if SPIR_ENCODER_PARALLEL
+  // Functions are encoded in batches, so only a batch worth of function
+  // blocks is held in memory. The calling thread uses the module enumerator,
+  // each other thread enumerates the module once.
+  const size_t BatchSize = NumThreads * 32;
+  std::vector<ValueEnumerator*> Enumerators(NumThreads, 0);
+  Enumerators[0] = &VE;
+  std::vector<SmallVector<char, 0> > Blocks(BatchSize);
+  std::vector<std::thread> Threads(NumThreads - 1);
+  SPIR::EncoderStats *Stats = Stream.GetStats();
+  std::vector<SPIR::EncoderStats> ThreadStats(Stats ? NumThreads : 0);
+  for (size_t Begin = 0; Begin < Functions.size(); Begin += BatchSize) {
+    FunctionBatch Batch;
+    Batch.M = M;
+    Batch.UseLists = UseLists;
+    Batch.ModuleStream = &Stream;
+    Batch.Functions = &Functions;
+    Batch.Begin = Begin;
+    Batch.End = std::min(Begin + BatchSize, Functions.size());
+    Batch.Blocks = &Blocks;
+    Batch.Next = Begin;
+
+    double Start = Stats ? BitstreamWriter::GetTime() : 0;
+    for (unsigned t = 1; t < NumThreads; ++t)
+      Threads[t-1] = std::thread(EncodeFunctionBatch, &Batch,
+                                 &Enumerators[t],
+                                 Stats ? &ThreadStats[t] : 0);
+    EncodeFunctionBatch(&Batch, &Enumerators[0], Stats ? &ThreadStats[0] : 0);
+    for (unsigned t = 1; t < NumThreads; ++t)
+      Threads[t-1].join();
+
+    // Splice the blocks in function order. The time spent encoding the batch
+    // is not counted in the module block.
+    double Seconds = Stats ? BitstreamWriter::GetTime() - Start : 0;
+    for (size_t I = Batch.Begin; I != Batch.End; ++I) {
+      Stream.SpliceBlocks(Blocks[I - Begin], Seconds);
+      Seconds = 0;
+    }
   }
+  for (unsigned t = 1; t < NumThreads; ++t)
+    delete Enumerators[t];
+  for (unsigned t = 0; t < ThreadStats.size(); ++t)
+    Stats->merge(ThreadStats[t]);
+#endif
+}
 
-  // Write the aliases.
-  for (Module::const_alias_iterator AI = M->alias_begin(), AE = M->alias_end();
-       AI != AE; ++AI) {
-    WriteUseList(AI, VE, Stream);
-    WriteUseList(AI->getAliasee(), VE, Stream);
-  }
+/// WriteModuleHash - Emit the MODULE_HASH_BLOCK of the module block whose
+/// contents start at byte BodyStart (see SpirBitcodeWriter.h).
+static void WriteModuleHash(uint64_t BodyStart, BitstreamWriter &Stream) {
+  Stream.EnterSubblock(SPIR::MODULE_HASH_BLOCK_ID, 2);
+
+  // The last word written is the size word of the hash block.
+  StringRef Body = Stream.GetBufferedBytes(BodyStart,
+                                           Stream.GetCurrentBitNo() / 8 - 4);
+  MD5 Hash;
+  Hash.update(ArrayRef<uint8_t>((const uint8_t *)Body.data(), Body.size()));
+  MD5::MD5Result Digest;
+  Hash.final(Digest);
+
+  // MD5: [4 x i32]
+  SmallVector<unsigned, 4> Vals;
+  for (unsigned i = 0; i != 16; i += 4)
+    Vals.push_back((unsigned)Digest[i] << 24 | (unsigned)Digest[i+1] << 16 |
+                   (unsigned)Digest[i+2] << 8 | (unsigned)Digest[i+3]);
+  Stream.EmitRecord(SPIR::MODULE_HASH_CODE_MD5, Vals);
 
   Stream.ExitBlock();
 }
 
-/// WriteModule - Emit the specified module to the bitstream.
-static void WriteModule(const Module *M, BitstreamWriter &Stream) {
+/// WriteModule - Emit the specified module to the bitstream. If Profile is not
+/// null, abbreviations selected from it are defined for the records it
+/// profiled.
+static void WriteModule(const Module *M, BitstreamWriter &Stream,
+                        const SPIR::AbbrevProfile *Profile) {
   Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
+  uint64_t BodyStart = Stream.GetCurrentBitNo() / 8;
 
   SmallVector<unsigned, 1> Vals;
   unsigned CurVersion = 1;
@@ -1822,7 +2421,7 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   ValueEnumerator VE(M);
 
   // Emit blockinfo, which defines the standard abbreviations etc.
-  WriteBlockInfo(VE, Stream);
+  WriteBlockInfo(VE, Stream, Profile);
 
   // Emit information about parameter attributes.
   WriteAttributeTable(VE, Stream);
@@ -1846,14 +2445,18 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   // Emit names for globals/functions etc.
   WriteValueSymbolTable(M->getValueSymbolTable(), VE, Stream);
 
-  // Emit use-lists.
-  if (EnablePreserveUseListOrdering)
-    WriteModuleUseLists(M, VE, Stream);
+  // Emit function bodies, and the use-list orders of module-level values
+  // once all their uses are written.
+  if (EnablePreserveUseListOrdering) {
+    UseListOrder UseLists(M, VE);
+    WriteFunctions(M, VE, &UseLists, Stream);
+    WriteModuleUseLists(UseLists, VE, Stream);
+  } else {
+    WriteFunctions(M, VE, 0, Stream);
+  }
 
-  // Emit function bodies.
-  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
-    if (!F->isDeclaration())
-      WriteFunction(*F, VE, Stream);
+  if (EmitModuleHash)
+    WriteModuleHash(BodyStart, Stream);
 
   Stream.ExitBlock();
 }
@@ -1931,11 +2534,41 @@ static void EmitDarwinBCHeaderAndTrailer(SmallVectorImpl<char> &Buffer,
     Buffer.push_back(0);
 }
 
+/// WriteBitcode - Emit the bitcode file header and the module.
+static void WriteBitcode(const Module *M, BitstreamWriter &Stream) {
+  // Emit the file header.
+  Stream.Emit((unsigned)'B', 8);
+  Stream.Emit((unsigned)'C', 8);
+  Stream.Emit(0x0, 4);
+  Stream.Emit(0xC, 4);
+  Stream.Emit(0xE, 4);
+  Stream.Emit(0xD, 4);
+
+  // With -spir-encoder-profile-abbrevs, the module is first encoded to a
+  // scratch buffer to profile its records.
+  if (ProfileAbbrevs) {
+    SPIR::AbbrevProfile Profile;
+    {
+      SmallVector<char, 0> Scratch;
+      BitstreamWriter ProfileStream(Scratch);
+      ProfileStream.SetAbbrevProfile(&Profile);
+      WriteModule(M, ProfileStream, 0);
+    }
+    WriteModule(M, Stream, &Profile);
+    return;
+  }
+
+  // Emit the module.
+  WriteModule(M, Stream, 0);
+}
+
+
 namespace SPIR
 {
   /// WriteBitcodeToFile - Write the specified module to the specified output
   /// stream.
-  void WriteBitcodeToFile_SPIR(const Module *M, raw_ostream &Out) {
+  void WriteBitcodeToFile_SPIR(const Module *M, raw_ostream &Out,
+                               EncoderStats *Stats) {
     SmallVector<char, 1024> Buffer;
     Buffer.reserve(256*1024);
 
@@ -1948,17 +2581,8 @@ namespace SPIR
     // Emit the module into the buffer.
     {
       BitstreamWriter Stream(Buffer);
-
-      // Emit the file header.
-      Stream.Emit((unsigned)'B', 8);
-      Stream.Emit((unsigned)'C', 8);
-      Stream.Emit(0x0, 4);
-      Stream.Emit(0xC, 4);
-      Stream.Emit(0xE, 4);
-      Stream.Emit(0xD, 4);
-
-      // Emit the module.
-      WriteModule(M, Stream);
+      Stream.SetStats(Stats);
+      WriteBitcode(M, Stream);
     }
 
     if (TT.isOSDarwin())
@@ -1967,4 +2591,26 @@ namespace SPIR
     // Write the generated bitstream to "Out".
     Out.write((char*)&Buffer.front(), Buffer.size());
   }
+
+  /// WriteBitcodeToFile - Write the specified module to the specified file,
+  /// streaming completed blocks to it instead of buffering the whole module.
+  void WriteBitcodeToFile_SPIR(const Module *M, raw_fd_ostream &Out,
+                               EncoderStats *Stats) {
+    // The darwin wrapper header holds the size of the bitcode, block sizes
+    // can only be backpatched in a seekable file, and the module hash is
+    // computed over the whole module block; use the buffered writer for
+    // those.
+    Triple TT(M->getTargetTriple());
+    if (TT.isOSDarwin() || !Out.supportsSeeking() || EmitModuleHash)
+      return WriteBitcodeToFile_SPIR(M, static_cast<raw_ostream&>(Out), Stats);
+
+    size_t Threshold = StreamFlushThreshold;
+    SmallVector<char, 0> Buffer;
+    Buffer.reserve(Threshold + Threshold/4);
+
+    BitstreamWriter Stream(Buffer, Out, Threshold);
+    Stream.SetStats(Stats);
+    WriteBitcode(M, Stream);
+    Stream.FlushToFile();
+  }
 }
@@ -0,0 +1,57 @@
+//===---------------------- SpirBitcodeWriter.h --------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+
+#ifndef SPIR_BITCODE_WRITER_H
+#define SPIR_BITCODE_WRITER_H
+
+#include "llvm/Support/DataTypes.h"
+
+namespace llvm
+{
+  class Module;
+  class StringRef;
+  class raw_ostream;
+  class raw_fd_ostream;
+}
+
+namespace SPIR
+{
+  class EncoderStats;
+
+  /// Write the module to Out, encoded as LLVM 3.2 bitcode. If Stats is not
+  /// null, the statistics of the encoded blocks are added to it (see
+  /// SpirEncoderStats.h).
+  void WriteBitcodeToFile_SPIR(const llvm::Module *M, llvm::raw_ostream &Out,
+                               EncoderStats *Stats = 0);
+
+  /// Like the raw_ostream overload, but writes the bitcode to the file as it
+  /// is encoded, so only part of it is held in memory. Falls back to
+  /// buffering the whole module for darwin targets and unseekable files.
+  void WriteBitcodeToFile_SPIR(const llvm::Module *M,
+                               llvm::raw_fd_ostream &Out,
+                               EncoderStats *Stats = 0);
+
+  /// With -spir-encoder-module-hash, the last block of the module block is a
+  /// MODULE_HASH_BLOCK, which LLVM readers skip like any unknown block. Its
+  /// MODULE_HASH_CODE_MD5 record holds the MD5 digest of the module block,
+  /// from the end of the module block header to the start of the
+  /// MODULE_HASH_BLOCK size word, as four 32-bit words read big-endian.
+  enum
+  {
+    MODULE_HASH_BLOCK_ID = 32,
+    MODULE_HASH_CODE_MD5 = 1
+  };
+
+  /// Read the module hash written with -spir-encoder-module-hash from the
+  /// bitcode file in Bitcode, skipping over the other blocks without decoding
+  /// them. Returns false if the file has no module hash.
+  bool ReadModuleHash(llvm::StringRef Bitcode, uint32_t Hash[4]);
+}
+
+#endif // SPIR_BITCODE_WRITER_H
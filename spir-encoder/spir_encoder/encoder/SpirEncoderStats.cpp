@@ -0,0 +1,191 @@
+//===---------------------- SpirEncoderStats.cpp -------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+
+#include "SpirEncoderStats.h"
+#include "LLVMBitCodes.h"
+
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+
+using namespace llvm;
+
+namespace SPIR
+{
+  void EncoderStats::merge(const EncoderStats &Other) {
+    for (unsigned ID = 0, e = (unsigned)Other.Blocks.size(); ID != e; ++ID) {
+      const BlockStats &From = Other.Blocks[ID];
+      if (!From.NumBlocks)
+        continue;
+      BlockStats &To = get(ID);
+      To.NumBlocks += From.NumBlocks;
+      To.NumBits += From.NumBits;
+      To.NumRecords += From.NumRecords;
+      To.NumAbbreviated += From.NumAbbreviated;
+      To.Seconds += From.Seconds;
+    }
+
+    Constants.NumSetTypes += Other.Constants.NumSetTypes;
+    Constants.NumData += Other.Constants.NumData;
+    Constants.NumPackedData += Other.Constants.NumPackedData;
+    Constants.PackedDataBitsSaved += Other.Constants.PackedDataBitsSaved;
+    Constants.DataAbbrevBits += Other.Constants.DataAbbrevBits;
+
+    KernelMetadata.insert(KernelMetadata.end(), Other.KernelMetadata.begin(),
+                          Other.KernelMetadata.end());
+  }
+
+  const char *EncoderStats::getBlockName(unsigned BlockID) {
+    switch (BlockID) {
+    case bitc::BLOCKINFO_BLOCK_ID:     return "BLOCKINFO_BLOCK";
+    case bitc::MODULE_BLOCK_ID:        return "MODULE_BLOCK";
+    case bitc::PARAMATTR_BLOCK_ID:     return "PARAMATTR_BLOCK";
+    case bitc::CONSTANTS_BLOCK_ID:     return "CONSTANTS_BLOCK";
+    case bitc::FUNCTION_BLOCK_ID:      return "FUNCTION_BLOCK";
+    case bitc::VALUE_SYMTAB_BLOCK_ID:  return "VALUE_SYMTAB";
+    case bitc::METADATA_BLOCK_ID:      return "METADATA_BLOCK";
+    case bitc::METADATA_ATTACHMENT_ID: return "METADATA_ATTACHMENT";
+    case bitc::TYPE_BLOCK_ID_NEW:      return "TYPE_BLOCK";
+    case bitc::USELIST_BLOCK_ID:       return "USELIST_BLOCK";
+    default:                           return "UNKNOWN_BLOCK";
+    }
+  }
+
+  // Returns Part as a percentage of Whole.
+  static double percent(uint64_t Part, uint64_t Whole) {
+    return Whole ? 100.0 * Part / Whole : 0.0;
+  }
+
+  // Prints a row of the statistics table, NumBlocks is left out when Count
+  // is false.
+  static void printRow(raw_ostream &OS, const char *Name, const BlockStats &S,
+                       bool Count, uint64_t TotalBits) {
+    OS << format("%-20s", Name);
+    if (Count)
+      OS << format(" %8llu", (unsigned long long)S.NumBlocks);
+    else
+      OS.indent(9);
+    OS << format(" %12llu %5.1f%%", (unsigned long long)(S.NumBits / 8),
+                 percent(S.NumBits, TotalBits))
+       << format(" %10llu %6.1f%%", (unsigned long long)S.NumRecords,
+                 percent(S.NumAbbreviated, S.NumRecords))
+       << format(" %10.3f\n", S.Seconds * 1000);
+  }
+
+  // Returns the bytes saved by the packed CST_CODE_DATA records, net of the
+  // definitions of their abbreviations.
+  static double packedDataBytesSaved(const ConstantStats &C) {
+    return ((double)C.PackedDataBitsSaved - (double)C.DataAbbrevBits) / 8;
+  }
+
+  // Orders kernels by decreasing metadata size.
+  static bool hasMoreMetadata(const KernelMetadataStats *A,
+                              const KernelMetadataStats *B) {
+    return A->NumBits > B->NumBits;
+  }
+
+  // Prints the total metadata size of the kernels and the largest of them.
+  static void printKernelMetadata(raw_ostream &OS,
+                                  const std::vector<KernelMetadataStats> &K) {
+    const size_t MaxListed = 10;
+    std::vector<const KernelMetadataStats *> Largest;
+    uint64_t TotalBits = 0;
+    for (size_t i = 0, e = K.size(); i != e; ++i) {
+      Largest.push_back(&K[i]);
+      TotalBits += K[i].NumBits;
+    }
+    size_t NumListed = std::min(Largest.size(), MaxListed);
+    std::partial_sort(Largest.begin(), Largest.begin() + NumListed,
+                      Largest.end(), hasMoreMetadata);
+
+    OS << "\nKernel metadata: " << K.size() << " kernels, "
+       << format("%.1f", TotalBits / 8.0) << " bytes\n";
+    for (size_t i = 0; i != NumListed; ++i)
+      OS << format("  %-40s %10.1f\n", Largest[i]->Name.c_str(),
+                   Largest[i]->NumBits / 8.0);
+  }
+
+  // Prints S as a JSON string.
+  static void printJSONString(raw_ostream &OS, const std::string &S) {
+    OS << '"';
+    for (size_t i = 0, e = S.size(); i != e; ++i) {
+      unsigned char C = S[i];
+      if (C == '"' || C == '\\')
+        OS << '\\' << C;
+      else if (C < 0x20)
+        OS << format("\\u%04x", C);
+      else
+        OS << C;
+    }
+    OS << '"';
+  }
+
+  void EncoderStats::print(raw_ostream &OS) const {
+    BlockStats Total;
+    for (unsigned ID = 0, e = (unsigned)Blocks.size(); ID != e; ++ID) {
+      Total.NumBits += Blocks[ID].NumBits;
+      Total.NumRecords += Blocks[ID].NumRecords;
+      Total.NumAbbreviated += Blocks[ID].NumAbbreviated;
+      Total.Seconds += Blocks[ID].Seconds;
+    }
+
+    OS << "Block                   Count        Bytes   Size    Records  Abbrev"
+          "   Time(ms)\n";
+    for (unsigned ID = 0, e = (unsigned)Blocks.size(); ID != e; ++ID) {
+      if (Blocks[ID].NumBlocks)
+        printRow(OS, getBlockName(ID), Blocks[ID], true, Total.NumBits);
+    }
+    printRow(OS, "Total", Total, false, Total.NumBits);
+
+    if (Constants.NumSetTypes || Constants.NumData) {
+      OS << "\nConstants: " << Constants.NumSetTypes << " SETTYPE records, "
+         << Constants.NumData << " data records";
+      if (Constants.NumPackedData)
+        OS << ", " << Constants.NumPackedData << " packed saving "
+           << format("%.1f", packedDataBytesSaved(Constants)) << " bytes";
+      OS << "\n";
+    }
+
+    if (!KernelMetadata.empty())
+      printKernelMetadata(OS, KernelMetadata);
+  }
+
+  void EncoderStats::printJSON(raw_ostream &OS) const {
+    OS << "{\n  \"blocks\": [";
+    bool First = true;
+    for (unsigned ID = 0, e = (unsigned)Blocks.size(); ID != e; ++ID) {
+      const BlockStats &S = Blocks[ID];
+      if (!S.NumBlocks)
+        continue;
+      OS << (First ? "\n" : ",\n");
+      First = false;
+      OS << "    {\"id\": " << ID
+         << ", \"name\": \"" << getBlockName(ID) << "\""
+         << ", \"count\": " << S.NumBlocks
+         << ", \"bits\": " << S.NumBits
+         << ", \"records\": " << S.NumRecords
+         << ", \"abbreviated_records\": " << S.NumAbbreviated
+         << ", \"seconds\": " << format("%.6f", S.Seconds) << "}";
+    }
+    OS << "\n  ],\n  \"constants\": {"
+       << "\"settype_records\": " << Constants.NumSetTypes
+       << ", \"data_records\": " << Constants.NumData
+       << ", \"packed_data_records\": " << Constants.NumPackedData
+       << ", \"packed_data_bytes_saved\": "
+       << format("%.1f", packedDataBytesSaved(Constants)) << "},\n"
+       << "  \"kernel_metadata\": [";
+    for (size_t i = 0, e = KernelMetadata.size(); i != e; ++i) {
+      OS << (i ? ",\n" : "\n") << "    {\"name\": ";
+      printJSONString(OS, KernelMetadata[i].Name);
+      OS << ", \"bits\": " << KernelMetadata[i].NumBits << "}";
+    }
+    OS << (KernelMetadata.empty() ? "]\n}\n" : "\n  ]\n}\n");
+  }
+}
@@ -0,0 +1,122 @@
+//===----------------------- SpirEncoderStats.h --------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Size and timing statistics on the blocks of encoded SPIR modules.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SPIR_ENCODER_STATS_H
+#define SPIR_ENCODER_STATS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace llvm
+{
+  class raw_ostream;
+}
+
+namespace SPIR
+{
+  /// Statistics on the blocks with a given block ID. Bits and time spent in
+  /// nested blocks are counted in the nested block only.
+  struct BlockStats
+  {
+    BlockStats()
+      : NumBlocks(0), NumBits(0), NumRecords(0), NumAbbreviated(0),
+        Seconds(0) {}
+
+    /// Number of blocks entered.
+    uint64_t NumBlocks;
+    /// Bits emitted, including the block header and tail.
+    uint64_t NumBits;
+    /// Number of records emitted.
+    uint64_t NumRecords;
+    /// Number of records emitted with an abbreviation.
+    uint64_t NumAbbreviated;
+    /// Wall time spent emitting the blocks.
+    double Seconds;
+  };
+
+  /// Statistics on the records of the constant blocks.
+  struct ConstantStats
+  {
+    ConstantStats()
+      : NumSetTypes(0), NumData(0), NumPackedData(0), PackedDataBitsSaved(0),
+        DataAbbrevBits(0) {}
+
+    /// Number of CST_CODE_SETTYPE records.
+    uint64_t NumSetTypes;
+    /// Number of CST_CODE_DATA records, for the arrays and vectors of
+    /// integers and floating point values that are not strings.
+    uint64_t NumData;
+    /// Number of CST_CODE_DATA records written as fixed width arrays, with
+    /// -spir-encoder-compact-constants.
+    uint64_t NumPackedData;
+    /// Bits these records take less than unabbreviated records.
+    uint64_t PackedDataBitsSaved;
+    /// Bits taken by the definitions of their abbreviations.
+    uint64_t DataAbbrevBits;
+  };
+
+  /// Size of the module metadata of a kernel of the opencl.kernels named
+  /// metadata: its node, and the argument info nodes and strings reachable
+  /// from it. Records reachable from several kernels are counted for the
+  /// first one only.
+  struct KernelMetadataStats
+  {
+    KernelMetadataStats() : NumBits(0) {}
+
+    /// Name of the kernel function.
+    std::string Name;
+    /// Bits of the metadata records counted for the kernel.
+    uint64_t NumBits;
+  };
+
+  /// Statistics on the encoded bitstreams, collected by the BitstreamWriter
+  /// the object is given to. When function bodies are encoded on several
+  /// threads, the time of the function blocks is the sum over the threads,
+  /// and the time of the module block includes the time spent waiting for
+  /// them.
+  class EncoderStats
+  {
+  public:
+    /// Returns the statistics of the blocks with the given ID.
+    BlockStats &get(unsigned BlockID)
+    {
+      if (BlockID >= Blocks.size())
+        Blocks.resize(BlockID + 1);
+      return Blocks[BlockID];
+    }
+
+    /// Add the statistics of another bitstream to these.
+    void merge(const EncoderStats &Other);
+
+    /// Print the statistics as a table.
+    void print(llvm::raw_ostream &OS) const;
+
+    /// Print the statistics as a JSON object.
+    void printJSON(llvm::raw_ostream &OS) const;
+
+    /// Returns the name of the given LLVM 3.2 bitcode block ID.
+    static const char *getBlockName(unsigned BlockID);
+
+    /// Statistics indexed by block ID.
+    std::vector<BlockStats> Blocks;
+
+    /// Statistics on the constant blocks.
+    ConstantStats Constants;
+
+    /// Metadata of each kernel, in the order of the encoded modules.
+    std::vector<KernelMetadataStats> KernelMetadata;
+  };
+}
+
+#endif // SPIR_ENCODER_STATS_H
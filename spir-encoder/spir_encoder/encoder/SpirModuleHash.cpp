@@ -0,0 +1,87 @@
+//===------------------------ SpirModuleHash.cpp -------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Reads the module hash written by the encoder with -spir-encoder-module-hash.
+// This file uses the LLVM bitstream reader, whose bitcode headers can't be
+// included together with the encoder's own copies of them.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SpirBitcodeWriter.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Bitcode/BitstreamReader.h"
+#include "llvm/Bitcode/LLVMBitCodes.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+
+using namespace llvm;
+
+/// ReadHashBlock - Read the MODULE_HASH_BLOCK the cursor is at.
+static bool ReadHashBlock(BitstreamCursor &Stream, uint32_t Hash[4]) {
+  if (Stream.EnterSubBlock(SPIR::MODULE_HASH_BLOCK_ID))
+    return false;
+
+  SmallVector<uint64_t, 4> Record;
+  while (true) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    if (Entry.Kind != BitstreamEntry::Record)
+      return false;
+
+    Record.clear();
+    if (Stream.readRecord(Entry.ID, Record) == SPIR::MODULE_HASH_CODE_MD5 &&
+        Record.size() == 4) {
+      for (unsigned i = 0; i != 4; ++i)
+        Hash[i] = (uint32_t)Record[i];
+      return true;
+    }
+  }
+}
+
+namespace SPIR
+{
+  bool ReadModuleHash(StringRef Bitcode, uint32_t Hash[4]) {
+    const unsigned char *Begin = (const unsigned char *)Bitcode.begin();
+    const unsigned char *End = (const unsigned char *)Bitcode.end();
+    if (isBitcodeWrapper(Begin, End) &&
+        SkipBitcodeWrapperHeader(Begin, End, true))
+      return false;
+    if (!isRawBitcode(Begin, End))
+      return false;
+
+    BitstreamReader Reader(Begin, End);
+    BitstreamCursor Stream(Reader);
+    Stream.JumpToBit(32);  // Skip the 'BC' 0xC0DE magic number.
+
+    // The hash block is the last block of the module block. Everything before
+    // it is skipped, using the block sizes to step over the nested blocks.
+    while (!Stream.AtEndOfStream()) {
+      BitstreamEntry Entry = Stream.advance();
+      switch (Entry.Kind) {
+      case BitstreamEntry::Error:
+      case BitstreamEntry::EndBlock:
+        return false;
+      case BitstreamEntry::Record:
+        Stream.skipRecord(Entry.ID);
+        break;
+      case BitstreamEntry::SubBlock:
+        if (Entry.ID == bitc::MODULE_BLOCK_ID) {
+          if (Stream.EnterSubBlock(Entry.ID))
+            return false;
+        } else if (Entry.ID == MODULE_HASH_BLOCK_ID) {
+          return ReadHashBlock(Stream, Hash);
+        } else if (Stream.SkipBlock()) {
+          return false;
+        }
+        break;
+      }
+    }
+    return false;
+  }
+}
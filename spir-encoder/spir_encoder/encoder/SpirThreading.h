@@ -0,0 +1,30 @@
+//===------------------------- SpirThreading.h ---------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// The encoder, the batch mode of spir-encoder and the module comparator of
+// the unit tests run work on several threads with std::thread, which needs
+// C++11. SPIR_ENCODER_PARALLEL is 1 when it is available, and the standard
+// threading headers are then included; otherwise it is 0 and the work is
+// done on the calling thread.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef SPIR_ENCODER_THREADING_H
+#define SPIR_ENCODER_THREADING_H
+
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1700)
+  #define SPIR_ENCODER_PARALLEL 1
+  #include <atomic>
+  #include <mutex>
+  #include <thread>
+#else
+  #define SPIR_ENCODER_PARALLEL 0
+#endif
+
+#endif // SPIR_ENCODER_THREADING_H
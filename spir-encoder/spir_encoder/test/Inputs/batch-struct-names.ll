@@ -0,0 +1,16 @@
+target datalayout = "e-p:32:32:32-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir-unknown-unknown"
+
+; Second file of batch-struct-names.ll, a struct of the same name with
+; another body.
+%struct.pair = type { float, float, i32 }
+
+define spir_kernel void @second(%struct.pair addrspace(1)* %p) nounwind {
+entry:
+  %f = getelementptr inbounds %struct.pair addrspace(1)* %p, i32 0, i32 2
+  store i32 2, i32 addrspace(1)* %f, align 4
+  ret void
+}
+
+!opencl.kernels = !{!0}
+!0 = metadata !{void (%struct.pair addrspace(1)*)* @second}
@@ -0,0 +1,29 @@
+target datalayout = "e-p:32:32:32-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir-unknown-unknown"
+
+%struct.pair = type { i32, float }
+
+; RUN: echo "%s %t.1.bc" > %t.manifest
+; RUN: echo "%S/Inputs/batch-struct-names.ll %t.2.bc" >> %t.manifest
+; RUN: spir-encoder -batch %t.manifest -j 1 | FileCheck -check-prefix=STATUS %s
+; RUN: llvm-dis -o - %t.1.bc | FileCheck %s
+; RUN: llvm-dis -o - %t.2.bc | FileCheck -check-prefix=OTHER %s
+
+; Files of a batch are loaded in contexts of their own, so the struct types
+; of files converted one after the other on the same thread keep their names.
+; STATUS: 2 of 2 files converted
+; CHECK: %struct.pair = type { i32, float }
+; CHECK: define spir_kernel void @first(%struct.pair addrspace(1)* %p)
+; OTHER-NOT: %struct.pair.
+; OTHER: %struct.pair = type { float, float, i32 }
+; OTHER: define spir_kernel void @second(%struct.pair addrspace(1)* %p)
+
+define spir_kernel void @first(%struct.pair addrspace(1)* %p) nounwind {
+entry:
+  %f = getelementptr inbounds %struct.pair addrspace(1)* %p, i32 0, i32 0
+  store i32 1, i32 addrspace(1)* %f, align 4
+  ret void
+}
+
+!opencl.kernels = !{!0}
+!0 = metadata !{void (%struct.pair addrspace(1)*)* @first}
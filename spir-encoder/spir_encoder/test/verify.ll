@@ -0,0 +1,39 @@
+target datalayout = "e-p:32:32:32-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir-unknown-unknown"
+
+; REQUIRES: spir-encoder-verify
+; RUN: spir-encoder %s %t.plain.bc
+; RUN: spir-encoder -verify %s %t.verified.bc
+; RUN: cmp %t.plain.bc %t.verified.bc
+; RUN: rm -f %t.invalid.bc
+; RUN: not spir-encoder -verify %S/Inputs/verify-invalid.ll %t.invalid.bc 2>%t.err
+; RUN: FileCheck %s <%t.err
+; RUN: not ls %t.invalid.bc
+
+; With -verify, a valid module is written as without it, and no output file
+; is created for a module the SPIR verifier rejects.
+; CHECK: the encoded module is not a valid SPIR module
+; CHECK: SPIR kernel argument is a pointer to private address space
+
+define spir_kernel void @copy(float addrspace(1)* %out, float %x) nounwind {
+entry:
+  store float %x, float addrspace(1)* %out, align 4
+  ret void
+}
+
+!opencl.kernels = !{!0}
+!opencl.enable.FP_CONTRACT = !{}
+!opencl.spir.version = !{!6}
+!opencl.ocl.version = !{!6}
+!opencl.used.extensions = !{!7}
+!opencl.used.optional.core.features = !{!7}
+!opencl.compiler.options = !{!7}
+
+!0 = metadata !{void (float addrspace(1)*, float)* @copy, metadata !1, metadata !2, metadata !3, metadata !4, metadata !5}
+!1 = metadata !{metadata !"kernel_arg_addr_space", i32 1, i32 0}
+!2 = metadata !{metadata !"kernel_arg_access_qual", metadata !"none", metadata !"none"}
+!3 = metadata !{metadata !"kernel_arg_type", metadata !"float*", metadata !"float"}
+!4 = metadata !{metadata !"kernel_arg_type_qual", metadata !"", metadata !""}
+!5 = metadata !{metadata !"kernel_arg_base_type", metadata !"float*", metadata !"float"}
+!6 = metadata !{i32 1, i32 2}
+!7 = metadata !{}
@@ -0,0 +1,634 @@
+//===-- BitstreamWriterTest.cpp - Tests for the SPIR bitstream writer -----===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// The writer buffers 64 bits at a time and emits VBR values and arrays in
+// bulk. These tests check Emit64/EmitVBR/EmitVBR64 against a writer appending
+// one bit at a time, and arrays and blobs against the same records emitted one
+// field at a time with Emit/EmitVBR, at every bit alignment within the
+// stream. They also check that
+// blocks emitted by separate writers splice into the same bitstream as when
+// emitted in place, that streaming blocks to a file as they complete writes
+// the same bitstream as buffering it, that the block statistics count every
+// bit and second once, that profiled abbreviations are used for the records
+// they were selected for, and that strings are classified as when tested one
+// character at a time.
+//
+//===---------------------------------------------------------------------===//
+
+#include "encoder/BitstreamWriter.h"
+#include "encoder/LLVMBitCodes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+const unsigned BlockID = 8;
+const unsigned CodeLen = 4;
+const unsigned RecordCode = 3;
+
+BitCodeAbbrev *makeAbbrev(const BitCodeAbbrevOp &Payload,
+                          const BitCodeAbbrevOp *Elt) {
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(RecordCode));
+  Abbv->Add(Payload);
+  if (Elt)
+    Abbv->Add(*Elt);
+  return Abbv;
+}
+
+// Emits Lead bits of padding, so the record starts at any bit offset.
+void emitLead(BitstreamWriter &Stream, unsigned Lead) {
+  if (Lead)
+    Stream.Emit64(0x5555555555555555ULL >> (64 - Lead), Lead);
+}
+
+// Builds the expected bitstream one bit at a time, and VBR values one chunk
+// at a time.
+class ReferenceBits {
+  std::vector<bool> Bits;
+
+public:
+  void emit(uint64_t Val, unsigned NumBits) {
+    for (unsigned i = 0; i != NumBits; ++i)
+      Bits.push_back((Val >> i) & 1);
+  }
+
+  void emitVBR(uint64_t Val, unsigned NumBits) {
+    uint64_t Threshold = 1ULL << (NumBits - 1);
+    while (Val >= Threshold) {
+      emit((Val & (Threshold - 1)) | Threshold, NumBits);
+      Val >>= NumBits - 1;
+    }
+    emit(Val, NumBits);
+  }
+
+  // The bytes of the bitstream padded to a 32-bit word, as FlushToWord does.
+  void getBytes(SmallVectorImpl<char> &Bytes) const {
+    Bytes.assign((Bits.size() + 31) / 32 * 4, 0);
+    for (unsigned i = 0, e = Bits.size(); i != e; ++i)
+      if (Bits[i])
+        Bytes[i / 8] |= (char)(1 << (i % 8));
+  }
+};
+
+// Emits an array record with the bulk writer.
+void emitArray(SmallVectorImpl<char> &Buffer, const BitCodeAbbrevOp &Elt,
+               unsigned Lead, const SmallVectorImpl<uint64_t> &Elts,
+               StringRef Blob) {
+  BitstreamWriter Stream(Buffer);
+  Stream.EnterSubblock(BlockID, CodeLen);
+  unsigned Abbrev = Stream.EmitAbbrev(
+    makeAbbrev(BitCodeAbbrevOp(BitCodeAbbrevOp::Array), &Elt));
+  emitLead(Stream, Lead);
+  SmallVector<uint64_t, 64> Vals;
+  Vals.push_back(RecordCode);
+  if (Blob.data()) {
+    Stream.EmitRecordWithArray(Abbrev, Vals, Blob);
+  } else {
+    Vals.append(Elts.begin(), Elts.end());
+    Stream.EmitRecordWithAbbrev(Abbrev, Vals);
+  }
+  Stream.ExitBlock();
+}
+
+// Emits the same array record one field at a time.
+void emitArrayReference(SmallVectorImpl<char> &Buffer,
+                        const BitCodeAbbrevOp &Elt, unsigned Lead,
+                        const SmallVectorImpl<uint64_t> &Elts) {
+  BitstreamWriter Stream(Buffer);
+  Stream.EnterSubblock(BlockID, CodeLen);
+  unsigned Abbrev = Stream.EmitAbbrev(
+    makeAbbrev(BitCodeAbbrevOp(BitCodeAbbrevOp::Array), &Elt));
+  emitLead(Stream, Lead);
+  Stream.EmitCode(Abbrev);
+  Stream.EmitVBR(Elts.size(), 6);
+  for (unsigned i = 0, e = Elts.size(); i != e; ++i) {
+    if (Elt.getEncoding() == BitCodeAbbrevOp::Char6)
+      Stream.Emit(BitCodeAbbrevOp::EncodeChar6((char)Elts[i]), 6);
+    else if (Elt.getEncodingData())
+      Stream.Emit((uint32_t)Elts[i], (unsigned)Elt.getEncodingData());
+  }
+  Stream.ExitBlock();
+}
+
+// Emits a blob record with the bulk writer.
+void emitBlob(SmallVectorImpl<char> &Buffer, unsigned Lead, StringRef Blob) {
+  BitstreamWriter Stream(Buffer);
+  Stream.EnterSubblock(BlockID, CodeLen);
+  unsigned Abbrev = Stream.EmitAbbrev(
+    makeAbbrev(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob), 0));
+  emitLead(Stream, Lead);
+  SmallVector<uint64_t, 1> Vals;
+  Vals.push_back(RecordCode);
+  Stream.EmitRecordWithBlob(Abbrev, Vals, Blob);
+  Stream.ExitBlock();
+}
+
+// Emits the same blob record one byte at a time.
+void emitBlobReference(SmallVectorImpl<char> &Buffer, unsigned Lead,
+                       StringRef Blob) {
+  BitstreamWriter Stream(Buffer);
+  Stream.EnterSubblock(BlockID, CodeLen);
+  unsigned Abbrev = Stream.EmitAbbrev(
+    makeAbbrev(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob), 0));
+  emitLead(Stream, Lead);
+  Stream.EmitCode(Abbrev);
+  Stream.EmitVBR(Blob.size(), 6);
+  Stream.FlushToWord();
+  for (unsigned i = 0, e = Blob.size(); i != e; ++i)
+    Stream.Emit((unsigned char)Blob[i], 8);
+  while (Stream.GetCurrentBitNo() % 32)
+    Stream.Emit(0, 8);
+  Stream.ExitBlock();
+}
+
+bool sameBytes(const SmallVectorImpl<char> &A, const SmallVectorImpl<char> &B) {
+  return A.size() == B.size() &&
+         std::equal(A.begin(), A.end(), B.begin());
+}
+
+const char Chars[] =
+  "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789._";
+
+// Emits Val with EmitVBR, EmitVBR64 or Emit64 after Lead bits of padding,
+// followed by a few bits to check the state left in the writer.
+enum EmitKind { VBR, VBR64, Fixed64 };
+
+void emitValue(SmallVectorImpl<char> &Buffer, EmitKind Kind, unsigned Lead,
+               uint64_t Val, unsigned NumBits) {
+  BitstreamWriter Stream(Buffer);
+  emitLead(Stream, Lead);
+  if (Kind == VBR)
+    Stream.EmitVBR((uint32_t)Val, NumBits);
+  else if (Kind == VBR64)
+    Stream.EmitVBR64(Val, NumBits);
+  else
+    Stream.Emit64(Val, NumBits);
+  Stream.Emit(5, 3);
+  Stream.FlushToWord();
+}
+
+void emitValueReference(SmallVectorImpl<char> &Buffer, EmitKind Kind,
+                        unsigned Lead, uint64_t Val, unsigned NumBits) {
+  ReferenceBits Bits;
+  if (Lead)
+    Bits.emit(0x5555555555555555ULL >> (64 - Lead), Lead);
+  if (Kind == Fixed64)
+    Bits.emit(Val, NumBits);
+  else
+    Bits.emitVBR(Val, NumBits);
+  Bits.emit(5, 3);
+  Bits.getBytes(Buffer);
+}
+
+TEST(BitstreamWriterTest, VBR) {
+  for (unsigned Width = 2; Width <= 32; ++Width) {
+    // Values below, at and above the chunk threshold, values filling the
+    // largest encodings (32 chunks of 2 bits make exactly 64 bits), and
+    // values split over both halves of a 64-bit value.
+    uint64_t Threshold = 1ULL << (Width - 1);
+    SmallVector<uint64_t, 16> Vals;
+    Vals.push_back(0);
+    Vals.push_back(Threshold - 1);
+    Vals.push_back(Threshold);
+    Vals.push_back(2 * Threshold - 1);
+    Vals.push_back(0x7FFFFFFFULL);
+    Vals.push_back(0xFFFFFFFFULL);
+    Vals.push_back(0x100000000ULL);
+    Vals.push_back(~0ULL);
+    for (unsigned i = 1; i != 5; ++i)
+      Vals.push_back(0x9E3779B97F4A7C15ULL * i >> (i * 13));
+
+    for (unsigned v = 0, ve = Vals.size(); v != ve; ++v) {
+      uint64_t Val = Vals[v];
+      for (unsigned Lead = 0; Lead < 64; ++Lead) {
+        SmallVector<char, 64> Writer, Reference;
+        if ((uint32_t)Val == Val) {
+          emitValue(Writer, VBR, Lead, Val, Width);
+          emitValueReference(Reference, VBR, Lead, Val, Width);
+          ASSERT_TRUE(sameBytes(Writer, Reference))
+            << "EmitVBR width " << Width << " value " << Val << " lead "
+            << Lead;
+        }
+        Writer.clear();
+        Reference.clear();
+        emitValue(Writer, VBR64, Lead, Val, Width);
+        emitValueReference(Reference, VBR64, Lead, Val, Width);
+        ASSERT_TRUE(sameBytes(Writer, Reference))
+          << "EmitVBR64 width " << Width << " value " << Val << " lead "
+          << Lead;
+      }
+    }
+  }
+}
+
+TEST(BitstreamWriterTest, Emit64) {
+  for (unsigned Width = 1; Width <= 64; ++Width) {
+    uint64_t Vals[] = { 0, ~0ULL, 0x9E3779B97F4A7C15ULL,
+                        0x8000000000000001ULL };
+    for (unsigned v = 0; v != array_lengthof(Vals); ++v) {
+      uint64_t Val = Vals[v] >> (64 - Width);
+      for (unsigned Lead = 0; Lead < 64; ++Lead) {
+        SmallVector<char, 64> Writer, Reference;
+        emitValue(Writer, Fixed64, Lead, Val, Width);
+        emitValueReference(Reference, Fixed64, Lead, Val, Width);
+        ASSERT_TRUE(sameBytes(Writer, Reference))
+          << "width " << Width << " value " << Val << " lead " << Lead;
+      }
+    }
+  }
+}
+
+TEST(BitstreamWriterTest, FixedArray) {
+  for (unsigned Width = 0; Width <= 32; ++Width) {
+    BitCodeAbbrevOp Elt(BitCodeAbbrevOp::Fixed, Width);
+    for (unsigned Len = 0; Len <= 40; Len += 3) {
+      SmallVector<uint64_t, 64> Elts;
+      for (unsigned i = 0; i != Len; ++i) {
+        uint64_t V = 0x9E3779B97F4A7C15ULL * (i + Width);
+        Elts.push_back(Width ? V >> (64 - Width) : 0);
+      }
+      for (unsigned Lead = 0; Lead < 64; Lead += 7) {
+        SmallVector<char, 256> Bulk, Reference;
+        emitArray(Bulk, Elt, Lead, Elts, StringRef());
+        emitArrayReference(Reference, Elt, Lead, Elts);
+        EXPECT_TRUE(sameBytes(Bulk, Reference))
+          << "width " << Width << " length " << Len << " lead " << Lead;
+      }
+    }
+  }
+}
+
+TEST(BitstreamWriterTest, Char6Array) {
+  BitCodeAbbrevOp Elt(BitCodeAbbrevOp::Char6);
+  for (unsigned Len = 0; Len < sizeof(Chars); ++Len) {
+    SmallVector<uint64_t, 64> Elts(Chars, Chars + Len);
+    for (unsigned Lead = 0; Lead < 64; ++Lead) {
+      SmallVector<char, 256> Bulk, Reference;
+      emitArray(Bulk, Elt, Lead, Elts, StringRef());
+      emitArrayReference(Reference, Elt, Lead, Elts);
+      EXPECT_TRUE(sameBytes(Bulk, Reference))
+        << "length " << Len << " lead " << Lead;
+    }
+  }
+}
+
+TEST(BitstreamWriterTest, ArrayFromString) {
+  BitCodeAbbrevOp Char6(BitCodeAbbrevOp::Char6);
+  BitCodeAbbrevOp Fixed7(BitCodeAbbrevOp::Fixed, 7);
+  BitCodeAbbrevOp Fixed8(BitCodeAbbrevOp::Fixed, 8);
+  const BitCodeAbbrevOp *Encodings[] = { &Char6, &Fixed7, &Fixed8 };
+  for (unsigned Enc = 0; Enc != 3; ++Enc) {
+    for (unsigned Len = 0; Len < sizeof(Chars); Len += 5) {
+      StringRef Str(Chars, Len);
+      SmallVector<uint64_t, 64> Elts(Str.begin(), Str.end());
+      for (unsigned Lead = 0; Lead < 64; Lead += 3) {
+        SmallVector<char, 256> Bulk, Reference;
+        emitArray(Bulk, *Encodings[Enc], Lead, Elts, Str);
+        emitArrayReference(Reference, *Encodings[Enc], Lead, Elts);
+        EXPECT_TRUE(sameBytes(Bulk, Reference))
+          << "encoding " << Enc << " length " << Len << " lead " << Lead;
+      }
+    }
+  }
+}
+
+TEST(BitstreamWriterTest, Blob) {
+  for (unsigned Len = 0; Len < sizeof(Chars); ++Len) {
+    StringRef Blob(Chars, Len);
+    for (unsigned Lead = 0; Lead < 64; ++Lead) {
+      SmallVector<char, 256> Bulk, Reference;
+      emitBlob(Bulk, Lead, Blob);
+      emitBlobReference(Reference, Lead, Blob);
+      EXPECT_TRUE(sameBytes(Bulk, Reference))
+        << "length " << Len << " lead " << Lead;
+    }
+  }
+}
+
+// Emits a block using the BLOCKINFO abbrev of BlockID and a local abbrev.
+void emitFunctionBlock(BitstreamWriter &Stream, unsigned N) {
+  Stream.EnterSubblock(BlockID, CodeLen);
+  unsigned Local = Stream.EmitAbbrev(
+    makeAbbrev(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob), 0));
+  for (unsigned i = 0; i != N; ++i) {
+    SmallVector<uint64_t, 8> Vals;
+    Vals.push_back(RecordCode);
+    for (unsigned j = 0; j != i % 7; ++j)
+      Vals.push_back(i * 31 + j);
+    Stream.EmitRecordWithAbbrev(bitc::FIRST_APPLICATION_ABBREV, Vals);
+    Vals.resize(1);
+    Stream.EmitRecordWithBlob(Local, Vals, StringRef(Chars, i % 13));
+    Stream.EmitRecord(RecordCode + i, Vals);
+  }
+  Stream.ExitBlock();
+}
+
+void emitModuleHeader(BitstreamWriter &Stream) {
+  Stream.EnterBlockInfoBlock(2);
+  BitCodeAbbrevOp Elt(BitCodeAbbrevOp::VBR, 6);
+  Stream.EmitBlockInfoAbbrev(BlockID,
+    makeAbbrev(BitCodeAbbrevOp(BitCodeAbbrevOp::Array), &Elt));
+  Stream.ExitBlock();
+  Stream.EnterSubblock(BlockID + 1, 3);
+}
+
+TEST(BitstreamWriterTest, SplicedBlocks) {
+  const unsigned NumBlocks = 20;
+  SmallVector<char, 1024> InPlace, Spliced;
+  {
+    BitstreamWriter Stream(InPlace);
+    emitModuleHeader(Stream);
+    for (unsigned i = 0; i != NumBlocks; ++i)
+      emitFunctionBlock(Stream, i * 5);
+    Stream.ExitBlock();
+  }
+  {
+    BitstreamWriter Stream(Spliced);
+    emitModuleHeader(Stream);
+    for (unsigned i = 0; i != NumBlocks; ++i) {
+      SmallVector<char, 256> Block;
+      BitstreamWriter Writer(Block);
+      Writer.InitSplice(Stream);
+      emitFunctionBlock(Writer, i * 5);
+      Stream.SpliceBlocks(Block);
+    }
+    Stream.ExitBlock();
+  }
+  EXPECT_TRUE(sameBytes(InPlace, Spliced));
+}
+
+// Emits the blocks of the module, splicing every other function block.
+void emitModule(BitstreamWriter &Stream, unsigned NumBlocks) {
+  emitModuleHeader(Stream);
+  for (unsigned i = 0; i != NumBlocks; ++i) {
+    if (i % 2) {
+      emitFunctionBlock(Stream, i * 5);
+      continue;
+    }
+    SmallVector<char, 256> Block;
+    BitstreamWriter Writer(Block);
+    Writer.InitSplice(Stream);
+    emitFunctionBlock(Writer, i * 5);
+    Stream.SpliceBlocks(Block);
+  }
+  Stream.ExitBlock();
+}
+
+std::string readFile(StringRef Path) {
+  std::ifstream In(Path.str().c_str(), std::ios::in | std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(In),
+                     std::istreambuf_iterator<char>());
+}
+
+TEST(BitstreamWriterTest, StreamedBlocks) {
+  const unsigned NumBlocks = 20;
+  SmallVector<char, 1024> Buffered;
+  {
+    BitstreamWriter Stream(Buffered);
+    emitModule(Stream, NumBlocks);
+  }
+
+  // The file starts with other data, so the bitstream is not at offset 0 and
+  // backpatching the size of a flushed block seeks relative to its start.
+  // The module block is always backpatched after its function blocks were
+  // flushed.
+  const std::string Prefix = "prefix";
+  const size_t Thresholds[] = { 0, 1, 100, 1000, 1 << 20 };
+  for (unsigned t = 0; t != array_lengthof(Thresholds); ++t) {
+    int FD;
+    SmallString<128> Path;
+    ASSERT_FALSE(sys::fs::createTemporaryFile("BitstreamWriterTest", "bc", FD,
+                                              Path));
+    uint64_t FlushedBeforeEnd;
+    {
+      raw_fd_ostream File(FD, true);
+      File << Prefix;
+      SmallVector<char, 0> Buffer;
+      BitstreamWriter Stream(Buffer, File, Thresholds[t]);
+      emitModule(Stream, NumBlocks);
+      FlushedBeforeEnd = File.tell() - Prefix.size();
+      Stream.FlushToFile();
+      EXPECT_TRUE(Buffer.empty());
+    }
+    std::string Streamed = readFile(Path);
+    std::remove(Path.c_str());
+
+    // Blocks are flushed as they complete once the threshold is reached, and
+    // not at all below it.
+    if (Thresholds[t] < Buffered.size())
+      EXPECT_LT(0U, FlushedBeforeEnd) << "threshold " << Thresholds[t];
+    else
+      EXPECT_EQ(0U, FlushedBeforeEnd) << "threshold " << Thresholds[t];
+    EXPECT_TRUE(Streamed == Prefix + std::string(Buffered.begin(),
+                                                 Buffered.end()))
+      << "threshold " << Thresholds[t];
+  }
+}
+
+TEST(BitstreamWriterTest, BlockStats) {
+  const unsigned NumBlocks = 20;
+  SmallVector<char, 1024> InPlace, Spliced;
+  SPIR::EncoderStats InPlaceStats, SplicedStats;
+  {
+    BitstreamWriter Stream(InPlace);
+    Stream.SetStats(&InPlaceStats);
+    emitModuleHeader(Stream);
+    for (unsigned i = 0; i != NumBlocks; ++i)
+      emitFunctionBlock(Stream, i * 5);
+    Stream.ExitBlock();
+  }
+  double SplicedSeconds = 0, SplicingSeconds = 0;
+  {
+    double Start = BitstreamWriter::GetTime();
+    BitstreamWriter Stream(Spliced);
+    Stream.SetStats(&SplicedStats);
+    emitModuleHeader(Stream);
+    for (unsigned i = 0; i != NumBlocks; ++i) {
+      SmallVector<char, 256> Block;
+      double BlockStart = BitstreamWriter::GetTime();
+      BitstreamWriter Writer(Block);
+      Writer.InitSplice(Stream);
+      Writer.SetStats(&SplicedStats);
+      emitFunctionBlock(Writer, i * 5);
+      double Seconds = BitstreamWriter::GetTime() - BlockStart;
+      SplicingSeconds += Seconds;
+      Stream.SpliceBlocks(Block, Seconds);
+    }
+    Stream.ExitBlock();
+    SplicedSeconds = BitstreamWriter::GetTime() - Start;
+  }
+
+  // Each function block has i * 5 iterations of three records, two of them
+  // abbreviated.
+  unsigned NumRecords = 0;
+  for (unsigned i = 0; i != NumBlocks; ++i)
+    NumRecords += i * 5 * 3;
+  const SPIR::BlockStats &Function = InPlaceStats.get(BlockID);
+  EXPECT_EQ(NumBlocks, Function.NumBlocks);
+  EXPECT_EQ(NumRecords, Function.NumRecords);
+  EXPECT_EQ(NumRecords / 3 * 2, Function.NumAbbreviated);
+
+  // Every bit is counted in exactly one block, whether the function blocks
+  // are spliced or not.
+  uint64_t NumBits = 0;
+  for (unsigned ID = 0; ID != InPlaceStats.Blocks.size(); ++ID) {
+    const SPIR::BlockStats &A = InPlaceStats.get(ID);
+    const SPIR::BlockStats &B = SplicedStats.get(ID);
+    EXPECT_EQ(A.NumBlocks, B.NumBlocks) << "block " << ID;
+    EXPECT_EQ(A.NumBits, B.NumBits) << "block " << ID;
+    EXPECT_EQ(A.NumRecords, B.NumRecords) << "block " << ID;
+    EXPECT_EQ(A.NumAbbreviated, B.NumAbbreviated) << "block " << ID;
+    NumBits += A.NumBits;
+  }
+  EXPECT_EQ(InPlace.size() * 8, NumBits);
+  EXPECT_EQ(1U, InPlaceStats.get(bitc::BLOCKINFO_BLOCK_ID).NumBlocks);
+  EXPECT_EQ(1U, InPlaceStats.get(BlockID + 1).NumBlocks);
+
+  // The time spent emitting the spliced blocks is not counted in the block
+  // they are spliced into, so no time is counted twice.
+  const double Slack = 1e-6;
+  EXPECT_LE(SplicedStats.get(BlockID).Seconds, SplicingSeconds + Slack);
+  EXPECT_LE(SplicedStats.get(BlockID + 1).Seconds,
+            SplicedSeconds - SplicingSeconds + Slack);
+  double Seconds = 0;
+  for (unsigned ID = 0; ID != SplicedStats.Blocks.size(); ++ID)
+    Seconds += SplicedStats.get(ID).Seconds;
+  EXPECT_LE(Seconds, SplicedSeconds + Slack);
+}
+
+// Emits a block of unabbreviated records of a few shapes: a literal leading
+// operand, a variable number of small operands, and Char6 strings.
+void emitProfiledBlock(BitstreamWriter &Stream, unsigned CodeLen,
+                       const std::vector<unsigned> *Abbrevs, unsigned N) {
+  Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, CodeLen);
+  for (unsigned i = 0; i != N; ++i) {
+    SmallVector<uint64_t, 16> Vals[3];
+    Vals[0].push_back(0);
+    Vals[0].push_back(i % 100);
+    for (unsigned j = 0; j != i % 5; ++j)
+      Vals[0].push_back(i * 7 + j);
+    Vals[1].push_back(i % 2 ? 3 : 5);
+    Vals[1].push_back(i * 13 % 1000);
+    Vals[2].push_back(i);
+    Vals[2].append(Chars, Chars + i % 20);
+    for (unsigned Code = 1; Code != 4; ++Code) {
+      if (Abbrevs)
+        Stream.EmitRecord(Code, Vals[Code - 1], (*Abbrevs)[Code]);
+      else
+        Stream.EmitRecord(Code, Vals[Code - 1]);
+    }
+  }
+  Stream.ExitBlock();
+}
+
+TEST(BitstreamWriterTest, ProfiledAbbrevs) {
+  const unsigned NumBlocks = 10;
+  SmallVector<char, 1024> Unprofiled;
+  SPIR::AbbrevProfile Profile;
+  {
+    BitstreamWriter Stream(Unprofiled);
+    Stream.SetAbbrevProfile(&Profile);
+    for (unsigned i = 0; i != NumBlocks; ++i)
+      emitProfiledBlock(Stream, CodeLen, 0, i * 10);
+  }
+
+  std::vector<SPIR::AbbrevProfile::BlockAbbrevs> Selected;
+  Profile.selectAbbrevs(Selected);
+  ASSERT_EQ(1U, Selected.size());
+  const SPIR::AbbrevProfile::BlockAbbrevs &Block = Selected[0];
+  EXPECT_EQ((unsigned)bitc::FUNCTION_BLOCK_ID, Block.BlockID);
+  EXPECT_EQ(3U, Block.Abbrevs.size());
+
+  // Records are emitted with the abbreviation selected for their code, as
+  // if it had been given explicitly.
+  SmallVector<char, 1024> Profiled, Explicit;
+  SPIR::EncoderStats Stats;
+  {
+    BitstreamWriter Stream(Profiled);
+    Stream.SetStats(&Stats);
+    Stream.EnterBlockInfoBlock(2);
+    for (unsigned i = 0; i != Block.Abbrevs.size(); ++i) {
+      Block.Abbrevs[i].Abbrev->addRef();
+      unsigned AbbrevID = Stream.EmitBlockInfoAbbrev(Block.BlockID,
+                                                     Block.Abbrevs[i].Abbrev);
+      Stream.SetRecordAbbrev(Block.BlockID, Block.Abbrevs[i].Code, AbbrevID);
+    }
+    Stream.SetMinCodeLen(Block.BlockID, Block.CodeLen);
+    Stream.ExitBlock();
+    for (unsigned i = 0; i != NumBlocks; ++i)
+      emitProfiledBlock(Stream, CodeLen, 0, i * 10);
+  }
+  {
+    BitstreamWriter Stream(Explicit);
+    std::vector<unsigned> Abbrevs(4);
+    Stream.EnterBlockInfoBlock(2);
+    for (unsigned i = 0; i != Block.Abbrevs.size(); ++i)
+      Abbrevs[Block.Abbrevs[i].Code] =
+        Stream.EmitBlockInfoAbbrev(Block.BlockID, Block.Abbrevs[i].Abbrev);
+    Stream.ExitBlock();
+    for (unsigned i = 0; i != NumBlocks; ++i)
+      emitProfiledBlock(Stream, std::max(CodeLen, Block.CodeLen), &Abbrevs,
+                        i * 10);
+  }
+  EXPECT_TRUE(sameBytes(Profiled, Explicit));
+  EXPECT_LT(Profiled.size(), Unprofiled.size());
+
+  const SPIR::BlockStats &Function = Stats.get(bitc::FUNCTION_BLOCK_ID);
+  EXPECT_EQ(Function.NumRecords, Function.NumAbbreviated);
+}
+
+// Classifies Str one character at a time.
+BitCodeAbbrevOp::StringClass classifyChars(StringRef Str) {
+  bool AllChar6 = true;
+  for (unsigned i = 0, e = Str.size(); i != e; ++i) {
+    if ((unsigned char)Str[i] & 128)
+      return BitCodeAbbrevOp::Fixed8String;
+    AllChar6 = AllChar6 && BitCodeAbbrevOp::isChar6(Str[i]);
+  }
+  return AllChar6 ? BitCodeAbbrevOp::Char6String
+                  : BitCodeAbbrevOp::Fixed7String;
+}
+
+TEST(BitstreamWriterTest, ClassifyString) {
+  // Every character value at every position of strings that end in the word
+  // loop, the byte loop, or both, with every alignment of the string.
+  char Storage[32];
+  for (unsigned Len = 1; Len != 20; ++Len)
+    for (unsigned Offset = 0; Offset != 8; ++Offset)
+      for (unsigned Pos = 0; Pos != Len; ++Pos)
+        for (unsigned C = 0; C != 256; ++C) {
+          char *Str = Storage + Offset;
+          memset(Str, 'a' + Pos % 26, Len);
+          Str[Pos] = (char)C;
+          StringRef S(Str, Len);
+          ASSERT_EQ(classifyChars(S), BitCodeAbbrevOp::ClassifyString(S))
+            << "character " << C << " at " << Pos << " of " << Len;
+        }
+
+  EXPECT_EQ(BitCodeAbbrevOp::Char6String, BitCodeAbbrevOp::ClassifyString(""));
+  EXPECT_EQ(BitCodeAbbrevOp::Char6String,
+            BitCodeAbbrevOp::ClassifyString("struct.opencl_image2d_t"));
+  EXPECT_EQ(BitCodeAbbrevOp::Fixed7String,
+            BitCodeAbbrevOp::ClassifyString("spir-unknown-unknown"));
+  EXPECT_EQ(BitCodeAbbrevOp::Fixed8String,
+            BitCodeAbbrevOp::ClassifyString("kernel_\xe2\x82\xac_name"));
+}
+
+} // end anonymous namespace
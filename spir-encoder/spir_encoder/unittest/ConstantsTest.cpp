@@ -0,0 +1,72 @@
+//===-- ConstantsTest.cpp - Tests for the SPIR constant block layout ------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// With -spir-encoder-compact-constants, the arrays and vectors of integers and
+// floating point values of the module are written as fixed width arrays when
+// that is smaller. These tests check which of them are packed, that the
+// module gets smaller, and that it reads back to the same constants.
+//
+//===---------------------------------------------------------------------===//
+
+#include "EncoderTestUtils.h"
+#include "encoder/SpirEncoderStats.h"
+
+using namespace llvm;
+using namespace SPIRTest;
+
+namespace {
+
+const char ModuleText[] =
+  "target triple = \"spir-unknown-unknown\"\n"
+  "\n"
+  // Packed as 32-bit floats.
+  "@flut = addrspace(2) constant [8 x float] [float 1.0, float 0.5,\n"
+  "  float 0.25, float 2.0, float 4.0, float 1.5, float 3.0, float 0.75]\n"
+  // Packed as 16-bit integers.
+  "@slut = addrspace(2) constant [6 x i16] [i16 1024, i16 2048, i16 4096,\n"
+  "  i16 8192, i16 16384, i16 30000]\n"
+  // Packed as 32-bit floats.
+  "@vec = addrspace(2) constant <4 x float> <float 1.0, float 2.0,\n"
+  "  float 3.0, float 4.0>\n"
+  // Smaller unabbreviated.
+  "@small = addrspace(2) constant [4 x i32] [i32 1, i32 2, i32 3, i32 4]\n"
+  // Wider than the widest abbrev.
+  "@big = addrspace(2) constant [2 x i64] [i64 -1, i64 1]\n"
+  "\n"
+  "define spir_kernel void @kernel() {\n"
+  "entry:\n"
+  "  ret void\n"
+  "}\n";
+
+TEST(ConstantsTest, CompactConstants) {
+  LLVMContext Context;
+  Module *M = parseModule(ModuleText, Context);
+  ASSERT_TRUE(M != 0);
+
+  SPIR::EncoderStats PlainStats, PackedStats;
+  std::string Plain = encode(M, &PlainStats);
+  setEncoderOption("spir-encoder-compact-constants", true);
+  std::string Packed = encode(M, &PackedStats);
+  setEncoderOption("spir-encoder-compact-constants", false);
+
+  EXPECT_EQ(5U, PlainStats.Constants.NumData);
+  EXPECT_EQ(0U, PlainStats.Constants.NumPackedData);
+  EXPECT_EQ(5U, PackedStats.Constants.NumData);
+  EXPECT_EQ(3U, PackedStats.Constants.NumPackedData);
+  EXPECT_GT(PackedStats.Constants.PackedDataBitsSaved,
+            PackedStats.Constants.DataAbbrevBits);
+  EXPECT_EQ(PlainStats.Constants.NumSetTypes,
+            PackedStats.Constants.NumSetTypes);
+  EXPECT_LT(Packed.size(), Plain.size());
+
+  expectRoundTrip(*M, Packed);
+  delete M;
+}
+
+} // end anonymous namespace
@@ -0,0 +1,216 @@
+//===-- DeterministicOutputTest.cpp - Tests for reproducible SPIR output --===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// With -spir-encoder-deterministic, equal modules must be encoded to the same
+// bytes, whatever the layout of their symbol tables. These tests encode a
+// module and a copy whose symbol tables grew and shrank back, and compare the
+// results. They also check that encoding function bodies on several threads
+// gives the same bytes as on one, the module hash written with
+// -spir-encoder-module-hash, and that LLVM readers skip the block holding it.
+//
+//===---------------------------------------------------------------------===//
+
+#include "EncoderTestUtils.h"
+
+#include "llvm/ADT/Twine.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace SPIRTest;
+
+namespace {
+
+const char ModuleText[] =
+  "target triple = \"spir-unknown-unknown\"\n"
+  "\n"
+  "@lut = addrspace(2) constant [4 x i32] [i32 1, i32 2, i32 3, i32 4]\n"
+  "@counter = addrspace(1) global i32 0, align 4\n"
+  "\n"
+  "define spir_func i32 @helper(i32 %x, i32 %y) {\n"
+  "entry:\n"
+  "  %sum = add i32 %x, %y\n"
+  "  %cmp = icmp sgt i32 %sum, 0\n"
+  "  br i1 %cmp, label %pos, label %neg\n"
+  "pos:\n"
+  "  %twice = shl i32 %sum, 1\n"
+  "  br label %done\n"
+  "neg:\n"
+  "  %negated = sub i32 0, %sum\n"
+  "  br label %done\n"
+  "done:\n"
+  "  %result = phi i32 [ %twice, %pos ], [ %negated, %neg ]\n"
+  "  ret i32 %result\n"
+  "}\n"
+  "\n"
+  "define spir_kernel void @kernel(i32 addrspace(1)* %out, i32 %n) {\n"
+  "entry:\n"
+  "  %idx = getelementptr [4 x i32] addrspace(2)* @lut, i32 0, i32 %n\n"
+  "  %val = load i32 addrspace(2)* %idx, align 4\n"
+  "  %res = call spir_func i32 @helper(i32 %val, i32 %n)\n"
+  "  store i32 %res, i32 addrspace(1)* %out, align 4\n"
+  "  ret void\n"
+  "}\n"
+  "\n"
+  "!opencl.kernels = !{!0}\n"
+  "!0 = metadata !{void (i32 addrspace(1)*, i32)* @kernel}\n";
+
+// Adds names to the symbol tables of M and removes them again. The tables
+// keep the buckets they grew, so they list the names of M in another order.
+void growSymbolTables(Module *M) {
+  const unsigned NumNames = 256;
+  std::vector<GlobalVariable *> Globals;
+  for (unsigned i = 0; i != NumNames; ++i)
+    Globals.push_back(new GlobalVariable(*M, Type::getInt32Ty(M->getContext()),
+                                         false, GlobalValue::ExternalLinkage,
+                                         0, "tmp" + Twine(i)));
+  for (unsigned i = 0; i != NumNames; ++i)
+    Globals[i]->eraseFromParent();
+
+  for (Module::iterator F = M->begin(), E = M->end(); F != E; ++F) {
+    if (F->isDeclaration())
+      continue;
+    std::vector<BasicBlock *> Blocks;
+    for (unsigned i = 0; i != NumNames; ++i)
+      Blocks.push_back(BasicBlock::Create(M->getContext(), "tmp" + Twine(i),
+                                          F));
+    for (unsigned i = 0; i != NumNames; ++i)
+      Blocks[i]->eraseFromParent();
+  }
+}
+
+// Returns a module of NumFunctions functions, each with its own constants,
+// function-local metadata and instruction metadata, and calling the previous
+// one, so that the globals and functions have uses in many bodies.
+std::string functionsModule(unsigned NumFunctions) {
+  std::string Text;
+  raw_string_ostream OS(Text);
+  OS << "target triple = \"spir-unknown-unknown\"\n"
+        "\n"
+        "@counter = addrspace(1) global i32 0, align 4\n"
+        "\n"
+        "declare void @llvm.dbg.value(metadata, i64, metadata) nounwind "
+        "readnone\n";
+  for (unsigned i = 0; i != NumFunctions; ++i) {
+    OS << "\n"
+          "define spir_func float @f" << i << "(i32 %x, <2 x float> %v) {\n"
+          "entry:\n"
+          "  %c = load i32 addrspace(1)* @counter, align 4\n"
+          "  %s = add i32 %x, " << 1000 + i * 37 << "\n"
+          "  %t = xor i32 %s, %c\n"
+          "  store i32 %t, i32 addrspace(1)* @counter, align 4\n"
+          "  call void @llvm.dbg.value(metadata !{i32 %t}, i64 0, "
+          "metadata !0)\n"
+          "  %f = sitofp i32 %t to float\n"
+          "  %w = fmul <2 x float> %v, <float " << i << ".0, float 0.5>\n"
+          "  %e = extractelement <2 x float> %w, i32 1\n"
+          "  %r = fadd float %f, %e, !fpmath !1\n";
+    if (i)
+      OS << "  %p = call spir_func float @f" << i - 1
+         << "(i32 %t, <2 x float> %v)\n"
+            "  %q = fadd float %r, %p\n"
+            "  ret float %q\n";
+    else
+      OS << "  ret float %r\n";
+    OS << "}\n";
+  }
+  OS << "\n"
+        "!0 = metadata !{i32 786688, metadata !\"t\"}\n"
+        "!1 = metadata !{float 2.5}\n";
+  return OS.str();
+}
+
+class DeterministicOutputTest : public ::testing::Test {
+protected:
+  virtual void TearDown() {
+    setEncoderOption("spir-encoder-deterministic", false);
+    setEncoderOption("spir-encoder-module-hash", false);
+    setEncoderOption("spir-encoder-threads", 1U);
+    setEncoderOption("enable-bc-uselist-preserve", false);
+  }
+};
+
+TEST_F(DeterministicOutputTest, SymbolTableLayout) {
+  setEncoderOption("spir-encoder-deterministic", true);
+
+  LLVMContext Context;
+  Module *A = parseModule(ModuleText, Context);
+  Module *B = parseModule(ModuleText, Context);
+  ASSERT_TRUE(A && B);
+  growSymbolTables(B);
+
+  std::string EncodedA = encode(A);
+  EXPECT_FALSE(EncodedA.empty());
+  EXPECT_TRUE(EncodedA == encode(B));
+  EXPECT_TRUE(EncodedA == encode(A));
+
+  delete A;
+  delete B;
+}
+
+TEST_F(DeterministicOutputTest, FunctionThreads) {
+  // Enough functions for several batches of function blocks on 4 threads.
+  LLVMContext Context;
+  Module *M = parseModule(functionsModule(300), Context);
+  ASSERT_TRUE(M != 0);
+
+  for (unsigned UseLists = 0; UseLists != 2; ++UseLists) {
+    setEncoderOption("enable-bc-uselist-preserve", UseLists != 0);
+    setEncoderOption("spir-encoder-threads", 1U);
+    std::string Serial = encode(M);
+    setEncoderOption("spir-encoder-threads", 4U);
+    std::string Parallel = encode(M);
+    EXPECT_FALSE(Serial.empty());
+    EXPECT_TRUE(Serial == Parallel) << "use-lists " << UseLists;
+  }
+
+  delete M;
+}
+
+TEST_F(DeterministicOutputTest, ModuleHash) {
+  LLVMContext Context;
+  Module *A = parseModule(ModuleText, Context);
+  Module *B = parseModule(ModuleText, Context);
+  ASSERT_TRUE(A && B);
+  growSymbolTables(B);
+
+  // Without the option there is no hash to read.
+  uint32_t HashA[4], HashB[4];
+  EXPECT_FALSE(SPIR::ReadModuleHash(encode(A), HashA));
+
+  // The hash makes the output deterministic, and keys it.
+  setEncoderOption("spir-encoder-module-hash", true);
+  std::string EncodedA = encode(A);
+  ASSERT_TRUE(SPIR::ReadModuleHash(EncodedA, HashA));
+  ASSERT_TRUE(SPIR::ReadModuleHash(encode(B), HashB));
+  EXPECT_TRUE(std::equal(HashA, HashA + 4, HashB));
+
+  cast<GlobalVariable>(B->getNamedValue("counter"))->setInitializer(
+    ConstantInt::get(Type::getInt32Ty(Context), 1));
+  ASSERT_TRUE(SPIR::ReadModuleHash(encode(B), HashB));
+  EXPECT_FALSE(std::equal(HashA, HashA + 4, HashB));
+
+  // LLVM readers skip the hash block.
+  Module *Parsed = parseModule(EncodedA, Context);
+  ASSERT_TRUE(Parsed != 0);
+  EXPECT_TRUE(Parsed->getFunction("kernel") != 0);
+
+  delete Parsed;
+  delete A;
+  delete B;
+}
+
+} // end anonymous namespace
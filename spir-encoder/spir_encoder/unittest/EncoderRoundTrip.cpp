@@ -0,0 +1,105 @@
+//===-- EncoderRoundTrip.cpp - Round-trip checker for the SPIR encoder ----===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Encodes each module of a corpus, reads the encoded module back in another
+// context, and compares the two structurally: types, globals, functions,
+// instructions and metadata. The encoder options, such as
+// -spir-encoder-compact-constants, can be given on the command line to check
+// the writer paths they enable.
+//
+// Usage: SpirEncoderRoundTrip [-j <threads>] [-max-differences <n>]
+//                             [encoder options] <input files>...
+//
+//===---------------------------------------------------------------------===//
+
+#include "ModuleComparator.h"
+#include "encoder/SpirBitcodeWriter.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+static cl::list<std::string>
+InputFilenames(cl::Positional, cl::OneOrMore,
+               cl::desc("<input bitcode or assembly files>"));
+static cl::opt<unsigned>
+Threads("j", cl::desc("Number of threads comparing function bodies, 0 for "
+                      "one per hardware thread (default = 0)"),
+        cl::init(0));
+static cl::opt<unsigned>
+MaxDifferences("max-differences",
+               cl::desc("Number of differences printed for each module "
+                        "(default = 10)"),
+               cl::init(10));
+
+/// Encode M and parse the encoded module in Context. Returns null, after
+/// printing an error, if it can't be parsed.
+static Module *RoundTrip(const Module *M, LLVMContext &Context) {
+  SmallVector<char, 0> Encoded;
+  {
+    raw_svector_ostream OS(Encoded);
+    SPIR::WriteBitcodeToFile_SPIR(M, OS);
+  }
+
+  SMDiagnostic Err;
+  Module *Parsed = ParseIR(MemoryBuffer::getMemBuffer(
+    StringRef(Encoded.data(), Encoded.size()), "", false), Err, Context);
+  if (!Parsed)
+    errs() << M->getModuleIdentifier() << ": cannot parse the encoded module: "
+           << Err.getMessage() << "\n";
+  return Parsed;
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "SPIR encoder round-trip checker\n");
+
+  unsigned NumFailed = 0;
+  for (unsigned i = 0, e = InputFilenames.size(); i != e; ++i) {
+    LLVMContext Context, EncodedContext;
+    SMDiagnostic Err;
+    Module *M = ParseIRFile(InputFilenames[i], Err, Context);
+    if (!M) {
+      Err.print(argv[0], errs());
+      ++NumFailed;
+      continue;
+    }
+
+    Module *Encoded = RoundTrip(M, EncodedContext);
+    if (!Encoded) {
+      delete M;
+      ++NumFailed;
+      continue;
+    }
+
+    std::vector<std::string> Differences;
+    if (SPIRTest::ModuleComparator(*M, *Encoded).compare(Threads,
+                                                         Differences)) {
+      outs() << InputFilenames[i] << ": OK\n";
+    } else {
+      outs() << InputFilenames[i] << ": " << Differences.size()
+             << " differences\n";
+      for (unsigned d = 0; d != Differences.size() && d != MaxDifferences; ++d)
+        outs() << "  " << Differences[d] << "\n";
+      ++NumFailed;
+    }
+    delete Encoded;
+    delete M;
+  }
+
+  outs() << InputFilenames.size() - NumFailed << " of "
+         << InputFilenames.size() << " modules round-trip\n";
+  return NumFailed ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+//===-- EncoderSizeBench.cpp - Size benchmark for the SPIR encoder --------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Compares the bitcode produced for a corpus of SPIR modules with the fixed
+// BLOCKINFO abbreviations and with abbreviations fitted to each module
+// (-spir-encoder-profile-abbrevs). For each module the benchmark reports the
+// encoded size, the time to encode it, and the time to parse the encoded
+// module back, which accounts for the cost of the extra abbreviations on the
+// reader side. Columns starting with P are for the profiled abbreviations.
+//
+// Usage: SpirEncoderSizeBench [-reps <n>] <bitcode file>...
+//
+//===---------------------------------------------------------------------===//
+
+#include "encoder/SpirBitcodeWriter.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+static cl::list<std::string>
+InputFilenames(cl::Positional, cl::OneOrMore,
+               cl::desc("<input bitcode files>"));
+static cl::opt<unsigned>
+Reps("reps", cl::desc("Number of times each module is encoded and parsed "
+                      "(default = 10)"),
+     cl::init(10));
+
+namespace {
+/// Size and timing of a module encoded with one abbreviation setting.
+struct Result {
+  Result() : Bytes(0), EncodeSeconds(0), ReadSeconds(0) {}
+
+  uint64_t Bytes;
+  double EncodeSeconds;
+  double ReadSeconds;
+};
+}
+
+static double Now() {
+  sys::TimeValue T = sys::TimeValue::now();
+  return T.seconds() + T.nanoseconds() / 1e9;
+}
+
+/// Encode M Reps times, and parse the encoded module back Reps times.
+/// Returns false if the encoded module could not be parsed.
+static bool Measure(const Module *M, Result &R) {
+  SmallVector<char, 0> Encoded;
+  double Start = Now();
+  for (unsigned i = 0; i != Reps; ++i) {
+    Encoded.clear();
+    raw_svector_ostream OS(Encoded);
+    SPIR::WriteBitcodeToFile_SPIR(M, OS);
+  }
+  R.EncodeSeconds += (Now() - Start) / Reps;
+  R.Bytes += Encoded.size();
+
+  Start = Now();
+  for (unsigned i = 0; i != Reps; ++i) {
+    LLVMContext Context;
+    SMDiagnostic Err;
+    Module *Parsed = ParseIR(MemoryBuffer::getMemBuffer(
+      StringRef(Encoded.data(), Encoded.size()), "", false), Err, Context);
+    if (!Parsed) {
+      errs() << M->getModuleIdentifier() << ": cannot parse the encoded module: "
+             << Err.getMessage() << "\n";
+      return false;
+    }
+    delete Parsed;
+  }
+  R.ReadSeconds += (Now() - Start) / Reps;
+  return true;
+}
+
+static void PrintRow(StringRef Name, const Result &Fixed,
+                     const Result &Profiled) {
+  outs() << format("%-32s", Name.str().c_str())
+         << format(" %10llu %10llu", (unsigned long long)Fixed.Bytes,
+                   (unsigned long long)Profiled.Bytes)
+         << format(" %6.1f%%", Fixed.Bytes ?
+                   100.0 * Profiled.Bytes / Fixed.Bytes : 0.0)
+         << format(" %9.3f %9.3f", Fixed.EncodeSeconds * 1000,
+                   Profiled.EncodeSeconds * 1000)
+         << format(" %9.3f %9.3f\n", Fixed.ReadSeconds * 1000,
+                   Profiled.ReadSeconds * 1000);
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "SPIR encoder size benchmark\n");
+  if (Reps == 0)
+    Reps = 1;
+
+  // The abbreviation setting is the encoder's command line option.
+  StringMap<cl::Option *> Options;
+  cl::getRegisteredOptions(Options);
+  cl::opt<bool> *ProfileAbbrevs = static_cast<cl::opt<bool> *>(
+    Options.lookup("spir-encoder-profile-abbrevs"));
+  if (!ProfileAbbrevs) {
+    errs() << argv[0] << ": the encoder has no -spir-encoder-profile-abbrevs "
+              "option\n";
+    return 1;
+  }
+
+  outs() << "Module                                Fixed   Profiled   Ratio"
+            "   Enc(ms)  PEnc(ms)  Read(ms) PRead(ms)\n";
+  Result TotalFixed, TotalProfiled;
+  int Status = 0;
+  for (unsigned i = 0, e = InputFilenames.size(); i != e; ++i) {
+    LLVMContext Context;
+    SMDiagnostic Err;
+    Module *M = ParseIRFile(InputFilenames[i], Err, Context);
+    if (!M) {
+      Err.print(argv[0], errs());
+      Status = 1;
+      continue;
+    }
+
+    Result Fixed, Profiled;
+    ProfileAbbrevs->setValue(false);
+    bool OK = Measure(M, Fixed);
+    ProfileAbbrevs->setValue(true);
+    OK = OK && Measure(M, Profiled);
+    delete M;
+    if (!OK) {
+      Status = 1;
+      continue;
+    }
+
+    PrintRow(InputFilenames[i], Fixed, Profiled);
+    TotalFixed.Bytes += Fixed.Bytes;
+    TotalFixed.EncodeSeconds += Fixed.EncodeSeconds;
+    TotalFixed.ReadSeconds += Fixed.ReadSeconds;
+    TotalProfiled.Bytes += Profiled.Bytes;
+    TotalProfiled.EncodeSeconds += Profiled.EncodeSeconds;
+    TotalProfiled.ReadSeconds += Profiled.ReadSeconds;
+  }
+  PrintRow("Total", TotalFixed, TotalProfiled);
+  return Status;
+}
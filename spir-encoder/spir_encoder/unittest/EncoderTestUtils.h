@@ -0,0 +1,87 @@
+//===-- EncoderTestUtils.h - Helpers for the SPIR encoder tests -*- C++ -*-===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Helpers for the tests that encode whole modules.
+//
+//===---------------------------------------------------------------------===//
+
+#ifndef SPIR_ENCODER_TEST_UTILS_H
+#define SPIR_ENCODER_TEST_UTILS_H
+
+#include "ModuleComparator.h"
+#include "encoder/SpirBitcodeWriter.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+namespace SPIRTest {
+
+/// Sets one of the command line options of the encoder, Value must have the
+/// type of the option.
+template <typename T>
+inline void setEncoderOption(const char *Name, T Value) {
+  llvm::StringMap<llvm::cl::Option *> Options;
+  llvm::cl::getRegisteredOptions(Options);
+  llvm::cl::opt<T> *Opt =
+    static_cast<llvm::cl::opt<T> *>(Options.lookup(Name));
+  ASSERT_TRUE(Opt != 0) << "no -" << Name << " option";
+  Opt->setValue(Value);
+}
+
+/// Parses a module from LLVM assembly or bitcode, returns null on errors.
+inline llvm::Module *parseModule(llvm::StringRef Text,
+                                 llvm::LLVMContext &Context) {
+  llvm::SMDiagnostic Err;
+  llvm::Module *M = llvm::ParseIR(
+    llvm::MemoryBuffer::getMemBuffer(Text, "", false), Err, Context);
+  if (!M)
+    Err.print("SpirEncoderTests", llvm::errs());
+  return M;
+}
+
+/// Encodes M, adding the statistics of its blocks to Stats if not null.
+inline std::string encode(const llvm::Module *M,
+                          SPIR::EncoderStats *Stats = 0) {
+  llvm::SmallVector<char, 0> Encoded;
+  {
+    llvm::raw_svector_ostream OS(Encoded);
+    SPIR::WriteBitcodeToFile_SPIR(M, OS, Stats);
+  }
+  return std::string(Encoded.begin(), Encoded.end());
+}
+
+/// Reads Encoded, an encoding of M, back in a context of its own, and checks
+/// that it is the same module as M.
+inline void expectRoundTrip(const llvm::Module &M,
+                            const std::string &Encoded) {
+  llvm::LLVMContext Context;
+  llvm::Module *Parsed = parseModule(Encoded, Context);
+  ASSERT_TRUE(Parsed != 0);
+  std::vector<std::string> Differences;
+  EXPECT_TRUE(ModuleComparator(M, *Parsed).compare(2, Differences))
+    << Differences.size() << " differences, first: "
+    << (Differences.empty() ? "" : Differences[0]);
+  delete Parsed;
+}
+
+} // end namespace SPIRTest
+
+#endif // SPIR_ENCODER_TEST_UTILS_H
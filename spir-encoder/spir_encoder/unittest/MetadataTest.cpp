@@ -0,0 +1,92 @@
+//===-- MetadataTest.cpp - Tests for the SPIR module metadata block -------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// The module metadata block is written with abbreviations for its strings
+// and nodes, and -encoder-stats reports the metadata bytes of each kernel.
+// These tests encode kernels with argument info metadata, check that their
+// records are abbreviated and counted, and that they read back to the same
+// nodes.
+//
+//===---------------------------------------------------------------------===//
+
+#include "EncoderTestUtils.h"
+#include "encoder/LLVMBitCodes.h"
+#include "encoder/SpirEncoderStats.h"
+
+using namespace llvm;
+using namespace SPIRTest;
+
+namespace {
+
+const char ModuleText[] =
+  "target triple = \"spir-unknown-unknown\"\n"
+  "\n"
+  "define spir_kernel void @scale(float addrspace(1)* %data, float %f) {\n"
+  "entry:\n"
+  "  ret void\n"
+  "}\n"
+  "\n"
+  "define spir_kernel void @copy(i32 addrspace(1)* %dst,\n"
+  "                              i32 addrspace(2)* %src) {\n"
+  "entry:\n"
+  "  ret void\n"
+  "}\n"
+  "\n"
+  "!opencl.kernels = !{!0, !6}\n"
+  "!0 = metadata !{void (float addrspace(1)*, float)* @scale, metadata !1,\n"
+  "  metadata !2, metadata !3, metadata !4, metadata !5}\n"
+  "!1 = metadata !{metadata !\"kernel_arg_addr_space\", i32 1, i32 0}\n"
+  "!2 = metadata !{metadata !\"kernel_arg_access_qual\", metadata !\"none\",\n"
+  "  metadata !\"none\"}\n"
+  "!3 = metadata !{metadata !\"kernel_arg_type\", metadata !\"float*\",\n"
+  "  metadata !\"float\"}\n"
+  "!4 = metadata !{metadata !\"kernel_arg_type_qual\", metadata !\"\",\n"
+  "  metadata !\"\"}\n"
+  "!5 = metadata !{metadata !\"kernel_arg_name\", metadata !\"data\",\n"
+  "  metadata !\"f\"}\n"
+  "!6 = metadata !{void (i32 addrspace(1)*, i32 addrspace(2)*)* @copy,\n"
+  "  metadata !7, metadata !8, metadata !9, metadata !10, metadata !11}\n"
+  "!7 = metadata !{metadata !\"kernel_arg_addr_space\", i32 1, i32 2}\n"
+  "!8 = metadata !{metadata !\"kernel_arg_access_qual\", metadata !\"none\",\n"
+  "  metadata !\"none\"}\n"
+  "!9 = metadata !{metadata !\"kernel_arg_type\", metadata !\"int*\",\n"
+  "  metadata !\"int*\"}\n"
+  "!10 = metadata !{metadata !\"kernel_arg_type_qual\", metadata !\"\",\n"
+  "  metadata !\"const\"}\n"
+  "!11 = metadata !{metadata !\"kernel_arg_name\", metadata !\"dst\",\n"
+  "  metadata !\"src\"}\n";
+
+TEST(MetadataTest, KernelArgInfo) {
+  LLVMContext Context;
+  Module *M = parseModule(ModuleText, Context);
+  ASSERT_TRUE(M != 0);
+
+  SPIR::EncoderStats Stats;
+  std::string Encoded = encode(M, &Stats);
+
+  // The 15 strings and 11 nodes are abbreviated, !2 and !8 being the same
+  // node. The names of opencl.kernels and of the metadata kinds are not.
+  const SPIR::BlockStats &Block = Stats.get(bitc::METADATA_BLOCK_ID);
+  EXPECT_EQ(26U, Block.NumAbbreviated);
+
+  // The strings shared by both kernels are counted for the first one.
+  ASSERT_EQ(2U, Stats.KernelMetadata.size());
+  EXPECT_EQ("scale", Stats.KernelMetadata[0].Name);
+  EXPECT_EQ("copy", Stats.KernelMetadata[1].Name);
+  EXPECT_GT(Stats.KernelMetadata[1].NumBits, 0U);
+  EXPECT_GT(Stats.KernelMetadata[0].NumBits,
+            Stats.KernelMetadata[1].NumBits);
+  EXPECT_LT(Stats.KernelMetadata[0].NumBits + Stats.KernelMetadata[1].NumBits,
+            Block.NumBits);
+
+  expectRoundTrip(*M, Encoded);
+  delete M;
+}
+
+} // end anonymous namespace
@@ -0,0 +1,623 @@
+//===-- ModuleComparator.cpp - Structural comparison of modules -----------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+
+#include "ModuleComparator.h"
+#include "encoder/LLVMVersion.h"
+#include "encoder/SpirThreading.h"
+
+#include "llvm/ADT/Twine.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/TypeFinder.h"
+
+#include <algorithm>
+
+using namespace llvm;
+
+namespace SPIRTest {
+
+/// Comparison of the values of the modules, by structure for types,
+/// constants and metadata, and through the matches made so far for global
+/// and function-local values. It records the first difference found.
+class ModuleComparator::ValueComparator {
+public:
+  explicit ValueComparator(const ModuleComparator &MC) : MC(MC) {}
+
+  bool isSameType(const Type *TA, const Type *TB) const;
+  bool isSameValue(const Value *VA, const Value *VB);
+  bool isSameConstant(const Constant *CA, const Constant *CB);
+  bool isSameMDNode(const MDNode *NA, const MDNode *NB);
+  bool isSameAttributes(AttributeSet AA, AttributeSet AB, unsigned NumParams);
+  bool isSameInstruction(const Instruction &IA, const Instruction &IB);
+
+  /// Record a difference, if it is the first one. Returns false.
+  bool differ(const Twine &What) {
+    if (Difference.empty())
+      Difference = What.str();
+    return false;
+  }
+
+  /// The first difference found.
+  std::string Difference;
+  /// Function-local values of B, indexed by the ones of A.
+  DenseMap<const Value *, const Value *> Values;
+
+private:
+  const ModuleComparator &MC;
+  /// Metadata nodes of B found equal to the ones of A, or being compared.
+  DenseMap<const MDNode *, const MDNode *> Nodes;
+};
+
+bool ModuleComparator::ValueComparator::isSameType(const Type *TA,
+                                                    const Type *TB) const {
+  if (TA->getTypeID() != TB->getTypeID())
+    return false;
+
+  switch (TA->getTypeID()) {
+  case Type::IntegerTyID:
+    return TA->getIntegerBitWidth() == TB->getIntegerBitWidth();
+  case Type::PointerTyID:
+    return TA->getPointerAddressSpace() == TB->getPointerAddressSpace() &&
+           isSameType(cast<PointerType>(TA)->getElementType(),
+                      cast<PointerType>(TB)->getElementType());
+  case Type::ArrayTyID:
+    return cast<ArrayType>(TA)->getNumElements() ==
+             cast<ArrayType>(TB)->getNumElements() &&
+           isSameType(cast<ArrayType>(TA)->getElementType(),
+                      cast<ArrayType>(TB)->getElementType());
+  case Type::VectorTyID:
+    return cast<VectorType>(TA)->getNumElements() ==
+             cast<VectorType>(TB)->getNumElements() &&
+           isSameType(cast<VectorType>(TA)->getElementType(),
+                      cast<VectorType>(TB)->getElementType());
+  case Type::FunctionTyID: {
+    const FunctionType *FA = cast<FunctionType>(TA);
+    const FunctionType *FB = cast<FunctionType>(TB);
+    if (FA->isVarArg() != FB->isVarArg() ||
+        FA->getNumParams() != FB->getNumParams() ||
+        !isSameType(FA->getReturnType(), FB->getReturnType()))
+      return false;
+    for (unsigned i = 0, e = FA->getNumParams(); i != e; ++i)
+      if (!isSameType(FA->getParamType(i), FB->getParamType(i)))
+        return false;
+    return true;
+  }
+  case Type::StructTyID: {
+    const StructType *SA = cast<StructType>(TA);
+    const StructType *SB = cast<StructType>(TB);
+    // Identified structs may be recursive, they are matched up front.
+    if (!SA->isLiteral() || !SB->isLiteral())
+      return MC.StructTypes.lookup(SA) == SB;
+    if (SA->isPacked() != SB->isPacked() ||
+        SA->getNumElements() != SB->getNumElements())
+      return false;
+    for (unsigned i = 0, e = SA->getNumElements(); i != e; ++i)
+      if (!isSameType(SA->getElementType(i), SB->getElementType(i)))
+        return false;
+    return true;
+  }
+  default:
+    return true;
+  }
+}
+
+bool ModuleComparator::ValueComparator::isSameValue(const Value *VA,
+                                                     const Value *VB) {
+  if (!VA || !VB)
+    return VA == VB;
+  if (VA->getValueID() != VB->getValueID() ||
+      !isSameType(VA->getType(), VB->getType()))
+    return false;
+
+  if (const Constant *CA = dyn_cast<Constant>(VA))
+    return isSameConstant(CA, cast<Constant>(VB));
+  if (const MDNode *NA = dyn_cast<MDNode>(VA))
+    return isSameMDNode(NA, cast<MDNode>(VB));
+  if (const MDString *SA = dyn_cast<MDString>(VA))
+    return SA->getString() == cast<MDString>(VB)->getString();
+  if (const InlineAsm *AA = dyn_cast<InlineAsm>(VA)) {
+    const InlineAsm *AB = cast<InlineAsm>(VB);
+    return AA->getAsmString() == AB->getAsmString() &&
+           AA->getConstraintString() == AB->getConstraintString() &&
+           AA->hasSideEffects() == AB->hasSideEffects() &&
+           AA->isAlignStack() == AB->isAlignStack() &&
+           AA->getDialect() == AB->getDialect();
+  }
+
+  // Arguments, basic blocks and instructions.
+  return Values.lookup(VA) == VB;
+}
+
+/// Returns the position of BB in its function.
+static unsigned getBlockIndex(const BasicBlock *BB) {
+  const Function *F = BB->getParent();
+  return (unsigned)std::distance(F->begin(), Function::const_iterator(BB));
+}
+
+bool ModuleComparator::ValueComparator::isSameConstant(const Constant *CA,
+                                                        const Constant *CB) {
+  if (CA->getValueID() != CB->getValueID() ||
+      !isSameType(CA->getType(), CB->getType()))
+    return false;
+
+  if (const GlobalValue *GA = dyn_cast<GlobalValue>(CA))
+    return MC.Globals.lookup(GA) == CB;
+  if (const ConstantInt *IA = dyn_cast<ConstantInt>(CA))
+    return IA->getValue() == cast<ConstantInt>(CB)->getValue();
+  if (const ConstantFP *FA = dyn_cast<ConstantFP>(CA))
+    return FA->getValueAPF().bitwiseIsEqual(
+      cast<ConstantFP>(CB)->getValueAPF());
+  if (const ConstantDataSequential *DA = dyn_cast<ConstantDataSequential>(CA))
+    return DA->getRawDataValues() ==
+           cast<ConstantDataSequential>(CB)->getRawDataValues();
+  if (const BlockAddress *BA = dyn_cast<BlockAddress>(CA)) {
+    const BlockAddress *BB = cast<BlockAddress>(CB);
+    return MC.Globals.lookup(BA->getFunction()) == BB->getFunction() &&
+           getBlockIndex(BA->getBasicBlock()) ==
+             getBlockIndex(BB->getBasicBlock());
+  }
+  if (const ConstantExpr *EA = dyn_cast<ConstantExpr>(CA)) {
+    const ConstantExpr *EB = cast<ConstantExpr>(CB);
+    if (EA->getOpcode() != EB->getOpcode() ||
+        EA->getRawSubclassOptionalData() != EB->getRawSubclassOptionalData())
+      return false;
+    if (EA->isCompare() && EA->getPredicate() != EB->getPredicate())
+      return false;
+    if (EA->hasIndices() && !EA->getIndices().equals(EB->getIndices()))
+      return false;
+  }
+
+  // Aggregates and expressions.
+  if (CA->getNumOperands() != CB->getNumOperands())
+    return false;
+  for (unsigned i = 0, e = CA->getNumOperands(); i != e; ++i)
+    if (!isSameConstant(cast<Constant>(CA->getOperand(i)),
+                        cast<Constant>(CB->getOperand(i))))
+      return false;
+  return true;
+}
+
+bool ModuleComparator::ValueComparator::isSameMDNode(const MDNode *NA,
+                                                      const MDNode *NB) {
+  DenseMap<const MDNode *, const MDNode *>::iterator I = Nodes.find(NA);
+  if (I != Nodes.end())
+    return I->second == NB;
+  if (NA->isFunctionLocal() != NB->isFunctionLocal() ||
+      NA->getNumOperands() != NB->getNumOperands())
+    return false;
+
+  // Nodes may refer to themselves, they are assumed equal while compared.
+  Nodes[NA] = NB;
+  for (unsigned i = 0, e = NA->getNumOperands(); i != e; ++i)
+    if (!isSameValue(NA->getOperand(i), NB->getOperand(i))) {
+      Nodes.erase(NA);
+      return false;
+    }
+  return true;
+}
+
+bool ModuleComparator::ValueComparator::isSameAttributes(AttributeSet AA,
+                                                          AttributeSet AB,
+                                                          unsigned NumParams) {
+  if (AA.getAsString(AttributeSet::FunctionIndex) !=
+      AB.getAsString(AttributeSet::FunctionIndex))
+    return differ("function attributes '" +
+                  AA.getAsString(AttributeSet::FunctionIndex) + "' read back "
+                  "as '" + AB.getAsString(AttributeSet::FunctionIndex) + "'");
+  for (unsigned i = 0; i <= NumParams; ++i)
+    if (AA.getAsString(i) != AB.getAsString(i))
+      return differ((i ? "attributes of parameter " + Twine(i) :
+                         Twine("return attributes")) +
+                    " '" + AA.getAsString(i) + "' read back as '" +
+                    AB.getAsString(i) + "'");
+  return true;
+}
+
+bool ModuleComparator::ValueComparator::isSameInstruction(
+  const Instruction &IA, const Instruction &IB) {
+  if (IA.getOpcode() != IB.getOpcode())
+    return differ(Twine("read back as ") + IB.getOpcodeName());
+  if (!isSameType(IA.getType(), IB.getType()))
+    return differ("type differs");
+  if (IA.getRawSubclassOptionalData() != IB.getRawSubclassOptionalData())
+    return differ("flags differ");
+  if (IA.getNumOperands() != IB.getNumOperands())
+    return differ(Twine(IA.getNumOperands()) + " operands, " +
+                  Twine(IB.getNumOperands()) + " read back");
+  for (unsigned i = 0, e = IA.getNumOperands(); i != e; ++i)
+    if (!isSameValue(IA.getOperand(i), IB.getOperand(i)))
+      return differ("operand " + Twine(i) + " differs");
+
+  if (const CmpInst *CA = dyn_cast<CmpInst>(&IA)) {
+    if (CA->getPredicate() != cast<CmpInst>(IB).getPredicate())
+      return differ("predicate differs");
+  } else if (const LoadInst *LA = dyn_cast<LoadInst>(&IA)) {
+    const LoadInst &LB = cast<LoadInst>(IB);
+    if (LA->isVolatile() != LB.isVolatile() ||
+        LA->getAlignment() != LB.getAlignment() ||
+        LA->getOrdering() != LB.getOrdering() ||
+        LA->getSynchScope() != LB.getSynchScope())
+      return differ("volatility, alignment or ordering differs");
+  } else if (const StoreInst *SA = dyn_cast<StoreInst>(&IA)) {
+    const StoreInst &SB = cast<StoreInst>(IB);
+    if (SA->isVolatile() != SB.isVolatile() ||
+        SA->getAlignment() != SB.getAlignment() ||
+        SA->getOrdering() != SB.getOrdering() ||
+        SA->getSynchScope() != SB.getSynchScope())
+      return differ("volatility, alignment or ordering differs");
+  } else if (const AllocaInst *AA = dyn_cast<AllocaInst>(&IA)) {
+    if (AA->getAlignment() != cast<AllocaInst>(IB).getAlignment())
+      return differ("alignment differs");
+  } else if (const CallInst *CIA = dyn_cast<CallInst>(&IA)) {
+    const CallInst &CIB = cast<CallInst>(IB);
+    if (CIA->getCallingConv() != CIB.getCallingConv() ||
+        CIA->isTailCall() != CIB.isTailCall())
+      return differ("calling convention or tail marker differs");
+    if (!isSameAttributes(CIA->getAttributes(), CIB.getAttributes(),
+                          CIA->getNumArgOperands()))
+      return false;
+  } else if (const InvokeInst *IIA = dyn_cast<InvokeInst>(&IA)) {
+    const InvokeInst &IIB = cast<InvokeInst>(IB);
+    if (IIA->getCallingConv() != IIB.getCallingConv())
+      return differ("calling convention differs");
+    if (!isSameAttributes(IIA->getAttributes(), IIB.getAttributes(),
+                          IIA->getNumArgOperands()))
+      return false;
+  } else if (const PHINode *PA = dyn_cast<PHINode>(&IA)) {
+    // The incoming blocks are not operands.
+    const PHINode &PB = cast<PHINode>(IB);
+    for (unsigned i = 0, e = PA->getNumIncomingValues(); i != e; ++i)
+      if (Values.lookup(PA->getIncomingBlock(i)) != PB.getIncomingBlock(i))
+        return differ("incoming block " + Twine(i) + " differs");
+  } else if (const ExtractValueInst *EA = dyn_cast<ExtractValueInst>(&IA)) {
+    if (!EA->getIndices().equals(cast<ExtractValueInst>(IB).getIndices()))
+      return differ("indices differ");
+  } else if (const InsertValueInst *IVA = dyn_cast<InsertValueInst>(&IA)) {
+    if (!IVA->getIndices().equals(cast<InsertValueInst>(IB).getIndices()))
+      return differ("indices differ");
+  } else if (const AtomicRMWInst *RA = dyn_cast<AtomicRMWInst>(&IA)) {
+    const AtomicRMWInst &RB = cast<AtomicRMWInst>(IB);
+    if (RA->getOperation() != RB.getOperation() ||
+        RA->isVolatile() != RB.isVolatile() ||
+        RA->getOrdering() != RB.getOrdering() ||
+        RA->getSynchScope() != RB.getSynchScope())
+      return differ("operation, volatility or ordering differs");
+  } else if (const AtomicCmpXchgInst *XA = dyn_cast<AtomicCmpXchgInst>(&IA)) {
+    const AtomicCmpXchgInst &XB = cast<AtomicCmpXchgInst>(IB);
+#if LLVM_VERSION < 3500
+    bool SameOrdering = XA->getOrdering() == XB.getOrdering();
+#else
+    bool SameOrdering =
+      XA->getSuccessOrdering() == XB.getSuccessOrdering() &&
+      XA->getFailureOrdering() == XB.getFailureOrdering();
+#endif
+    if (!SameOrdering || XA->isVolatile() != XB.isVolatile() ||
+        XA->getSynchScope() != XB.getSynchScope())
+      return differ("volatility or ordering differs");
+  } else if (const FenceInst *FA = dyn_cast<FenceInst>(&IA)) {
+    const FenceInst &FB = cast<FenceInst>(IB);
+    if (FA->getOrdering() != FB.getOrdering() ||
+        FA->getSynchScope() != FB.getSynchScope())
+      return differ("ordering differs");
+  } else if (const LandingPadInst *LPA = dyn_cast<LandingPadInst>(&IA)) {
+    const LandingPadInst &LPB = cast<LandingPadInst>(IB);
+    if (LPA->isCleanup() != LPB.isCleanup())
+      return differ("cleanup flag differs");
+    for (unsigned i = 0, e = LPA->getNumClauses(); i != e; ++i)
+      if (LPA->isCatch(i) != LPB.isCatch(i))
+        return differ("clause " + Twine(i) + " differs");
+  }
+
+  // Metadata attachments, matched by kind name as kind IDs are per context.
+  // The debug location is compared apart, as attaching it as a node would
+  // create one in the context, which other threads are reading.
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDA, MDB;
+  IA.getAllMetadataOtherThanDebugLoc(MDA);
+  IB.getAllMetadataOtherThanDebugLoc(MDB);
+  if (MDA.size() != MDB.size())
+    return differ(Twine(MDA.size()) + " metadata attachments, " +
+                  Twine(MDB.size()) + " read back");
+  for (unsigned i = 0, e = MDA.size(); i != e; ++i) {
+    if (MC.KindNamesA[MDA[i].first] != MC.KindNamesB[MDB[i].first])
+      return differ("metadata kind !" + MC.KindNamesA[MDA[i].first] +
+                    " read back as !" + MC.KindNamesB[MDB[i].first]);
+    if (!isSameMDNode(MDA[i].second, MDB[i].second))
+      return differ("!" + MC.KindNamesA[MDA[i].first] + " metadata differs");
+  }
+
+  const DebugLoc &DLA = IA.getDebugLoc(), &DLB = IB.getDebugLoc();
+  if (DLA.isUnknown() != DLB.isUnknown())
+    return differ("debug location differs");
+  if (!DLA.isUnknown()) {
+    const LLVMContext &CtxA = IA.getContext(), &CtxB = IB.getContext();
+    if (DLA.getLine() != DLB.getLine() || DLA.getCol() != DLB.getCol() ||
+        !isSameValue(DLA.getScope(CtxA), DLB.getScope(CtxB)) ||
+        !isSameValue(DLA.getInlinedAt(CtxA), DLB.getInlinedAt(CtxB)))
+      return differ("debug location differs");
+  }
+  return true;
+}
+
+ModuleComparator::ModuleComparator(const Module &A, const Module &B)
+  : A(A), B(B) {
+  A.getMDKindNames(KindNamesA);
+  B.getMDKindNames(KindNamesB);
+}
+
+void ModuleComparator::matchStructTypes(std::vector<std::string> &Differences) {
+  TypeFinder FoundA, FoundB;
+  FoundA.run(A, false);
+  FoundB.run(B, false);
+
+  // Named structs are matched by name, the others in the order they are
+  // found in.
+  std::vector<StructType *> UnnamedA, UnnamedB;
+  for (TypeFinder::iterator I = FoundB.begin(), E = FoundB.end(); I != E; ++I)
+    if (!(*I)->isLiteral() && !(*I)->hasName())
+      UnnamedB.push_back(*I);
+  for (TypeFinder::iterator I = FoundA.begin(), E = FoundA.end(); I != E; ++I) {
+    StructType *SA = *I;
+    if (SA->isLiteral())
+      continue;
+    if (!SA->hasName()) {
+      UnnamedA.push_back(SA);
+      continue;
+    }
+    if (StructType *SB = B.getTypeByName(SA->getName()))
+      StructTypes[SA] = SB;
+    else
+      Differences.push_back("%" + SA->getName().str() + " is not read back");
+  }
+  if (UnnamedA.size() != UnnamedB.size())
+    Differences.push_back(Twine(UnnamedA.size()).str() + " unnamed structs, " +
+                          Twine(UnnamedB.size()).str() + " read back");
+  for (unsigned i = 0, e = std::min(UnnamedA.size(), UnnamedB.size());
+       i != e; ++i)
+    StructTypes[UnnamedA[i]] = UnnamedB[i];
+
+  // All structs are matched, so their bodies can be compared.
+  ValueComparator VC(*this);
+  for (DenseMap<const Type *, const Type *>::iterator I = StructTypes.begin(),
+       E = StructTypes.end(); I != E; ++I) {
+    const StructType *SA = cast<StructType>(I->first);
+    const StructType *SB = cast<StructType>(I->second);
+    bool Same = SA->isOpaque() == SB->isOpaque() &&
+                SA->isPacked() == SB->isPacked() &&
+                SA->getNumElements() == SB->getNumElements();
+    for (unsigned i = 0, e = SA->getNumElements(); Same && i != e; ++i)
+      Same = VC.isSameType(SA->getElementType(i), SB->getElementType(i));
+    if (!Same)
+      Differences.push_back("body of struct %" + SA->getName().str() +
+                            " differs");
+  }
+}
+
+/// Returns a name for GV in the descriptions of the differences.
+static std::string getGlobalName(const GlobalValue *GV) {
+  return GV->hasName() ? "@" + GV->getName().str() : "unnamed global";
+}
+
+/// Match the I-th global values of lists LA and LB by position, appending
+/// them to Pairs.
+template<typename ListT>
+static void matchGlobalList(const ListT &LA, const ListT &LB, const char *Kind,
+                            std::vector<std::pair<const GlobalValue *,
+                                                  const GlobalValue *> > &Pairs,
+                            std::vector<std::string> &Differences) {
+  typename ListT::const_iterator IA = LA.begin(), IB = LB.begin();
+  for (; IA != LA.end() && IB != LB.end(); ++IA, ++IB)
+    Pairs.push_back(std::make_pair(&*IA, &*IB));
+  if (IA != LA.end() || IB != LB.end())
+    Differences.push_back(Twine(LA.size()).str() + " " + Kind + ", " +
+                          Twine(LB.size()).str() + " read back");
+}
+
+void ModuleComparator::matchGlobals(std::vector<std::string> &Differences) {
+  std::vector<std::pair<const GlobalValue *, const GlobalValue *> > Pairs;
+  matchGlobalList(A.getGlobalList(), B.getGlobalList(), "global variables",
+                  Pairs, Differences);
+  matchGlobalList(A.getFunctionList(), B.getFunctionList(), "functions",
+                  Pairs, Differences);
+  matchGlobalList(A.getAliasList(), B.getAliasList(), "aliases",
+                  Pairs, Differences);
+  for (unsigned i = 0, e = Pairs.size(); i != e; ++i)
+    Globals[Pairs[i].first] = Pairs[i].second;
+
+  // The initializers and aliasees may refer to any global, so they are
+  // compared once all are matched.
+  ValueComparator VC(*this);
+  for (unsigned i = 0, e = Pairs.size(); i != e; ++i) {
+    const GlobalValue *GA = Pairs[i].first, *GB = Pairs[i].second;
+    std::string Name = getGlobalName(GA);
+    if (GA->getName() != GB->getName()) {
+      Differences.push_back(Name + " read back as " + getGlobalName(GB));
+      continue;
+    }
+    if (!VC.isSameType(GA->getType(), GB->getType()) ||
+        GA->getLinkage() != GB->getLinkage() ||
+        GA->getVisibility() != GB->getVisibility() ||
+        GA->getAlignment() != GB->getAlignment() ||
+        GA->hasUnnamedAddr() != GB->hasUnnamedAddr() ||
+        StringRef(GA->getSection()) != StringRef(GB->getSection())) {
+      Differences.push_back("type, linkage, visibility, alignment or section "
+                            "of " + Name + " differs");
+      continue;
+    }
+
+    if (const GlobalVariable *VA = dyn_cast<GlobalVariable>(GA)) {
+      const GlobalVariable *VB = cast<GlobalVariable>(GB);
+      if (VA->isConstant() != VB->isConstant() ||
+          VA->getThreadLocalMode() != VB->getThreadLocalMode() ||
+          VA->isExternallyInitialized() != VB->isExternallyInitialized() ||
+          VA->hasInitializer() != VB->hasInitializer() ||
+          (VA->hasInitializer() &&
+           !VC.isSameConstant(VA->getInitializer(), VB->getInitializer())))
+        Differences.push_back("definition of " + Name + " differs");
+    } else if (const Function *FA = dyn_cast<Function>(GA)) {
+      const Function *FB = cast<Function>(GB);
+      if (FA->getCallingConv() != FB->getCallingConv() ||
+          FA->hasGC() != FB->hasGC() ||
+          (FA->hasGC() && StringRef(FA->getGC()) != FB->getGC()) ||
+          FA->isDeclaration() != FB->isDeclaration()) {
+        Differences.push_back("calling convention, GC or definition of " +
+                              Name + " differs");
+        continue;
+      }
+      if (!VC.isSameAttributes(FA->getAttributes(), FB->getAttributes(),
+                               FA->arg_size())) {
+        Differences.push_back(Name + ": " + VC.Difference);
+        VC.Difference.clear();
+        continue;
+      }
+      if (!FA->isDeclaration())
+        Functions.push_back(std::make_pair(FA, FB));
+    } else if (!VC.isSameConstant(cast<GlobalAlias>(GA)->getAliasee(),
+                                  cast<GlobalAlias>(GB)->getAliasee())) {
+      Differences.push_back("aliasee of " + Name + " differs");
+    }
+  }
+}
+
+std::string ModuleComparator::compareFunction(unsigned I) const {
+  const Function &FA = *Functions[I].first, &FB = *Functions[I].second;
+  std::string Name = getGlobalName(&FA);
+  ValueComparator VC(*this);
+
+  // All the local values are matched before the instructions are compared,
+  // as operands may refer to later instructions.
+  for (Function::const_arg_iterator AI = FA.arg_begin(), BI = FB.arg_begin(),
+       AE = FA.arg_end(); AI != AE; ++AI, ++BI) {
+    if (AI->getName() != BI->getName())
+      return Name + ": argument %" + AI->getName().str() + " read back as %" +
+             BI->getName().str();
+    VC.Values[AI] = BI;
+  }
+  if (FA.size() != FB.size())
+    return Name + ": " + Twine(FA.size()).str() + " blocks, " +
+           Twine(FB.size()).str() + " read back";
+  for (Function::const_iterator BBA = FA.begin(), BBB = FB.begin(),
+       E = FA.end(); BBA != E; ++BBA, ++BBB) {
+    if (BBA->getName() != BBB->getName() || BBA->size() != BBB->size())
+      return Name + ": block %" + BBA->getName().str() + " read back as %" +
+             BBB->getName().str() + " of " + Twine(BBB->size()).str() +
+             " instructions";
+    VC.Values[BBA] = BBB;
+    for (BasicBlock::const_iterator IA = BBA->begin(), IB = BBB->begin(),
+         IE = BBA->end(); IA != IE; ++IA, ++IB) {
+      if (IA->getName() != IB->getName())
+        return Name + ": %" + IA->getName().str() + " read back as %" +
+               IB->getName().str();
+      VC.Values[IA] = IB;
+    }
+  }
+
+  for (Function::const_iterator BBA = FA.begin(), BBB = FB.begin(),
+       E = FA.end(); BBA != E; ++BBA, ++BBB) {
+    unsigned Index = 0;
+    for (BasicBlock::const_iterator IA = BBA->begin(), IB = BBB->begin(),
+         IE = BBA->end(); IA != IE; ++IA, ++IB, ++Index)
+      if (!VC.isSameInstruction(*IA, *IB))
+        return Name + ": " + IA->getOpcodeName() + " #" + Twine(Index).str() +
+               " of block %" + BBA->getName().str() + ": " + VC.Difference;
+  }
+  return std::string();
+}
+
+#if SPIR_ENCODER_PARALLEL
+namespace {
+/// FunctionQueue - The functions left to compare, taken by each thread in
+/// turn.
+struct FunctionQueue {
+  std::atomic<unsigned> Next;
+  unsigned Size;
+};
+}
+#endif
+
+bool ModuleComparator::compare(unsigned NumThreads,
+                               std::vector<std::string> &Differences) {
+  size_t NumDifferences = Differences.size();
+
+  if (A.getTargetTriple() != B.getTargetTriple())
+    Differences.push_back("target triple '" + A.getTargetTriple() +
+                          "' read back as '" + B.getTargetTriple() + "'");
+#if LLVM_VERSION < 3500
+  if (A.getDataLayout() != B.getDataLayout())
+#else
+  // The encoder writes the LLVM 3.2 spelling of the SPIR data layouts.
+  if (!A.getDataLayout() != !B.getDataLayout() ||
+      (A.getDataLayout() && *A.getDataLayout() != *B.getDataLayout()))
+#endif
+    Differences.push_back("data layout differs");
+  if (A.getModuleInlineAsm() != B.getModuleInlineAsm())
+    Differences.push_back("module inline asm differs");
+
+  matchStructTypes(Differences);
+  matchGlobals(Differences);
+
+  // Named metadata refers to globals, and to nodes shared with functions,
+  // so it is compared by a comparator of its own.
+  ValueComparator VC(*this);
+  for (Module::const_named_metadata_iterator I = A.named_metadata_begin(),
+       E = A.named_metadata_end(); I != E; ++I) {
+    const NamedMDNode *NA = I;
+    const NamedMDNode *NB = B.getNamedMetadata(NA->getName());
+    bool Same = NB && NA->getNumOperands() == NB->getNumOperands();
+    for (unsigned i = 0, e = NA->getNumOperands(); Same && i != e; ++i)
+      Same = VC.isSameMDNode(NA->getOperand(i), NB->getOperand(i));
+    if (!Same)
+      Differences.push_back("!" + NA->getName().str() + " differs");
+  }
+  if (std::distance(A.named_metadata_begin(), A.named_metadata_end()) !=
+      std::distance(B.named_metadata_begin(), B.named_metadata_end()))
+    Differences.push_back("number of named metadata differs");
+
+  // Function bodies only read the matches made above, and the modules,
+  // so they are compared in parallel.
+  std::vector<std::string> FunctionDifferences(Functions.size());
+#if SPIR_ENCODER_PARALLEL
+  if (NumThreads == 0)
+    NumThreads = std::max(std::thread::hardware_concurrency(), 1U);
+  NumThreads = std::max(std::min(NumThreads, (unsigned)Functions.size()), 1U);
+
+  FunctionQueue Queue;
+  Queue.Next = 0;
+  Queue.Size = (unsigned)Functions.size();
+  struct Worker {
+    static void run(const ModuleComparator *MC, FunctionQueue *Queue,
+                    std::vector<std::string> *Results) {
+      for (unsigned I = Queue->Next++; I < Queue->Size; I = Queue->Next++)
+        (*Results)[I] = MC->compareFunction(I);
+    }
+  };
+  std::vector<std::thread> Threads;
+  for (unsigned t = 1; t < NumThreads; ++t)
+    Threads.push_back(std::thread(Worker::run, this, &Queue,
+                                  &FunctionDifferences));
+  Worker::run(this, &Queue, &FunctionDifferences);
+  for (unsigned t = 0; t < Threads.size(); ++t)
+    Threads[t].join();
+#else
+  (void)NumThreads;
+  for (unsigned I = 0, e = Functions.size(); I != e; ++I)
+    FunctionDifferences[I] = compareFunction(I);
+#endif
+
+  for (unsigned I = 0, e = FunctionDifferences.size(); I != e; ++I)
+    if (!FunctionDifferences[I].empty())
+      Differences.push_back(FunctionDifferences[I]);
+  return Differences.size() == NumDifferences;
+}
+
+} // end namespace SPIRTest
@@ -0,0 +1,81 @@
+//===-- ModuleComparator.h - Structural comparison of modules ---*- C++ -*-===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Compares a module with the module read back from its SPIR encoding. The
+// modules live in different contexts, so their types, constants and metadata
+// are compared by structure rather than by identity.
+//
+//===---------------------------------------------------------------------===//
+
+#ifndef SPIR_MODULE_COMPARATOR_H
+#define SPIR_MODULE_COMPARATOR_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class Function;
+  class GlobalValue;
+  class Module;
+  class Type;
+}
+
+namespace SPIRTest {
+
+/// Structural comparison of two modules: their struct types, globals,
+/// functions, instructions and metadata. Values are matched by position, and
+/// must also have the same names. After the module level entities are
+/// matched, function bodies are compared independently of each other, on
+/// several threads if asked to.
+class ModuleComparator {
+public:
+  ModuleComparator(const llvm::Module &A, const llvm::Module &B);
+
+  /// Compare the modules, comparing function bodies on NumThreads threads
+  /// (0 for one per hardware thread). Returns true if they are equivalent.
+  /// Otherwise appends a description of the differences to Differences: one
+  /// for the module level entities, and one per function, from its first
+  /// difference.
+  bool compare(unsigned NumThreads, std::vector<std::string> &Differences);
+
+private:
+  class ValueComparator;
+  friend class ValueComparator;
+
+  /// Match the identified struct types of the modules.
+  void matchStructTypes(std::vector<std::string> &Differences);
+
+  /// Match the global values of the modules, comparing their properties.
+  void matchGlobals(std::vector<std::string> &Differences);
+
+  /// Compare the body of the I-th pair of functions, returns an empty string
+  /// if they are equivalent.
+  std::string compareFunction(unsigned I) const;
+
+  const llvm::Module &A, &B;
+
+  /// Identified struct types of B, indexed by the ones of A.
+  llvm::DenseMap<const llvm::Type *, const llvm::Type *> StructTypes;
+  /// Global values of B, indexed by the ones of A.
+  llvm::DenseMap<const llvm::GlobalValue *, const llvm::GlobalValue *>
+    Globals;
+  /// Names of the metadata kinds of each module, indexed by kind ID.
+  llvm::SmallVector<llvm::StringRef, 8> KindNamesA, KindNamesB;
+  /// Pairs of functions with bodies to compare.
+  std::vector<std::pair<const llvm::Function *, const llvm::Function *> >
+    Functions;
+};
+
+} // end namespace SPIRTest
+
+#endif // SPIR_MODULE_COMPARATOR_H
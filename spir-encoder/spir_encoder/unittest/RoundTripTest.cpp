@@ -0,0 +1,155 @@
+//===-- RoundTripTest.cpp - Round-trip tests for the SPIR encoder ---------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Encodes a module with each of the encoder options, reads it back in another
+// context and compares it with the original with ModuleComparator. Also
+// checks that the comparator finds differences in globals and instructions.
+//
+//===---------------------------------------------------------------------===//
+
+#include "EncoderTestUtils.h"
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+
+using namespace llvm;
+using namespace SPIRTest;
+
+namespace {
+
+const char ModuleText[] =
+  "target triple = \"spir-unknown-unknown\"\n"
+  "\n"
+  "%struct.pair = type { i32, float }\n"
+  "%struct.node = type { %struct.node addrspace(1)*, i32 }\n"
+  "\n"
+  "@table = addrspace(2) constant [4 x float] [float 1.0, float 2.0,\n"
+  "  float 0.5, float 0.25], align 4\n"
+  "@pairs = addrspace(2) constant [2 x %struct.pair] [\n"
+  "  %struct.pair { i32 1, float 1.0 }, %struct.pair { i32 2, float 2.0 }]\n"
+  "@entry = addrspace(2) constant float addrspace(2)* getelementptr inbounds\n"
+  "  ([4 x float] addrspace(2)* @table, i32 0, i32 2)\n"
+  "@head = addrspace(1) global %struct.node zeroinitializer, align 4\n"
+  "@local = internal addrspace(3) global [16 x i32] zeroinitializer, align 4\n"
+  "\n"
+  "declare spir_func i32 @_Z13get_global_idj(i32) nounwind readnone\n"
+  "\n"
+  "define spir_func float @lookup(i32 %i) nounwind {\n"
+  "entry:\n"
+  "  %cmp = icmp ult i32 %i, 4\n"
+  "  br i1 %cmp, label %in, label %out\n"
+  "in:\n"
+  "  %p = getelementptr inbounds [4 x float] addrspace(2)* @table, i32 0,\n"
+  "    i32 %i\n"
+  "  %v = load float addrspace(2)* %p, align 4\n"
+  "  br label %out\n"
+  "out:\n"
+  "  %r = phi float [ %v, %in ], [ 0.0, %entry ]\n"
+  "  ret float %r\n"
+  "}\n"
+  "\n"
+  "define spir_kernel void @kernel(float addrspace(1)* nocapture %out,\n"
+  "                                <4 x float> %vec, i32 %sel) nounwind {\n"
+  "entry:\n"
+  "  %tmp = alloca %struct.pair, align 8\n"
+  "  %gid = call spir_func i32 @_Z13get_global_idj(i32 0) nounwind readnone\n"
+  "  %f = call spir_func float @lookup(i32 %gid)\n"
+  "  %e = extractelement <4 x float> %vec, i32 1\n"
+  "  %sum = fadd float %f, %e\n"
+  "  %field = getelementptr inbounds %struct.pair* %tmp, i32 0, i32 1\n"
+  "  store volatile float %sum, float* %field, align 4\n"
+  "  %ld = load volatile float* %field, align 4\n"
+  "  %agg = insertvalue %struct.pair undef, float %ld, 1\n"
+  "  %x = extractvalue %struct.pair %agg, 1\n"
+  "  switch i32 %sel, label %done [ i32 0, label %zero\n"
+  "                                 i32 1, label %one ]\n"
+  "zero:\n"
+  "  br label %done\n"
+  "one:\n"
+  "  %lp = getelementptr [16 x i32] addrspace(3)* @local, i32 0, i32 %sel\n"
+  "  %old = atomicrmw add i32 addrspace(3)* %lp, i32 1 seq_cst\n"
+  "  br label %done\n"
+  "done:\n"
+  "  %y = phi float [ %x, %entry ], [ 1.0, %zero ], [ 2.0, %one ]\n"
+  "  %idx = getelementptr inbounds float addrspace(1)* %out, i32 %gid\n"
+  "  store float %y, float addrspace(1)* %idx, align 4, !tbaa !2\n"
+  "  ret void\n"
+  "}\n"
+  "\n"
+  "!opencl.kernels = !{!0}\n"
+  "!0 = metadata !{void (float addrspace(1)*, <4 x float>, i32)* @kernel,\n"
+  "  metadata !1}\n"
+  "!1 = metadata !{metadata !\"kernel_arg_addr_space\", i32 1, i32 0, i32 0}\n"
+  "!2 = metadata !{metadata !\"float\", metadata !3}\n"
+  "!3 = metadata !{metadata !\"omnipotent char\", metadata !4}\n"
+  "!4 = metadata !{metadata !\"Simple C/C++ TBAA\"}\n";
+
+// The boolean encoder options, each enabling other writer paths.
+const char *const Options[] = {
+  0,
+  "enable-bc-uselist-preserve",
+  "spir-encoder-compact-constants",
+  "spir-encoder-deterministic",
+  "spir-encoder-module-hash",
+  "spir-encoder-profile-abbrevs"
+};
+
+TEST(RoundTripTest, EncoderOptions) {
+  LLVMContext Context;
+  Module *M = parseModule(ModuleText, Context);
+  ASSERT_TRUE(M != 0);
+
+  for (unsigned i = 0; i != sizeof(Options) / sizeof(Options[0]); ++i) {
+    SCOPED_TRACE(Options[i] ? Options[i] : "no option");
+    if (Options[i])
+      setEncoderOption(Options[i], true);
+    std::string Encoded = encode(M);
+    if (Options[i])
+      setEncoderOption(Options[i], false);
+
+    expectRoundTrip(*M, Encoded);
+  }
+
+  delete M;
+}
+
+TEST(RoundTripTest, FindsDifferences) {
+  LLVMContext ContextA, ContextB;
+  Module *A = parseModule(ModuleText, ContextA);
+  Module *B = parseModule(ModuleText, ContextB);
+  ASSERT_TRUE(A && B);
+
+  std::vector<std::string> Differences;
+  EXPECT_TRUE(ModuleComparator(*A, *B).compare(2, Differences));
+  EXPECT_TRUE(Differences.empty());
+
+  float Table[] = { 1.0f, 2.0f, 0.5f, 0.5f };
+  B->getNamedGlobal("table")->setInitializer(
+    ConstantDataArray::get(ContextB, Table));
+  BasicBlock &Entry = B->getFunction("kernel")->getEntryBlock();
+  for (BasicBlock::iterator I = Entry.begin(), E = Entry.end(); I != E; ++I)
+    if (StoreInst *Store = dyn_cast<StoreInst>(I)) {
+      Store->setAlignment(8);
+      break;
+    }
+
+  EXPECT_FALSE(ModuleComparator(*A, *B).compare(2, Differences));
+  ASSERT_EQ(2U, Differences.size());
+  EXPECT_EQ("definition of @table differs", Differences[0]);
+  EXPECT_EQ(0U, Differences[1].find("@kernel: store #6 of block %entry"))
+    << Differences[1];
+
+  delete A;
+  delete B;
+}
+
+} // end anonymous namespace
@@ -0,0 +1,114 @@
+//===-- StreamingTest.cpp - Tests for streaming SPIR output to a file -----===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// The raw_fd_ostream overload of WriteBitcodeToFile_SPIR writes completed
+// blocks to the file as it goes. These tests encode a module to a file with
+// small flush thresholds, so that block sizes are patched in the file, and
+// compare the file with the module encoded in memory.
+//
+//===---------------------------------------------------------------------===//
+
+#include "EncoderTestUtils.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+using namespace llvm;
+using namespace SPIRTest;
+
+namespace {
+
+const char ModuleText[] =
+  "target triple = \"spir-unknown-unknown\"\n"
+  "\n"
+  "%struct.pair = type { i32, float }\n"
+  "\n"
+  "@table = addrspace(2) constant [4 x float] [float 1.0, float 2.0,\n"
+  "  float 0.5, float 0.25], align 4\n"
+  "\n"
+  "define spir_func float @lookup(i32 %i) nounwind {\n"
+  "entry:\n"
+  "  %p = getelementptr inbounds [4 x float] addrspace(2)* @table, i32 0,\n"
+  "    i32 %i\n"
+  "  %v = load float addrspace(2)* %p, align 4\n"
+  "  ret float %v\n"
+  "}\n"
+  "\n"
+  "define spir_func i32 @select(i32 %a, i32 %b) nounwind {\n"
+  "entry:\n"
+  "  %cmp = icmp sgt i32 %a, %b\n"
+  "  br i1 %cmp, label %gt, label %done\n"
+  "gt:\n"
+  "  %d = sub i32 %a, %b\n"
+  "  br label %done\n"
+  "done:\n"
+  "  %r = phi i32 [ %d, %gt ], [ 7, %entry ]\n"
+  "  ret i32 %r\n"
+  "}\n"
+  "\n"
+  "define spir_kernel void @kernel(float addrspace(1)* %out, i32 %n) {\n"
+  "entry:\n"
+  "  %tmp = alloca %struct.pair, align 8\n"
+  "  %i = call spir_func i32 @select(i32 %n, i32 3)\n"
+  "  %f = call spir_func float @lookup(i32 %i)\n"
+  "  %field = getelementptr inbounds %struct.pair* %tmp, i32 0, i32 1\n"
+  "  store float %f, float* %field, align 4\n"
+  "  %ld = load float* %field, align 4\n"
+  "  store float %ld, float addrspace(1)* %out, align 4\n"
+  "  ret void\n"
+  "}\n"
+  "\n"
+  "!opencl.kernels = !{!0}\n"
+  "!0 = metadata !{void (float addrspace(1)*, i32)* @kernel}\n";
+
+std::string readFile(StringRef Path) {
+  std::ifstream In(Path.str().c_str(), std::ios::in | std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(In),
+                     std::istreambuf_iterator<char>());
+}
+
+class StreamingTest : public ::testing::Test {
+protected:
+  virtual void TearDown() {
+    setEncoderOption("spir-encoder-stream-threshold", 1024U*1024U);
+  }
+};
+
+TEST_F(StreamingTest, SameAsBuffered) {
+  LLVMContext Context;
+  Module *M = parseModule(ModuleText, Context);
+  ASSERT_TRUE(M != 0);
+  std::string Buffered = encode(M);
+
+  // From flushing after every block to not flushing before the end.
+  const unsigned Thresholds[] = { 0, 16, 64, 256, 1024*1024 };
+  for (unsigned t = 0; t != array_lengthof(Thresholds); ++t) {
+    setEncoderOption("spir-encoder-stream-threshold", Thresholds[t]);
+    int FD;
+    SmallString<128> Path;
+    ASSERT_FALSE(sys::fs::createTemporaryFile("StreamingTest", "bc", FD,
+                                              Path));
+    {
+      raw_fd_ostream File(FD, true);
+      SPIR::WriteBitcodeToFile_SPIR(M, File);
+    }
+    std::string Streamed = readFile(Path);
+    std::remove(Path.c_str());
+    EXPECT_TRUE(Streamed == Buffered) << "threshold " << Thresholds[t];
+  }
+
+  delete M;
+}
+
+} // end anonymous namespace
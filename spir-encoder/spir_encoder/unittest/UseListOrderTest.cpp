@@ -0,0 +1,232 @@
+//===-- UseListOrderTest.cpp - Tests for the SPIR use-list order blocks ---===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// With -enable-bc-uselist-preserve, the encoder writes the permutation from
+// the order the bitcode reader re-creates the uses of a value in to their
+// in-memory order. These tests reorder some use-lists of small modules,
+// decode the USELIST_BLOCK records of their encoding, and check the indexes
+// written.
+//
+//===---------------------------------------------------------------------===//
+
+#include "EncoderTestUtils.h"
+
+#include "llvm/Bitcode/BitstreamReader.h"
+#include "llvm/Bitcode/LLVMBitCodes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+
+#include <vector>
+
+using namespace llvm;
+using namespace SPIRTest;
+
+namespace {
+
+typedef std::vector<uint64_t> Indexes;
+
+/// The use-list order records of a module, without their value IDs.
+struct UseListRecords {
+  /// Records of the USELIST_BLOCK of the module block.
+  std::vector<Indexes> Module;
+  /// Records of the USELIST_BLOCKs of the function blocks, in order.
+  std::vector<Indexes> Functions;
+};
+
+bool readUseListBlock(BitstreamCursor &Stream, std::vector<Indexes> &Records) {
+  if (Stream.EnterSubBlock(bitc::USELIST_BLOCK_ID))
+    return false;
+
+  SmallVector<uint64_t, 16> Record;
+  while (true) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    if (Entry.Kind == BitstreamEntry::EndBlock)
+      return true;
+    if (Entry.Kind != BitstreamEntry::Record)
+      return false;
+
+    Record.clear();
+    unsigned Code = Stream.readRecord(Entry.ID, Record);
+    if (Code != bitc::USELIST_CODE_ENTRY || Record.empty())
+      return false;
+    Records.push_back(Indexes(Record.begin(), Record.end() - 1));
+  }
+}
+
+/// Reads the use-list order records of the block the cursor is in, and of
+/// the function blocks nested in it.
+bool readUseLists(BitstreamCursor &Stream, UseListRecords &Records,
+                  bool InFunction) {
+  while (true) {
+    BitstreamEntry Entry = Stream.advance();
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return false;
+    case BitstreamEntry::EndBlock:
+      return true;
+    case BitstreamEntry::Record:
+      Stream.skipRecord(Entry.ID);
+      break;
+    case BitstreamEntry::SubBlock:
+      if (Entry.ID == bitc::BLOCKINFO_BLOCK_ID) {
+        if (Stream.ReadBlockInfoBlock())
+          return false;
+      } else if (Entry.ID == bitc::USELIST_BLOCK_ID) {
+        if (!readUseListBlock(Stream, InFunction ? Records.Functions
+                                                 : Records.Module))
+          return false;
+      } else if (Entry.ID == bitc::FUNCTION_BLOCK_ID) {
+        if (Stream.EnterSubBlock(Entry.ID) ||
+            !readUseLists(Stream, Records, true))
+          return false;
+      } else if (Stream.SkipBlock()) {
+        return false;
+      }
+      break;
+    }
+  }
+}
+
+/// Encodes M with its use-list orders and decodes their records.
+bool encodeUseLists(const Module *M, UseListRecords &Records) {
+  std::string Encoded = encode(M);
+  const unsigned char *Begin = (const unsigned char *)Encoded.data();
+  BitstreamReader Reader(Begin, Begin + Encoded.size());
+  BitstreamCursor Stream(Reader);
+  Stream.JumpToBit(32);  // Skip the 'BC' 0xC0DE magic number.
+
+  BitstreamEntry Entry = Stream.advance();
+  if (Entry.Kind != BitstreamEntry::SubBlock ||
+      Entry.ID != bitc::MODULE_BLOCK_ID || Stream.EnterSubBlock(Entry.ID))
+    return false;
+  return readUseLists(Stream, Records, false);
+}
+
+Indexes indexes(uint64_t A, uint64_t B) {
+  Indexes I;
+  I.push_back(A);
+  I.push_back(B);
+  return I;
+}
+
+Indexes indexes(uint64_t A, uint64_t B, uint64_t C) {
+  Indexes I = indexes(A, B);
+  I.push_back(C);
+  return I;
+}
+
+class UseListOrderTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    setEncoderOption("enable-bc-uselist-preserve", true);
+  }
+
+  virtual void TearDown() {
+    setEncoderOption("enable-bc-uselist-preserve", false);
+  }
+};
+
+TEST_F(UseListOrderTest, Instructions) {
+  LLVMContext Context;
+  Module *M = parseModule(
+    "target triple = \"spir-unknown-unknown\"\n"
+    "\n"
+    "define spir_func i32 @f(i32 %x, i1 %c) {\n"
+    "entry:\n"
+    "  %a = add i32 %x, 1\n"
+    "  %b = add i32 %x, 2\n"
+    "  %d = add i32 %x, 3\n"
+    "  br label %loop\n"
+    "loop:\n"
+    "  %i = phi i32 [ %a, %entry ], [ %next, %loop ]\n"
+    "  %next = add i32 %i, %b\n"
+    "  %u = mul i32 %next, 5\n"
+    "  %w = mul i32 %next, %d\n"
+    "  br i1 %c, label %loop, label %exit\n"
+    "exit:\n"
+    "  ret i32 %w\n"
+    "}\n", Context);
+  ASSERT_TRUE(M != 0);
+
+  // As parsed, the use-lists are in the order the reader creates them in.
+  UseListRecords Records;
+  ASSERT_TRUE(encodeUseLists(M, Records));
+  EXPECT_TRUE(Records.Module.empty());
+  EXPECT_TRUE(Records.Functions.empty());
+
+  // Setting an operand again moves its use to the front of the use-list.
+  // The reader lists the uses of %x as [%d, %b, %a], they are now
+  // [%b, %d, %a].
+  Function *F = M->getFunction("f");
+  BasicBlock::iterator I = F->getEntryBlock().begin();
+  Instruction *B = &*++I;
+  B->setOperand(0, B->getOperand(0));
+  // The reader lists the uses of %next as [%w, %u], followed by its forward
+  // reference in the phi, they are now [phi, %w, %u].
+  PHINode *Phi = cast<PHINode>(F->getEntryBlock().getNextNode()->begin());
+  Phi->setIncomingValue(1, Phi->getIncomingValue(1));
+
+  Records = UseListRecords();
+  ASSERT_TRUE(encodeUseLists(M, Records));
+  EXPECT_TRUE(Records.Module.empty());
+  ASSERT_EQ(2U, Records.Functions.size());
+  EXPECT_EQ(indexes(1, 0, 2), Records.Functions[0]);
+  EXPECT_EQ(indexes(1, 2, 0), Records.Functions[1]);
+
+  delete M;
+}
+
+TEST_F(UseListOrderTest, InitializersAndAliases) {
+  // The reader sets the initializers from the last global to the first, then
+  // the aliasees from the last alias to the first. It lists the uses of @x
+  // as [@p, @a, @b], while they are [@p, @b, @a] as parsed.
+  LLVMContext Context;
+  Module *M = parseModule(
+    "target triple = \"spir-unknown-unknown\"\n"
+    "\n"
+    "@x = addrspace(1) global i32 0\n"
+    "@a = addrspace(1) global i32 addrspace(1)* @x\n"
+    "@b = addrspace(1) global i32 addrspace(1)* @x\n"
+    "@p = alias i32 addrspace(1)* @x\n", Context);
+  ASSERT_TRUE(M != 0);
+
+  UseListRecords Records;
+  ASSERT_TRUE(encodeUseLists(M, Records));
+  ASSERT_EQ(1U, Records.Module.size());
+  EXPECT_EQ(indexes(0, 2, 1), Records.Module[0]);
+  EXPECT_TRUE(Records.Functions.empty());
+
+  delete M;
+}
+
+TEST_F(UseListOrderTest, ConstantForwardReferences) {
+  // Integer constants are written first, so the ptrtoint refers to the
+  // getelementptr written after it. The reader re-creates the ptrtoint once
+  // the constants are read, and the order of the uses of the getelementptr,
+  // [ptrtoint, @w] as parsed, is not written.
+  LLVMContext Context;
+  Module *M = parseModule(
+    "target triple = \"spir-unknown-unknown\"\n"
+    "\n"
+    "@arr = addrspace(1) global [2 x i32] zeroinitializer\n"
+    "@w = addrspace(1) global i32 addrspace(1)* getelementptr ([2 x i32] "
+    "addrspace(1)* @arr, i32 0, i32 1)\n"
+    "@v = addrspace(1) global i32 ptrtoint (i32 addrspace(1)* getelementptr "
+    "([2 x i32] addrspace(1)* @arr, i32 0, i32 1) to i32)\n", Context);
+  ASSERT_TRUE(M != 0);
+
+  UseListRecords Records;
+  ASSERT_TRUE(encodeUseLists(M, Records));
+  EXPECT_TRUE(Records.Module.empty());
+  EXPECT_TRUE(Records.Functions.empty());
+
+  delete M;
+}
+
+} // end anonymous namespace
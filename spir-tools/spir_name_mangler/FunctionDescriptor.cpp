@@ -8,6 +8,7 @@
 //===---------------------------------------------------------------------===//
 
 #include "FunctionDescriptor.h"
+#include "ManglingUtils.h"
 #include "ParameterType.h"
 #include <sstream>
 
@@ -71,7 +72,7 @@ bool FunctionDescriptor::operator < (const FunctionDescriptor& that) const {
   TypeVector::const_iterator it = parameters.begin(),
   e = parameters.end(), thatit = that.parameters.begin();
   while (it != e) {
-    int cmp = (*it)->toString().compare((*thatit)->toString());
+    int cmp = (*it)->compare(*thatit);
     if (cmp)
       return (cmp < 0);
     ++thatit;
@@ -80,6 +81,14 @@ bool FunctionDescriptor::operator < (const FunctionDescriptor& that) const {
   return false;
 }
 
+size_t FunctionDescriptor::hash() const {
+  size_t h = hashString(name);
+  TypeVector::const_iterator it = parameters.begin(), e = parameters.end();
+  for (; it != e; ++it)
+    h = hashCombine(h, (*it)->hash());
+  return h;
+}
+
 bool FunctionDescriptor::isNull() const {
   return (name.empty() && parameters.empty());
 }
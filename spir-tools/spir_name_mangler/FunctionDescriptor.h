@@ -32,7 +32,13 @@ struct FunctionDescriptor {
   bool operator == (const FunctionDescriptor&) const;
 
   /// @brief Enables function descriptors to serve as keys in stl maps.
+  ///        Compares the parameter types structurally, no strings are built.
   bool operator < (const FunctionDescriptor&) const;
+
+  /// @brief Returns a structural hash of the function's prototype.
+  ///        Equal descriptors have the same hash.
+  /// @returns hash value.
+  size_t hash() const;
   bool isNull() const;
 
   /// @brief Create a singular value, that represents a 'null' FunctionDescriptor.
@@ -0,0 +1,156 @@
+//===------------------------- MangleCache.cpp ---------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+
+#include "MangleCache.h"
+#include "ManglingUtils.h"
+#include "ParameterType.h"
+
+namespace SPIR {
+
+// Number of buckets of an empty cache, must be a power of two.
+static const size_t InitialBuckets = 64;
+
+namespace {
+  // Walks the parameter types in the order the mangler does, recording the
+  // substitutions it would make.
+  class SharingVisitor : public TypeVisitor {
+  public:
+    SharingVisitor(SPIRversion ver, std::vector<int> &shape)
+        : TypeVisitor(ver), m_shape(shape) {}
+
+    MangleError visit(const PrimitiveType *) {
+      return MANGLE_SUCCESS;
+    }
+
+    MangleError visit(const VectorType *v) {
+      return v->getScalarType()->accept(this);
+    }
+
+    MangleError visit(const PointerType *p) {
+      if (substitute(p))
+        return MANGLE_SUCCESS;
+      return p->getPointee()->accept(this);
+    }
+
+    MangleError visit(const AtomicType *p) {
+      return p->getBaseType()->accept(this);
+    }
+
+    MangleError visit(const BlockType *p) {
+      for (unsigned int i = 0; i < p->getNumOfParams(); ++i)
+        p->getParam(i)->accept(this);
+      return MANGLE_SUCCESS;
+    }
+
+    MangleError visit(const UserDefinedType *pTy) {
+      substitute(pTy);
+      return MANGLE_SUCCESS;
+    }
+
+  private:
+    // Records the given type, returns true if it was seen before.
+    bool substitute(const ParamType *t) {
+      for (size_t i = 0; i < m_seen.size(); ++i) {
+        if (m_seen[i] == t) {
+          m_shape.push_back((int)i);
+          return true;
+        }
+      }
+      m_shape.push_back(-1);
+      m_seen.push_back(t);
+      return false;
+    }
+
+    std::vector<int> &m_shape;
+    std::vector<const ParamType*> m_seen;
+  };
+}
+
+// Computes the sharing shape of the given descriptor.
+static void computeShape(const FunctionDescriptor& fd, SPIRversion version,
+                         std::vector<int>& shape) {
+  SharingVisitor visitor(version, shape);
+  for (size_t i = 0; i < fd.parameters.size(); ++i)
+    fd.parameters[i]->accept(&visitor);
+}
+
+MangleCache::MangleCache(SPIRversion version) :
+  m_mangler(version), m_version(version), m_buckets(InitialBuckets), m_size(0) {
+}
+
+const MangleCache::Entry* MangleCache::find(const FunctionDescriptor& fd,
+                                            const SharingShape& shape,
+                                            size_t hash) const {
+  const Bucket& bucket = m_buckets[hash & (m_buckets.size() - 1)];
+  for (Bucket::const_iterator it = bucket.begin(), e = bucket.end();
+       it != e; ++it) {
+    if (it->hash == hash && it->shape == shape && it->fd == fd)
+      return &*it;
+  }
+  return NULL;
+}
+
+void MangleCache::grow() {
+  std::vector<Bucket> buckets(m_buckets.size() * 2);
+  for (size_t i = 0; i < m_buckets.size(); ++i) {
+    for (Bucket::const_iterator it = m_buckets[i].begin(),
+         e = m_buckets[i].end(); it != e; ++it)
+      buckets[it->hash & (buckets.size() - 1)].push_back(*it);
+  }
+  m_buckets.swap(buckets);
+}
+
+MangleError MangleCache::mangle(const FunctionDescriptor& fd,
+                                std::string& mangledName) {
+  SharingShape shape;
+  computeShape(fd, m_version, shape);
+  size_t hash = fd.hash();
+  for (size_t i = 0; i < shape.size(); ++i)
+    hash = hashCombine(hash, (size_t)(shape[i] + 1));
+  {
+    ScopedLock lock(m_lock);
+    if (const Entry* entry = find(fd, shape, hash)) {
+      mangledName.assign(entry->mangled);
+      return MANGLE_SUCCESS;
+    }
+  }
+
+  // Mangle without holding the lock; another thread may insert the same
+  // descriptor meanwhile, in which case the name is not stored twice.
+  MangleError err = m_mangler.mangle(fd, mangledName);
+  if (err != MANGLE_SUCCESS)
+    return err;
+
+  ScopedLock lock(m_lock);
+  if (find(fd, shape, hash))
+    return MANGLE_SUCCESS;
+  if (m_size >= m_buckets.size())
+    grow();
+  Entry entry;
+  entry.hash = hash;
+  entry.fd = fd;
+  entry.shape.swap(shape);
+  entry.mangled = mangledName;
+  m_buckets[hash & (m_buckets.size() - 1)].push_back(entry);
+  ++m_size;
+  return MANGLE_SUCCESS;
+}
+
+size_t MangleCache::size() const {
+  ScopedLock lock(m_lock);
+  return m_size;
+}
+
+void MangleCache::clear() {
+  ScopedLock lock(m_lock);
+  std::vector<Bucket>(InitialBuckets).swap(m_buckets);
+  m_size = 0;
+}
+
+} // End SPIR namespace
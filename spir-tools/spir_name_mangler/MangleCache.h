@@ -0,0 +1,79 @@
+//===-------------------------- MangleCache.h ----------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+
+#ifndef __MANGLE_CACHE_H__
+#define __MANGLE_CACHE_H__
+
+#include "FunctionDescriptor.h"
+#include "NameMangleAPI.h"
+#include "Threading.h"
+#include <string>
+#include <vector>
+
+namespace SPIR {
+  /// @brief Memoizes mangled names of function descriptors. Descriptors are
+  ///        looked up by their structural hash, so repeated prototypes are
+  ///        mangled only once. The mangler substitutes repeated pointer and
+  ///        user defined types by object identity, so the key also holds
+  ///        which of those parameter types are shared objects.
+  ///        The cache may be shared between threads. It keeps its own copy
+  ///        of each descriptor, sharing the parameter types with the caller,
+  ///        so the types must not be modified after they are cached.
+  class MangleCache {
+  public:
+    /// @brief Constructor.
+    /// @param SPIRversion spir version to mangle according to.
+    MangleCache(SPIRversion);
+
+    /// @brief Returns the mangled name of the given function descriptor,
+    ///        mangling it on the first request. Only successfully mangled
+    ///        names are cached.
+    /// @param FunctionDescriptor function to be mangled.
+    /// @param std::string the mangled name if the mangling succeeds,
+    ///        the error otherwise.
+    /// @return MangleError enum representing the status - success or the error.
+    MangleError mangle(const FunctionDescriptor&, std::string &);
+
+    /// @brief Returns the number of cached names.
+    size_t size() const;
+
+    /// @brief Drops all the cached names.
+    void clear();
+
+  private:
+    /// @brief For each substitutable type of a prototype, in mangling order,
+    ///        the index of the earlier occurrence of the same object, or -1
+    ///        for its first occurrence.
+    typedef std::vector<int> SharingShape;
+
+    struct Entry {
+      size_t hash;
+      FunctionDescriptor fd;
+      SharingShape shape;
+      std::string mangled;
+    };
+    typedef std::vector<Entry> Bucket;
+
+    /// @brief Looks up the given descriptor. The lock must be held.
+    /// @return cached entry, NULL if the descriptor is not cached.
+    const Entry* find(const FunctionDescriptor&, const SharingShape&,
+                      size_t hash) const;
+
+    /// @brief Doubles the number of buckets. The lock must be held.
+    void grow();
+
+    NameMangler m_mangler;
+    SPIRversion m_version;
+    std::vector<Bucket> m_buckets;
+    size_t m_size;
+    mutable Mutex m_lock;
+  };
+} // End SPIR namespace
+
+#endif //__MANGLE_CACHE_H__
@@ -11,62 +11,83 @@
 #include "ManglingUtils.h"
 #include "NameMangleAPI.h"
 #include "ParameterType.h"
+#include "Threading.h"
+#include <algorithm>
 #include <assert.h>
-#include <map>
+#include <stdint.h>
 #include <string>
-#include <sstream>
+#include <vector>
 
 namespace SPIR {
 
+// Appends the decimal representation of the given number.
+static void appendNumber(std::string &out, size_t n) {
+  char buffer[24];
+  char *ptr = buffer + sizeof(buffer);
+  do {
+    *--ptr = static_cast<char>('0' + n % 10);
+    n /= 10;
+  } while (n);
+  out.append(ptr, buffer + sizeof(buffer));
+}
+
 class MangleVisitor : public TypeVisitor {
 public:
-  MangleVisitor(SPIRversion ver, std::stringstream &s)
-      : TypeVisitor(ver), m_stream(s), m_nextSeqID(0) {}
+  MangleVisitor(SPIRversion ver, std::string &s)
+      : TypeVisitor(ver), m_stream(&s) {}
+
+  /// @brief Prepares the visitor for the parameters of another function,
+  ///        appending to the given string. The substitution table keeps its
+  ///        storage, so a visitor can be reused across a batch.
+  void reset(std::string &s) {
+    m_stream = &s;
+    m_substitutions.clear();
+  }
 
   //
   // Visit methods
   //
   MangleError visit(const PrimitiveType *t) {
-    m_stream << mangledPrimitiveString(t->getPrimitive());
+    m_stream->append(mangledPrimitiveString(t->getPrimitive()));
     return MANGLE_SUCCESS;
   }
 
   MangleError visit(const PointerType *p) {
     if (mangleSubstitution(reinterpret_cast<uintptr_t>(p)))
       return MANGLE_SUCCESS;
-    m_stream << "P";
+    m_stream->push_back('P');
     for (unsigned int i = ATTR_QUALIFIER_FIRST; i <= ATTR_QUALIFIER_LAST; i++) {
       TypeAttributeEnum qualifier = (TypeAttributeEnum)i;
       if (p->hasQualifier(qualifier)) {
-        m_stream << getMangledAttribute(qualifier);
+        m_stream->append(getMangledAttribute(qualifier));
       }
     }
-    m_stream << getMangledAttribute((p->getAddressSpace()));
+    m_stream->append(getMangledAttribute((p->getAddressSpace())));
     addSubstitution(reinterpret_cast<uintptr_t>(p));
     return p->getPointee()->accept(this);
   }
 
   MangleError visit(const VectorType *v) {
-    m_stream << "Dv" << v->getLength() << "_";
+    m_stream->append("Dv");
+    appendNumber(*m_stream, v->getLength());
+    m_stream->push_back('_');
     return v->getScalarType()->accept(this);
   }
 
   MangleError visit(const AtomicType *p) {
-    m_stream << "U"
-             << "7_Atomic";
+    m_stream->append("U7_Atomic");
     return p->getBaseType()->accept(this);
   }
 
   MangleError visit(const BlockType *p) {
-    m_stream << "U"
-             << "13block_pointerFv";
+    m_stream->append("U13block_pointerFv");
     for (unsigned int i = 0; i < p->getNumOfParams(); ++i) {
       MangleError err = p->getParam(i)->accept(this);
       if (err != MANGLE_SUCCESS) {
         return err;
       }
     }
-    m_stream << "E";
+    m_stream->push_back('E');
     return MANGLE_SUCCESS;
   }
 
@@ -74,7 +95,8 @@ public:
     if (mangleSubstitution(reinterpret_cast<uintptr_t>(pTy)))
       return MANGLE_SUCCESS;
     std::string name = pTy->toString();
-    m_stream << name.size() << name;
+    appendNumber(*m_stream, name.size());
+    m_stream->append(name);
     addSubstitution(reinterpret_cast<uintptr_t>(pTy));
     return MANGLE_SUCCESS;
   }
@@ -83,28 +105,28 @@ private:
   bool mangleSubstitution(uintptr_t id);
   void addSubstitution(uintptr_t id);
 
-  // Next substitution sequence number.
-  unsigned m_nextSeqID;
-
-
-  // Maps substitutable parameter to its m_substitutions sequence number.
-  std::map<uintptr_t, unsigned> m_substitutions;
+  // Substitutable parameters, indexed by their substitution sequence number.
+  // Prototypes have few substitutable parameters, so a linear lookup is
+  // cheaper than a map.
+  std::vector<uintptr_t> m_substitutions;
 
   // Holds the mangled string representing the prototype of the function.
-  std::stringstream &m_stream;
+  std::string *m_stream;
 };
 
 void MangleVisitor::addSubstitution(uintptr_t id) {
-  assert(!m_substitutions.count(id) && "Substitution already exists!");
-  m_substitutions[id] = m_nextSeqID++;
+  assert(std::find(m_substitutions.begin(), m_substitutions.end(), id) ==
+         m_substitutions.end() && "Substitution already exists!");
+  m_substitutions.push_back(id);
 }
 
 bool MangleVisitor::mangleSubstitution(uintptr_t id) {
-  std::map<uintptr_t, unsigned>::iterator I = m_substitutions.find(id);
+  std::vector<uintptr_t>::const_iterator I =
+    std::find(m_substitutions.begin(), m_substitutions.end(), id);
   if (I == m_substitutions.end())
     return false;
 
-  unsigned SeqID = I->second;
+  unsigned SeqID = (unsigned)(I - m_substitutions.begin());
 
   const size_t BufferSize = 10;
   char Buffer[BufferSize];
@@ -122,8 +144,9 @@ bool MangleVisitor::mangleSubstitution(uintptr_t id) {
     SeqID /= 36;
   }
 
-  m_stream << 'S' << std::string(BufferPtr, Buffer + BufferSize - BufferPtr)
-           << '_';
+  m_stream->push_back('S');
+  m_stream->append(BufferPtr, Buffer + BufferSize);
+  m_stream->push_back('_');
 
   return true;
 }
@@ -133,27 +156,165 @@ bool MangleVisitor::mangleSubstitution(uintptr_t id) {
 //
 NameMangler::NameMangler(SPIRversion version) : m_spir_version(version) {}
 
+// Appends the mangled prefix (_Z<len><name>) of the given function name.
+static void appendPrefix(std::string &out, const std::string &name) {
+  out.append("_Z");
+  appendNumber(out, name.length());
+  out.append(name);
+}
+
+// Builds the error message of a parameter type that failed to mangle.
+static void notSupportedMessage(std::string &msg, const ParamType &type,
+                                SPIRversion version) {
+  msg.assign("Type ");
+  msg.append(type.toString());
+  msg.append(" is not supported in ");
+  msg.append(getSPIRVersionAsString(version));
+}
+
+// Appends the mangled parameters of the given function, stopping at the first
+// unsupported parameter.
+// Returns the index of the failing parameter, or the number of parameters on
+// success.
+static size_t appendParams(MangleVisitor &visitor,
+                           const FunctionDescriptor &fd) {
+  for (size_t i = 0; i < fd.parameters.size(); ++i) {
+    if (fd.parameters[i]->accept(&visitor) == MANGLE_TYPE_NOT_SUPPORTED)
+      return i;
+  }
+  return fd.parameters.size();
+}
+
 MangleError NameMangler::mangle(const FunctionDescriptor &fd,
                                 std::string &mangledName) {
   if (fd.isNull()) {
     mangledName.assign(FunctionDescriptor::nullString());
     return MANGLE_NULL_FUNC_DESCRIPTOR;
   }
-  std::stringstream ret;
-  ret << "_Z" << fd.name.length() << fd.name;
+  std::string ret;
+  appendPrefix(ret, fd.name);
   MangleVisitor visitor(m_spir_version, ret);
-  for (unsigned int i = 0; i < fd.parameters.size(); ++i) {
-    MangleError err = fd.parameters[i]->accept(&visitor);
-    if (err == MANGLE_TYPE_NOT_SUPPORTED) {
-      mangledName.assign("Type ");
-      mangledName.append(fd.parameters[i]->toString());
-      mangledName.append(" is not supported in ");
-      std::string ver = getSPIRVersionAsString(m_spir_version);
-      mangledName.append(ver);
-      return err;
+  size_t failed = appendParams(visitor, fd);
+  if (failed != fd.parameters.size()) {
+    notSupportedMessage(mangledName, *fd.parameters[failed], m_spir_version);
+    return MANGLE_TYPE_NOT_SUPPORTED;
+  }
+  mangledName.swap(ret);
+  return MANGLE_SUCCESS;
+}
+
+MangleError NameMangler::mangleGroups(const FunctionDescriptor *fds,
+                                      size_t count, MangledNamePool &pool) {
+  pool.clear();
+  pool.offsets.reserve(count + 1);
+  pool.offsets.push_back(0);
+
+  MangleError result = MANGLE_SUCCESS;
+  std::string prefix, message;
+  const std::string *prefixName = NULL;
+  MangleVisitor visitor(m_spir_version, pool.buffer);
+  for (size_t i = 0; i < count; ++i) {
+    const FunctionDescriptor &fd = fds[i];
+    size_t start = pool.buffer.size();
+    MangleError err = MANGLE_SUCCESS;
+    if (fd.isNull()) {
+      err = MANGLE_NULL_FUNC_DESCRIPTOR;
+      pool.buffer.append(FunctionDescriptor::nullString());
+    } else {
+      // Consecutive overloads share the same prefix.
+      if (!prefixName || *prefixName != fd.name) {
+        prefix.clear();
+        appendPrefix(prefix, fd.name);
+        prefixName = &fd.name;
+      }
+      pool.buffer.append(prefix);
+      visitor.reset(pool.buffer);
+      size_t failed = appendParams(visitor, fd);
+      if (failed != fd.parameters.size()) {
+        err = MANGLE_TYPE_NOT_SUPPORTED;
+        notSupportedMessage(message, *fd.parameters[failed], m_spir_version);
+        pool.buffer.resize(start);
+        pool.buffer.append(message);
+      }
     }
+    if (err != MANGLE_SUCCESS && result == MANGLE_SUCCESS)
+      result = err;
+    pool.offsets.push_back(pool.buffer.size());
+  }
+  return result;
+}
+
+// Minimal number of functions a thread gets in a batch, smaller batches are
+// not worth the cost of starting a thread.
+static const size_t MinBatchPerThread = 64;
+
+namespace {
+  // A contiguous slice of a batch, mangled by a single thread.
+  struct BatchSlice {
+    NameMangler *mangler;
+    const FunctionDescriptor *fds;
+    std::string *out;
+    size_t begin, end;
+    // Status of the first function in the slice that failed, if any.
+    MangleError err;
+  };
+}
+
+static void mangleSlice(void *arg) {
+  BatchSlice *slice = static_cast<BatchSlice*>(arg);
+  slice->err = MANGLE_SUCCESS;
+  for (size_t i = slice->begin; i < slice->end; ++i) {
+    MangleError err = slice->mangler->mangle(slice->fds[i], slice->out[i]);
+    if (err != MANGLE_SUCCESS && slice->err == MANGLE_SUCCESS)
+      slice->err = err;
+  }
+}
+
+MangleError NameMangler::mangleBatch(const FunctionDescriptor *fds,
+                                     size_t count,
+                                     std::vector<std::string> &mangledNames,
+                                     unsigned numThreads) {
+  mangledNames.resize(count);
+  if (!count)
+    return MANGLE_SUCCESS;
+
+  if (!numThreads)
+    numThreads = Thread::hardwareConcurrency();
+  size_t maxThreads = (count + MinBatchPerThread - 1) / MinBatchPerThread;
+  if (numThreads > maxThreads)
+    numThreads = (unsigned)maxThreads;
+
+  std::vector<BatchSlice> slices(numThreads);
+  size_t chunk = count / numThreads, extra = count % numThreads, begin = 0;
+  for (unsigned t = 0; t < numThreads; ++t) {
+    BatchSlice &slice = slices[t];
+    slice.mangler = this;
+    slice.fds = fds;
+    slice.out = &mangledNames[0];
+    slice.begin = begin;
+    slice.end = begin + chunk + (t < extra ? 1 : 0);
+    begin = slice.end;
+  }
+
+  // The calling thread mangles the first slice; a slice whose thread could
+  // not be started is mangled here as well.
+  Thread *threads = new Thread[numThreads];
+  std::vector<bool> started(numThreads, false);
+  for (unsigned t = 1; t < numThreads; ++t)
+    started[t] = threads[t].start(mangleSlice, &slices[t]);
+  mangleSlice(&slices[0]);
+  for (unsigned t = 1; t < numThreads; ++t) {
+    if (started[t])
+      threads[t].join();
+    else
+      mangleSlice(&slices[t]);
+  }
+  delete[] threads;
+
+  for (unsigned t = 0; t < numThreads; ++t) {
+    if (slices[t].err != MANGLE_SUCCESS)
+      return slices[t].err;
   }
-  mangledName.assign(ret.str());
   return MANGLE_SUCCESS;
 }
 
@@ -173,4 +173,18 @@ namespace SPIR {
     }
   }
 
+  size_t hashCombine(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+  }
+
+  size_t hashString(const std::string& str) {
+    size_t h = 2166136261u;
+    for (std::string::const_iterator it = str.begin(), e = str.end();
+         it != e; ++it) {
+      h ^= (unsigned char)*it;
+      h *= 16777619u;
+    }
+    return h;
+  }
+
 } // End SPIR namespace
@@ -11,6 +11,7 @@
 #define __MANGLING_UTILS_H__
 
 #include "ParameterType.h"
+#include <string>
 
 namespace SPIR {
 
@@ -22,6 +23,11 @@ namespace SPIR {
 
   const SPIRversion getSupportedVersion(TypePrimitiveEnum t);
   const char* getSPIRVersionAsString(SPIRversion version);
+
+  /// @brief Mixes the given value into a running hash.
+  size_t hashCombine(size_t seed, size_t value);
+  /// @brief Returns a hash of the given string (FNV-1a).
+  size_t hashString(const std::string& str);
 } // End SPIR namespace
 
 #endif //__MANGLING_UTILS_H__
@@ -11,8 +11,45 @@
 
 #include "FunctionDescriptor.h"
 #include <string>
+#include <vector>
 
 namespace SPIR {
+  /// @brief Mangled names of a batch of functions, stored back to back in a
+  ///        single buffer.
+  struct MangledNamePool {
+    /// The concatenated names.
+    std::string buffer;
+    /// Name i occupies [offsets[i], offsets[i+1]) of the buffer.
+    std::vector<size_t> offsets;
+
+    /// @brief Returns the number of names in the pool.
+    size_t size() const {
+      return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    /// @brief Returns a pointer to the first character of name i. The name is
+    ///        not null terminated.
+    const char *data(size_t i) const {
+      return buffer.data() + offsets[i];
+    }
+
+    /// @brief Returns the length of name i.
+    size_t length(size_t i) const {
+      return offsets[i+1] - offsets[i];
+    }
+
+    /// @brief Returns a copy of name i.
+    std::string get(size_t i) const {
+      return buffer.substr(offsets[i], length(i));
+    }
+
+    /// @brief Removes all names, keeping the allocated storage.
+    void clear() {
+      buffer.clear();
+      offsets.clear();
+    }
+  };
+
   struct NameMangler {
 
     /// @brief Constructor.
@@ -29,6 +66,37 @@ namespace SPIR {
     ///        the error otherwise.
     /// @return MangleError enum representing the status - success or the error.
     MangleError mangle(const FunctionDescriptor&, std::string &);
+
+    /// @brief Mangles a batch of function descriptors, spreading the work
+    ///        over several threads. The descriptors may share parameter types
+    ///        (reference counting is atomic), but the types must not be
+    ///        modified while the batch is being mangled.
+    /// @param FunctionDescriptor array of functions to be mangled.
+    /// @param size_t number of functions in the array.
+    /// @param std::vector<std::string> resized to the number of functions;
+    ///        element i holds the mangled name of function i, or the error
+    ///        message if its mangling failed.
+    /// @param unsigned number of threads to use, zero to use one thread per
+    ///        hardware thread.
+    /// @return MANGLE_SUCCESS if all the functions were mangled, the error of
+    ///         the first function that failed otherwise.
+    MangleError mangleBatch(const FunctionDescriptor *, size_t,
+                            std::vector<std::string> &,
+                            unsigned numThreads = 0);
+
+    /// @brief Mangles a list of function descriptors into a string pool, on
+    ///        the calling thread. Lists where overloads of the same function
+    ///        are adjacent (e.g. a gentype family) mangle fastest, since the
+    ///        mangled prefix is reused across the group. The mangler state and
+    ///        the pool storage are reused for all the functions.
+    /// @param FunctionDescriptor array of functions to be mangled.
+    /// @param size_t number of functions in the array.
+    /// @param MangledNamePool receives the names; entry i holds the mangled
+    ///        name of function i, or the error message if its mangling failed.
+    /// @return MANGLE_SUCCESS if all the functions were mangled, the error of
+    ///         the first function that failed otherwise.
+    MangleError mangleGroups(const FunctionDescriptor *, size_t,
+                             MangledNamePool &);
   private:
     SPIRversion m_spir_version;
   };
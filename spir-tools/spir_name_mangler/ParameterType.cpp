@@ -42,6 +42,18 @@ namespace SPIR {
     return p && (m_primitive == p->m_primitive);
   }
 
+  size_t PrimitiveType::hash() const {
+    return hashCombine(m_typeId, m_primitive);
+  }
+
+  int PrimitiveType::compare(const ParamType* type) const {
+    const PrimitiveType* p = SPIR::dyn_cast<PrimitiveType>(type);
+    if (!p) {
+      return compareTypeId(type);
+    }
+    return (int)m_primitive - (int)p->m_primitive;
+  }
+
 
   //
   // Pointer Type
@@ -114,6 +126,31 @@ namespace SPIR {
     return (*getPointee()).equals(&*(p->getPointee()));
   }
 
+  size_t PointerType::hash() const {
+    size_t h = hashCombine(m_typeId, m_address_space);
+    for (unsigned int i = ATTR_QUALIFIER_FIRST; i <= ATTR_QUALIFIER_LAST; i++) {
+      h = hashCombine(h, hasQualifier((TypeAttributeEnum)i));
+    }
+    return hashCombine(h, getPointee()->hash());
+  }
+
+  int PointerType::compare(const ParamType* type) const {
+    const PointerType* p = SPIR::dyn_cast<PointerType>(type);
+    if (!p) {
+      return compareTypeId(type);
+    }
+    if (getAddressSpace() != p->getAddressSpace()) {
+      return (int)getAddressSpace() - (int)p->getAddressSpace();
+    }
+    for (unsigned int i = ATTR_QUALIFIER_FIRST; i <= ATTR_QUALIFIER_LAST; i++) {
+      TypeAttributeEnum qual = (TypeAttributeEnum)i;
+      if (hasQualifier(qual) != p->hasQualifier(qual)) {
+        return (int)hasQualifier(qual) - (int)p->hasQualifier(qual);
+      }
+    }
+    return getPointee()->compare(&*(p->getPointee()));
+  }
+
   //
   // Vector Type
   //
@@ -139,6 +176,21 @@ namespace SPIR {
       (*getScalarType()).equals(&*(pVec->getScalarType()));
   }
 
+  size_t VectorType::hash() const {
+    return hashCombine(hashCombine(m_typeId, m_len), getScalarType()->hash());
+  }
+
+  int VectorType::compare(const ParamType* type) const {
+    const VectorType* pVec = SPIR::dyn_cast<VectorType>(type);
+    if (!pVec) {
+      return compareTypeId(type);
+    }
+    if (m_len != pVec->m_len) {
+      return m_len - pVec->m_len;
+    }
+    return getScalarType()->compare(&*(pVec->getScalarType()));
+  }
+
   //
   //Atomic Type
   //
@@ -165,6 +217,18 @@ namespace SPIR {
     return (a && (*getBaseType()).equals(&*(a->getBaseType())));
   }
 
+  size_t AtomicType::hash() const {
+    return hashCombine(m_typeId, getBaseType()->hash());
+  }
+
+  int AtomicType::compare(const ParamType* type) const {
+    const AtomicType* a = dyn_cast<AtomicType>(type);
+    if (!a) {
+      return compareTypeId(type);
+    }
+    return getBaseType()->compare(&*(a->getBaseType()));
+  }
+
   //
   //Block Type
   //
@@ -204,6 +268,31 @@ namespace SPIR {
     return true;
   }
 
+  size_t BlockType::hash() const {
+    size_t h = hashCombine(m_typeId, getNumOfParams());
+    for (unsigned int i=0; i<getNumOfParams(); ++i) {
+      h = hashCombine(h, m_params[i]->hash());
+    }
+    return h;
+  }
+
+  int BlockType::compare(const ParamType* type) const {
+    const BlockType* pBlock = dyn_cast<BlockType>(type);
+    if (!pBlock) {
+      return compareTypeId(type);
+    }
+    if (getNumOfParams() != pBlock->getNumOfParams()) {
+      return (int)getNumOfParams() - (int)pBlock->getNumOfParams();
+    }
+    for (unsigned int i=0; i<getNumOfParams(); ++i) {
+      int cmp = getParam(i)->compare(&*pBlock->getParam(i));
+      if (cmp) {
+        return cmp;
+      }
+    }
+    return 0;
+  }
+
   //
   // User Defined Type
   //
@@ -226,6 +315,18 @@ namespace SPIR {
     return pTy && (m_name == pTy->m_name);
   }
 
+  size_t UserDefinedType::hash() const {
+    return hashCombine(m_typeId, hashString(m_name));
+  }
+
+  int UserDefinedType::compare(const ParamType* pType) const {
+    const UserDefinedType* pTy = SPIR::dyn_cast<UserDefinedType>(pType);
+    if (!pTy) {
+      return compareTypeId(pType);
+    }
+    return m_name.compare(pTy->m_name);
+  }
+
 
   //
   // Static enums
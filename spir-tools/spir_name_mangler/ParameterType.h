@@ -132,6 +132,18 @@ namespace SPIR {
     /// @return true if given param type is equal to this type and false otherwise.
     virtual bool equals(const ParamType*) const = 0;
 
+    /// @brief Returns a structural hash of the underlying type. Types that are
+    ///        equal have the same hash.
+    /// @return hash value.
+    virtual size_t hash() const = 0;
+
+    /// @brief Compares given param type with this type, without building
+    ///        string representations. The order is consistent with equals.
+    /// @param ParamType given param type.
+    /// @return negative value if this type orders before the given type, zero
+    ///         if they are equal and positive value otherwise.
+    virtual int compare(const ParamType*) const = 0;
+
     /// Common Base-Class Methods ///
 
     /// @brief Returns type id of underlying type.
@@ -145,6 +157,13 @@ namespace SPIR {
     ParamType();
 
   protected:
+    /// @brief Orders types of different kinds by their type id.
+    /// @param ParamType given param type.
+    /// @return difference between the type ids.
+    int compareTypeId(const ParamType* type) const {
+      return (int)m_typeId - (int)type->getTypeId();
+    }
+
     /// An enumeration to identify the type id of this instance.
     TypeEnum m_typeId;
   };
@@ -175,6 +194,15 @@ namespace SPIR {
     /// @return true if given param type is equal to this type and false otherwise.
     bool equals(const ParamType*) const;
 
+    /// @brief Returns a structural hash of the underlying type.
+    /// @return hash value.
+    size_t hash() const;
+
+    /// @brief Compares given param type with this type.
+    /// @param ParamType given param type.
+    /// @return negative, zero or positive value, like std::string::compare.
+    int compare(const ParamType*) const;
+
     /// Non-Common Methods ///
 
     /// @brief Returns the primitive enumeration of the type.
@@ -213,6 +241,15 @@ namespace SPIR {
     /// @return true if given param type is equal to this type and false otherwise.
     bool equals(const ParamType*) const;
 
+    /// @brief Returns a structural hash of the underlying type.
+    /// @return hash value.
+    size_t hash() const;
+
+    /// @brief Compares given param type with this type.
+    /// @param ParamType given param type.
+    /// @return negative, zero or positive value, like std::string::compare.
+    int compare(const ParamType*) const;
+
     /// Non-Common Methods ///
 
     /// @brief Returns the type the pointer is pointing at.
@@ -275,6 +312,15 @@ namespace SPIR {
     /// @return true if given param type is equal to this type and false otherwise.
     bool equals(const ParamType*) const;
 
+    /// @brief Returns a structural hash of the underlying type.
+    /// @return hash value.
+    size_t hash() const;
+
+    /// @brief Compares given param type with this type.
+    /// @param ParamType given param type.
+    /// @return negative, zero or positive value, like std::string::compare.
+    int compare(const ParamType*) const;
+
     /// Non-Common Methods ///
 
     /// @brief Returns the type the vector is packing.
@@ -321,6 +367,15 @@ namespace SPIR {
     /// @return true if given param type is equal to this type and false otherwise
     bool equals(const ParamType*) const;
 
+    /// @brief returns a structural hash of the underlying type.
+    /// @return hash value
+    size_t hash() const;
+
+    /// @brief compares given param type with this type.
+    /// @param ParamType given param type
+    /// @return negative, zero or positive value, like std::string::compare
+    int compare(const ParamType*) const;
+
     /// Non-Common Methods ///
 
     /// @brief returns the base type of the atomic parameter.
@@ -358,6 +413,15 @@ namespace SPIR {
     /// @return true if given param type is equal to this type and false otherwise
     bool equals(const ParamType*) const;
 
+    /// @brief returns a structural hash of the underlying type.
+    /// @return hash value
+    size_t hash() const;
+
+    /// @brief compares given param type with this type.
+    /// @param ParamType given param type
+    /// @return negative, zero or positive value, like std::string::compare
+    int compare(const ParamType*) const;
+
     /// Non-Common Methods ///
 
     /// @brief returns the number of parameters of the block.
@@ -419,6 +483,15 @@ namespace SPIR {
     /// @return true if given param type is equal to this type and false otherwise.
     bool equals(const ParamType*) const;
 
+    /// @brief Returns a structural hash of the underlying type.
+    /// @return hash value.
+    size_t hash() const;
+
+    /// @brief Compares given param type with this type.
+    /// @param ParamType given param type.
+    /// @return negative, zero or positive value, like std::string::compare.
+    int compare(const ParamType*) const;
+
   protected:
     /// The name of the user defined type.
     std::string m_name;
@@ -11,9 +11,17 @@
 #define __REF_COUNT_H__
 
 #include <assert.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace SPIR {
 
+/// @brief Shared ownership pointer.
+///        The reference counter is updated atomically, so copies of the same
+///        RefCount may be created and destroyed concurrently by different
+///        threads. The pointee itself is not synchronized: types shared
+///        between threads must not be modified once shared.
 template <typename T>
 class RefCount{
 public:
@@ -21,7 +29,7 @@ public:
   }
 
   RefCount(T* ptr): m_ptr(ptr) {
-    m_refCount = new int(1);
+    m_refCount = new long(1);
   }
 
   RefCount(const RefCount<T>& other) {
@@ -45,7 +53,7 @@ public:
   void init(T* ptr) {
     assert(!m_ptr && "overrunning non NULL pointer");
     assert(!m_refCount && "overrunning non NULL pointer");
-    m_refCount = new int(1);
+    m_refCount = new long(1);
     m_ptr = ptr;
   }
 
@@ -82,19 +90,20 @@ public:
 private:
   void sanity() const{
     assert(m_ptr && "NULL pointer");
+    // The counter value is not checked here, since other threads may be
+    // updating it concurrently.
     assert(m_refCount && "NULL ref counter");
-    assert(*m_refCount && "zero ref counter");
   }
 
   void cpy(const RefCount<T>& other) {
     m_refCount = other.m_refCount;
     m_ptr = other.m_ptr;
-    if (m_refCount) ++*m_refCount;
+    if (m_refCount) increment(m_refCount);
   }
 
   void dispose() {
     sanity();
-    if (0 == --*m_refCount) {
+    if (0 == decrement(m_refCount)) {
       delete m_refCount;
       delete m_ptr;
       m_ptr = 0;
@@ -102,7 +111,23 @@ private:
     }
   }
 
-  int* m_refCount;
+  static long increment(volatile long* counter) {
+#if defined(_MSC_VER)
+    return _InterlockedIncrement(counter);
+#else
+    return __sync_add_and_fetch(counter, 1);
+#endif
+  }
+
+  static long decrement(volatile long* counter) {
+#if defined(_MSC_VER)
+    return _InterlockedDecrement(counter);
+#else
+    return __sync_sub_and_fetch(counter, 1);
+#endif
+  }
+
+  long* m_refCount;
   T* m_ptr;
 };// End RefCount
 
@@ -0,0 +1,168 @@
+//===--------------------------- Threading.h -----------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+
+#ifndef __THREADING_H__
+#define __THREADING_H__
+
+#include <assert.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace SPIR {
+
+/// @brief Minimal portable mutex, so the mangler does not depend on LLVM
+///        support libraries.
+class Mutex {
+public:
+  Mutex() {
+#ifdef _WIN32
+    InitializeCriticalSection(&m_cs);
+#else
+    pthread_mutex_init(&m_mutex, 0);
+#endif
+  }
+
+  ~Mutex() {
+#ifdef _WIN32
+    DeleteCriticalSection(&m_cs);
+#else
+    pthread_mutex_destroy(&m_mutex);
+#endif
+  }
+
+  void lock() {
+#ifdef _WIN32
+    EnterCriticalSection(&m_cs);
+#else
+    pthread_mutex_lock(&m_mutex);
+#endif
+  }
+
+  void unlock() {
+#ifdef _WIN32
+    LeaveCriticalSection(&m_cs);
+#else
+    pthread_mutex_unlock(&m_mutex);
+#endif
+  }
+
+private:
+  Mutex(const Mutex&);
+  Mutex& operator=(const Mutex&);
+
+#ifdef _WIN32
+  CRITICAL_SECTION m_cs;
+#else
+  pthread_mutex_t m_mutex;
+#endif
+};
+
+/// @brief Locks the given mutex for the lifetime of the object.
+class ScopedLock {
+public:
+  explicit ScopedLock(Mutex& m) : m_mutex(m) {
+    m_mutex.lock();
+  }
+
+  ~ScopedLock() {
+    m_mutex.unlock();
+  }
+
+private:
+  ScopedLock(const ScopedLock&);
+  ScopedLock& operator=(const ScopedLock&);
+
+  Mutex& m_mutex;
+};
+
+/// @brief Minimal portable thread, running a single function to completion.
+class Thread {
+public:
+  typedef void (*Func)(void*);
+
+  Thread() : m_func(0), m_arg(0), m_started(false) {
+  }
+
+  ~Thread() {
+    join();
+  }
+
+  /// @brief Starts running func(arg) on a new thread.
+  /// @return false if the thread could not be created.
+  bool start(Func func, void* arg) {
+    assert(!m_started && "thread already started");
+    m_func = func;
+    m_arg = arg;
+#ifdef _WIN32
+    m_handle = CreateThread(NULL, 0, run, this, 0, NULL);
+    m_started = (m_handle != NULL);
+#else
+    m_started = (pthread_create(&m_handle, 0, run, this) == 0);
+#endif
+    return m_started;
+  }
+
+  /// @brief Waits for the thread to finish, if it was started.
+  void join() {
+    if (!m_started)
+      return;
+#ifdef _WIN32
+    WaitForSingleObject(m_handle, INFINITE);
+    CloseHandle(m_handle);
+#else
+    pthread_join(m_handle, 0);
+#endif
+    m_started = false;
+  }
+
+  /// @brief Returns the number of hardware threads, at least one.
+  static unsigned hardwareConcurrency() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long n = (long)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return n > 0 ? (unsigned)n : 1;
+  }
+
+private:
+  Thread(const Thread&);
+  Thread& operator=(const Thread&);
+
+#ifdef _WIN32
+  static DWORD WINAPI run(LPVOID self) {
+    Thread* t = static_cast<Thread*>(self);
+    t->m_func(t->m_arg);
+    return 0;
+  }
+
+  HANDLE m_handle;
+#else
+  static void* run(void* self) {
+    Thread* t = static_cast<Thread*>(self);
+    t->m_func(t->m_arg);
+    return 0;
+  }
+
+  pthread_t m_handle;
+#endif
+  Func m_func;
+  void* m_arg;
+  bool m_started;
+};
+
+} // End SPIR namespace
+
+#endif //__THREADING_H__
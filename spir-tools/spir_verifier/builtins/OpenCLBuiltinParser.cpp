@@ -0,0 +1,328 @@
+//===--------------------- OpenCLBuiltinParser.cpp -----------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+
+#include "OpenCLBuiltinParser.h"
+#include "spir_name_mangler/ParameterType.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace SPIR {
+
+typedef std::vector<std::string> TokenList;
+
+static const char *OverloadableAttr = "overloadable";
+
+/// @brief Removes comments and preprocessor directives from the header text.
+/// @param Src header contents.
+/// @returns header contents with declarations only.
+static std::string stripComments(const std::string &Src) {
+  std::string Out;
+  Out.reserve(Src.size());
+  bool LineStart = true;
+  for (size_t i = 0, e = Src.size(); i < e; ++i) {
+    if (Src[i] == '/' && i+1 < e && Src[i+1] == '/') {
+      while (i < e && Src[i] != '\n')
+        ++i;
+    } else if (Src[i] == '/' && i+1 < e && Src[i+1] == '*') {
+      i += 2;
+      while (i+1 < e && !(Src[i] == '*' && Src[i+1] == '/'))
+        ++i;
+      ++i;
+      Out += ' ';
+      continue;
+    } else if (LineStart && Src[i] == '#') {
+      // Skip the directive, including continuation lines.
+      while (i < e && Src[i] != '\n') {
+        if (Src[i] == '\\' && i+1 < e && Src[i+1] == '\n')
+          ++i;
+        ++i;
+      }
+    }
+    if (i >= e)
+      break;
+    Out += Src[i];
+    if (Src[i] == '\n')
+      LineStart = true;
+    else if (!isspace((unsigned char)Src[i]))
+      LineStart = false;
+  }
+  return Out;
+}
+
+/// @brief Splits a declaration into identifiers, numbers and punctuation.
+static TokenList tokenize(const std::string &Decl) {
+  TokenList Tokens;
+  for (size_t i = 0, e = Decl.size(); i < e;) {
+    unsigned char C = Decl[i];
+    if (isspace(C)) {
+      ++i;
+    } else if (isalnum(C) || C == '_') {
+      size_t Start = i;
+      while (i < e && (isalnum((unsigned char)Decl[i]) || Decl[i] == '_'))
+        ++i;
+      Tokens.push_back(Decl.substr(Start, i - Start));
+    } else {
+      Tokens.push_back(std::string(1, Decl[i]));
+      ++i;
+    }
+  }
+  return Tokens;
+}
+
+/// @brief Drops __attribute__((...)) groups and the attribute macros defined
+///        by opencl_spir.h. Sets IsOverloadable if the overloadable attribute
+///        was found.
+static TokenList dropAttributes(const TokenList &In, bool &IsOverloadable) {
+  TokenList Out;
+  IsOverloadable = false;
+  for (size_t i = 0, e = In.size(); i < e; ++i) {
+    if (In[i] == "const_func" || In[i] == "readonly")
+      continue;
+    if (In[i] != "__attribute__") {
+      Out.push_back(In[i]);
+      continue;
+    }
+    // Skip the balanced parentheses following the attribute keyword.
+    int Depth = 0;
+    for (++i; i < e; ++i) {
+      if (In[i] == "(")
+        ++Depth;
+      else if (In[i] == ")" && --Depth == 0)
+        break;
+      else if (In[i] == OverloadableAttr)
+        IsOverloadable = true;
+    }
+  }
+  return Out;
+}
+
+/// @brief Maps OpenCL C type names to the mangler's primitive types, for one
+///        of the SPIR pointer sizes.
+struct TypeTable {
+  explicit TypeTable(bool Is32Bit) {
+    Primitives["bool"] = PRIMITIVE_BOOL;
+    Primitives["uchar"] = PRIMITIVE_UCHAR;
+    Primitives["char"] = PRIMITIVE_CHAR;
+    Primitives["ushort"] = PRIMITIVE_USHORT;
+    Primitives["short"] = PRIMITIVE_SHORT;
+    Primitives["uint"] = PRIMITIVE_UINT;
+    Primitives["int"] = PRIMITIVE_INT;
+    Primitives["ulong"] = PRIMITIVE_ULONG;
+    Primitives["long"] = PRIMITIVE_LONG;
+    Primitives["half"] = PRIMITIVE_HALF;
+    Primitives["float"] = PRIMITIVE_FLOAT;
+    Primitives["double"] = PRIMITIVE_DOUBLE;
+    Primitives["void"] = PRIMITIVE_VOID;
+    Primitives["image1d_t"] = PRIMITIVE_IMAGE_1D_T;
+    Primitives["image1d_array_t"] = PRIMITIVE_IMAGE_1D_ARRAY_T;
+    Primitives["image1d_buffer_t"] = PRIMITIVE_IMAGE_1D_BUFFER_T;
+    Primitives["image2d_t"] = PRIMITIVE_IMAGE_2D_T;
+    Primitives["image2d_array_t"] = PRIMITIVE_IMAGE_2D_ARRAY_T;
+    Primitives["image3d_t"] = PRIMITIVE_IMAGE_3D_T;
+    Primitives["image2d_msaa_t"] = PRIMITIVE_IMAGE_2D_MSAA_T;
+    Primitives["image2d_array_msaa_t"] = PRIMITIVE_IMAGE_2D_ARRAY_MSAA_T;
+    Primitives["image2d_msaa_depth_t"] = PRIMITIVE_IMAGE_2D_MSAA_DEPTH_T;
+    Primitives["image2d_array_msaa_depth_t"] =
+      PRIMITIVE_IMAGE_2D_ARRAY_MSAA_DEPTH_T;
+    Primitives["image2d_depth_t"] = PRIMITIVE_IMAGE_2D_DEPTH_T;
+    Primitives["image2d_array_depth_t"] = PRIMITIVE_IMAGE_2D_ARRAY_DEPTH_T;
+    Primitives["event_t"] = PRIMITIVE_EVENT_T;
+    Primitives["sampler_t"] = PRIMITIVE_SAMPLER_T;
+
+    // Typedefs from opencl_spir.h.
+    Primitives["cl_mem_fence_flags"] = PRIMITIVE_UINT;
+    Primitives["size_t"] = Is32Bit ? PRIMITIVE_UINT : PRIMITIVE_ULONG;
+    Primitives["uintptr_t"] = Is32Bit ? PRIMITIVE_UINT : PRIMITIVE_ULONG;
+    Primitives["ptrdiff_t"] = Is32Bit ? PRIMITIVE_INT : PRIMITIVE_LONG;
+    Primitives["intptr_t"] = Is32Bit ? PRIMITIVE_INT : PRIMITIVE_LONG;
+  }
+
+  /// @brief Resolves a (possibly vector) type name.
+  /// @returns null reference if the name is unknown.
+  RefParamType get(const std::string &Name) const {
+    std::map<std::string, TypePrimitiveEnum>::const_iterator I =
+      Primitives.find(Name);
+    if (I != Primitives.end())
+      return RefParamType(new PrimitiveType(I->second));
+
+    // Vector types: <scalar><length>.
+    size_t Pos = Name.find_last_not_of("0123456789");
+    if (Pos == std::string::npos || Pos+1 == Name.size())
+      return RefParamType();
+    I = Primitives.find(Name.substr(0, Pos+1));
+    if (I == Primitives.end() || I->second > PRIMITIVE_DOUBLE)
+      return RefParamType();
+    int Len = atoi(Name.c_str() + Pos + 1);
+    if (Len != 2 && Len != 3 && Len != 4 && Len != 8 && Len != 16)
+      return RefParamType();
+    return RefParamType(
+      new VectorType(RefParamType(new PrimitiveType(I->second)), Len));
+  }
+
+private:
+  std::map<std::string, TypePrimitiveEnum> Primitives;
+};
+
+/// @brief Builds a mangler parameter type from the tokens of a single
+///        parameter declaration.
+/// @returns null reference if the parameter could not be parsed.
+static RefParamType parseParam(const TokenList &Tokens, const TypeTable &TT) {
+  bool Const = false, Volatile = false, Restrict = false;
+  TypeAttributeEnum AddrSpace = ATTR_PRIVATE;
+  bool Unsigned = false, Signed = false;
+  std::string BaseName;
+  RefParamType Ty;
+
+  for (size_t i = 0, e = Tokens.size(); i < e; ++i) {
+    const std::string &Tok = Tokens[i];
+    if (Tok == "const")
+      Const = true;
+    else if (Tok == "volatile")
+      Volatile = true;
+    else if (Tok == "restrict")
+      Restrict = true;
+    else if (Tok == "__global" || Tok == "global")
+      AddrSpace = ATTR_GLOBAL;
+    else if (Tok == "__local" || Tok == "local")
+      AddrSpace = ATTR_LOCAL;
+    else if (Tok == "__constant" || Tok == "constant")
+      AddrSpace = ATTR_CONSTANT;
+    else if (Tok == "__private" || Tok == "private")
+      AddrSpace = ATTR_PRIVATE;
+    else if (Tok == "__read_only" || Tok == "__write_only" ||
+             Tok == "__read_write" || Tok == "read_only" ||
+             Tok == "write_only" || Tok == "read_write")
+      continue; // Access qualifiers are not part of the mangled name.
+    else if (Tok == "unsigned")
+      Unsigned = true;
+    else if (Tok == "signed")
+      Signed = true;
+    else if (Tok == "*" || Tok == "[") {
+      if (Ty.isNull()) {
+        if (BaseName.empty())
+          BaseName = "int";
+        Ty = TT.get(Unsigned ? "u" + BaseName : BaseName);
+        if (Ty.isNull())
+          return Ty;
+      }
+      PointerType *P = new PointerType(Ty);
+      P->setAddressSpace(AddrSpace);
+      P->setQualifier(ATTR_CONST, Const);
+      P->setQualifier(ATTR_VOLATILE, Volatile);
+      P->setQualifier(ATTR_RESTRICT, Restrict);
+      Ty = RefParamType(P);
+      Const = Volatile = Restrict = false;
+      AddrSpace = ATTR_PRIVATE;
+      if (Tok == "[")
+        break; // Array parameters decay to pointers.
+    } else if (BaseName.empty() && Ty.isNull()) {
+      BaseName = Tok;
+    } else if (!Ty.isNull() || !BaseName.empty()) {
+      // Parameter name, or a qualifier applied to the pointer itself.
+      continue;
+    }
+  }
+
+  if (Ty.isNull()) {
+    if (BaseName.empty() && (Unsigned || Signed))
+      BaseName = "int";
+    if (BaseName.empty())
+      return Ty;
+    Ty = TT.get(Unsigned ? "u" + BaseName : BaseName);
+  }
+  return Ty;
+}
+
+/// @brief Parses a single declaration into a function descriptor.
+/// @returns false if the declaration is not an overloadable prototype, or if
+///          it uses types the generator does not know about.
+static bool parseDecl(const std::string &Decl, const TypeTable &TT,
+                      FunctionDescriptor &FD, std::string &Err) {
+  bool IsOverloadable;
+  TokenList Tokens = dropAttributes(tokenize(Decl), IsOverloadable);
+  if (!IsOverloadable)
+    return false;
+
+  size_t LParen = 0;
+  while (LParen < Tokens.size() && Tokens[LParen] != "(")
+    ++LParen;
+  if (LParen == 0 || LParen == Tokens.size()) {
+    Err = "cannot find function name";
+    return false;
+  }
+  FD.name = Tokens[LParen-1];
+  FD.parameters.clear();
+
+  TokenList Param;
+  int Depth = 0;
+  for (size_t i = LParen+1, e = Tokens.size(); i < e; ++i) {
+    const std::string &Tok = Tokens[i];
+    if (Tok == "(") {
+      ++Depth;
+    } else if (Depth == 0 && (Tok == "," || Tok == ")")) {
+      // "f(void)" has no parameters.
+      if (!(Param.size() == 1 && Param[0] == "void" &&
+            FD.parameters.empty() && Tok == ")")) {
+        RefParamType Ty = parseParam(Param, TT);
+        if (Ty.isNull()) {
+          Err = "cannot parse parameter of '" + FD.name + "'";
+          return false;
+        }
+        FD.parameters.push_back(Ty);
+      }
+      Param.clear();
+      if (Tok == ")")
+        return true;
+      continue;
+    } else if (Tok == ")") {
+      --Depth;
+    }
+    Param.push_back(Tok);
+  }
+  Err = "unterminated parameter list of '" + FD.name + "'";
+  return false;
+}
+
+void parseOpenCLBuiltins(const std::string &Header, bool Is32Bit,
+                         std::vector<FunctionDescriptor> &FDs,
+                         std::vector<std::string> &Errors) {
+  std::string Src = stripComments(Header);
+  TypeTable TT(Is32Bit);
+
+  size_t Start = 0;
+  for (size_t End = Src.find(';'); End != std::string::npos;
+       Start = End+1, End = Src.find(';', Start)) {
+    std::string Decl = Src.substr(Start, End - Start);
+    if (Decl.find(OverloadableAttr) == std::string::npos)
+      continue;
+
+    FunctionDescriptor FD;
+    std::string Err;
+    if (parseDecl(Decl, TT, FD, Err))
+      FDs.push_back(FD);
+    else if (!Err.empty())
+      Errors.push_back(Err);
+  }
+}
+
+bool readOpenCLHeader(const char *Path, std::string &Header) {
+  std::ifstream In(Path);
+  if (!In)
+    return false;
+  std::stringstream Buf;
+  Buf << In.rdbuf();
+  Header = Buf.str();
+  return true;
+}
+
+} // End SPIR namespace
@@ -0,0 +1,44 @@
+//===---------------------- OpenCLBuiltinParser.h ------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Reads the overloadable built-in prototypes declared in opencl_spir.h into
+// SPIR name mangler function descriptors.
+//
+//===---------------------------------------------------------------------===//
+
+#ifndef __OPENCL_BUILTIN_PARSER_H__
+#define __OPENCL_BUILTIN_PARSER_H__
+
+#include "spir_name_mangler/FunctionDescriptor.h"
+#include <string>
+#include <vector>
+
+namespace SPIR {
+
+/// @brief Parses the overloadable built-in declarations of an OpenCL C
+///        header, in declaration order.
+/// @param Header header contents.
+/// @param Is32Bit true to map size_t and related typedefs to 32-bit
+///        integers (SPIR32), false to map them to 64-bit integers (SPIR64).
+/// @param FDs receives a descriptor per parsed declaration.
+/// @param Errors receives a message per declaration that uses constructs
+///        or types the parser does not know about.
+void parseOpenCLBuiltins(const std::string &Header, bool Is32Bit,
+                         std::vector<FunctionDescriptor> &FDs,
+                         std::vector<std::string> &Errors);
+
+/// @brief Reads a header file.
+/// @param Path file to read.
+/// @param Header receives the file contents.
+/// @returns false if the file could not be read.
+bool readOpenCLHeader(const char *Path, std::string &Header);
+
+} // End SPIR namespace
+
+#endif // __OPENCL_BUILTIN_PARSER_H__
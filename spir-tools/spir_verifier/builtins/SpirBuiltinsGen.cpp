@@ -0,0 +1,115 @@
+//===----------------------- SpirBuiltinsGen.cpp -------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Build time utility that reads the overloadable built-in prototypes from
+// opencl_spir.h, mangles each of them with the SPIR name mangler and writes
+// the resulting names as an include file for the SPIR verifier.
+//
+// Usage: spir-builtins-gen <opencl_spir.h> <output .inc file>
+//
+//===---------------------------------------------------------------------===//
+
+#include "OpenCLBuiltinParser.h"
+#include "spir_name_mangler/FunctionDescriptor.h"
+#include "spir_name_mangler/NameMangleAPI.h"
+
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace SPIR;
+
+typedef std::set<std::string> NameSet;
+
+/// @brief Mangles all the overloadable declarations in Src.
+/// @returns number of declarations that were skipped.
+static unsigned collectNames(const std::string &Src, bool Is32Bit,
+                             NameSet &Names) {
+  std::vector<FunctionDescriptor> FDs;
+  std::vector<std::string> Errors;
+  parseOpenCLBuiltins(Src, Is32Bit, FDs, Errors);
+  for (size_t i = 0; i < Errors.size(); ++i)
+    std::cerr << "spir-builtins-gen: warning: " << Errors[i] << "\n";
+  unsigned Skipped = (unsigned)Errors.size();
+
+  NameMangler Mangler(SPIR12);
+  for (size_t i = 0; i < FDs.size(); ++i) {
+    std::string Mangled;
+    if (Mangler.mangle(FDs[i], Mangled) != MANGLE_SUCCESS) {
+      std::cerr << "spir-builtins-gen: warning: " << Mangled << "\n";
+      ++Skipped;
+      continue;
+    }
+    Names.insert(Mangled);
+  }
+  return Skipped;
+}
+
+static void writeSection(std::ostream &OS, const char *Macro,
+                         const NameSet &Names) {
+  OS << "#ifndef " << Macro << "\n"
+     << "#define " << Macro << "(Name)\n"
+     << "#endif\n";
+  for (NameSet::const_iterator I = Names.begin(), E = Names.end(); I != E; ++I)
+    OS << Macro << "(\"" << *I << "\")\n";
+  OS << "#undef " << Macro << "\n\n";
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " <opencl_spir.h> <output file>\n";
+    return 1;
+  }
+
+  std::string Src;
+  if (!readOpenCLHeader(argv[1], Src)) {
+    std::cerr << argv[0] << ": cannot open " << argv[1] << "\n";
+    return 1;
+  }
+
+  NameSet Names32, Names64;
+  unsigned Skipped = collectNames(Src, true, Names32);
+  collectNames(Src, false, Names64);
+  if (Names32.empty()) {
+    std::cerr << argv[0] << ": no built-in declarations found in "
+              << argv[1] << "\n";
+    return 1;
+  }
+
+  // Split into names shared by both pointer sizes and size specific ones.
+  NameSet Common, Only32, Only64;
+  for (NameSet::const_iterator I = Names32.begin(), E = Names32.end();
+       I != E; ++I)
+    (Names64.count(*I) ? Common : Only32).insert(*I);
+  for (NameSet::const_iterator I = Names64.begin(), E = Names64.end();
+       I != E; ++I)
+    if (!Names32.count(*I))
+      Only64.insert(*I);
+
+  std::ofstream Out(argv[2]);
+  if (!Out) {
+    std::cerr << argv[0] << ": cannot write " << argv[2] << "\n";
+    return 1;
+  }
+  Out << "//===- SpirBuiltins.inc - SPIR built-in mangled names -----*- C++ -*-===//\n"
+      << "//\n"
+      << "// Automatically generated by spir-builtins-gen from opencl_spir.h.\n"
+      << "// Do not edit.\n"
+      << "//\n"
+      << "//===---------------------------------------------------------------------===//\n\n";
+  writeSection(Out, "SPIR_BUILTIN", Common);
+  writeSection(Out, "SPIR_BUILTIN32", Only32);
+  writeSection(Out, "SPIR_BUILTIN64", Only64);
+
+  if (Skipped)
+    std::cerr << argv[0] << ": " << Skipped << " declarations skipped\n";
+  return 0;
+}
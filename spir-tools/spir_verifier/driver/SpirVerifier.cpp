@@ -12,14 +12,22 @@
 
 #if LLVM_VERSION==3200
   #include "llvm/LLVMContext.h"
+  #include "llvm/Module.h"
 #else
   #include "llvm/IR/LLVMContext.h"
+  #include "llvm/IR/Module.h"
+#endif
+#if LLVM_VERSION < 3500
+  #include "llvm/ADT/OwningPtr.h"
+  #include "llvm/Support/system_error.h"
+#else
+  #include <memory>
+  #include <system_error>
 #endif
-#include "llvm/ADT/OwningPtr.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
-#include "llvm/Support/system_error.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -31,8 +39,76 @@ InputFilename(cl::Positional, cl::desc("<input bitcode file>"),
 
 static cl::opt<bool> LITMode("LIT-test-mode", cl::init(false), cl::Hidden, cl::desc("Print output errors' names only, for LIT tests usage"));
 
+static cl::opt<bool> CheckAlignment("check-alignment", cl::init(false), cl::desc("Also report loads, stores and allocations aligned below their type as errors"));
+
+static cl::opt<bool> AlignmentSummary("alignment-summary", cl::init(false), cl::desc("Print the number of loads, stores and allocations checked for alignment in each kernel, implies -check-alignment"));
+
+static cl::opt<std::string> ResourceReport("resource-report", cl::init(""), cl::value_desc("filename"), cl::desc("Write an estimate of the memory used by each kernel to <filename>, '-' for the standard output"));
+
+enum ReportFormatTy { ReportText, ReportJSON };
+static cl::opt<ReportFormatTy> ResourceReportFormat("resource-report-format", cl::desc("Format of the -resource-report:"),
+    cl::values(clEnumValN(ReportText, "text", "one section per kernel (default)"),
+               clEnumValN(ReportJSON, "json", "a JSON object"),
+               clEnumValEnd),
+    cl::init(ReportText));
+
+static cl::opt<bool> PerfLint("perf-lint", cl::init(false), cl::desc("Also report code that is valid but likely slow on devices, as warnings"));
+
 const char *HelpMessage = "SPIR Verifier expects argument <path to file name>...\n";
 
+/// @brief Print the alignment counts of each kernel defined in M, adding
+///        the counts of the functions each kernel calls.
+static void printAlignmentSummary(const Module &M,
+                                  const FunctionToAlignmentCountMap &Counts,
+                                  const FunctionToKernelsMap &Callers) {
+  std::map<const Function*, AlignmentCount> KernelCounts;
+  FunctionToAlignmentCountMap::const_iterator ci = Counts.begin(),
+                                              ce = Counts.end();
+  for (; ci != ce; ci++) {
+    FunctionToKernelsMap::const_iterator ki = Callers.find(ci->first);
+    if (ki == Callers.end())
+      continue;
+    for (unsigned i=0; i<ki->second.size(); i++) {
+      AlignmentCount &Count = KernelCounts[ki->second[i]];
+      Count.Loads += ci->second.Loads;
+      Count.Stores += ci->second.Stores;
+      Count.Allocas += ci->second.Allocas;
+      Count.Misaligned += ci->second.Misaligned;
+    }
+  }
+
+  outs() << "Memory alignment per kernel:\n";
+  for (Module::const_iterator fi = M.begin(), fe = M.end(); fi != fe; fi++) {
+    if (fi->isDeclaration() || fi->getCallingConv() != CallingConv::SPIR_KERNEL)
+      continue;
+    const AlignmentCount &Count = KernelCounts[&*fi];
+    outs() << "  kernel " << fi->getName() << ": " << Count.Loads
+           << " loads, " << Count.Stores << " stores, " << Count.Allocas
+           << " allocas, " << Count.Misaligned << " misaligned\n";
+  }
+}
+
+/// @brief Write the estimated resources of each kernel to the
+///        -resource-report file.
+/// @returns false if the file can not be written.
+static bool writeResourceReport(const ResourceEstimator &Resources) {
+  std::string ErrorInfo;
+#if LLVM_VERSION < 3400
+  raw_fd_ostream OS(ResourceReport.c_str(), ErrorInfo);
+#else
+  raw_fd_ostream OS(ResourceReport.c_str(), ErrorInfo, sys::fs::F_None);
+#endif
+  if (!ErrorInfo.empty()) {
+    errs() << "Resource report creation error. " << ErrorInfo << "\n";
+    return false;
+  }
+  if (ResourceReportFormat == ReportJSON)
+    Resources.printJSON(OS);
+  else
+    Resources.print(OS);
+  return true;
+}
+
 int main(int argc, const char *argv[]) {
   cl::ParseCommandLineOptions(argc, argv, "SPIR verifier");
 
@@ -43,18 +119,28 @@ int main(int argc, const char *argv[]) {
 
   StringRef Path = InputFilename;
   LLVMContext Ctx;
+#if LLVM_VERSION < 3500
   OwningPtr<MemoryBuffer> result;
-
-  // Parse the bitcode file into a module.
   error_code ErrCode = MemoryBuffer::getFile(Path, result);
+#else
+  std::unique_ptr<MemoryBuffer> result;
+  std::error_code ErrCode = MemoryBuffer::getFile(Path, result);
+#endif
 
   if (!result.get()) {
     errs() << "Buffer Creation Error. " << ErrCode.message() << "\n";
     return 1;
   }
 
+  // Parse the bitcode file into a module.
+#if LLVM_VERSION < 3500
   std::string ErrMsg;
   Module *M = ParseBitcodeFile(result.get(), Ctx, &ErrMsg);
+#else
+  ErrorOr<Module *> Parsed = parseBitcodeFile(result.get(), Ctx);
+  std::string ErrMsg = Parsed ? "" : Parsed.getError().message();
+  Module *M = Parsed ? Parsed.get() : 0;
+#endif
   if (!M) {
     outs() << "According to this SPIR Verifier, " << Path << " is an invalid SPIR module.\n";
     errs() << "Bitcode parsing error. " << ErrMsg << "\n";
@@ -62,16 +148,33 @@ int main(int argc, const char *argv[]) {
   }
 
   // Run the verification pass, and report errors if necessary.
-  SpirValidation Validation;
+  SpirValidation Validation(PerfLint.getValue(), !ResourceReport.empty(),
+                            CheckAlignment || AlignmentSummary);
   Validation.runOnModule(*M);
   const ErrorPrinter *EP = Validation.getErrorPrinter();
-  if (EP->hasErrors()) {
+  bool Valid = !EP->hasErrors();
+  if (!Valid) {
     outs() << "According to this SPIR Verifier, " << Path << " is an invalid SPIR module.\n";
     errs() << "The module contains the following errors:\n\n";
     EP->print(errs(), LITMode.getValue());
-    return 1;
+  } else {
+    outs() << "According to this SPIR Verifier, " << Path << " is a valid SPIR module.\n";
   }
 
-  outs() << "According to this SPIR Verifier, " << Path << " is a valid SPIR module.\n";
-  return 0;
+  if (AlignmentSummary)
+    printAlignmentSummary(*M, Validation.getAlignmentCounts(),
+                          Validation.getKernelCallers());
+
+  // Warnings do not make the module invalid.
+  if (EP->hasWarnings()) {
+    errs() << "The module contains the following performance warnings:\n\n";
+    EP->printWarnings(errs(), LITMode.getValue(),
+                      Validation.getKernelCallers());
+  }
+
+  if (!ResourceReport.empty() &&
+      !writeResourceReport(Validation.getResources()))
+    return 1;
+
+  return Valid ? 0 : 1;
 }
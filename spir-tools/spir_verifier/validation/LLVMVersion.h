@@ -2,8 +2,14 @@
   #if (LLVM_VER_MAJOR == 3)
     #if (LLVM_VER_MINOR < 3)
       #define LLVM_VERSION 3200
-    #else
+    #elif (LLVM_VER_MINOR == 3)
       #define LLVM_VERSION 3300
+    #elif (LLVM_VER_MINOR == 4)
+      #define LLVM_VERSION 3400
+    #elif (LLVM_VER_MINOR == 5)
+      #define LLVM_VERSION 3500
+    #else
+      #error("unsupported LLVM version")
     #endif
   #else
     #error("unsupported LLVM version")
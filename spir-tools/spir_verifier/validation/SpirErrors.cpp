@@ -15,16 +15,22 @@
   #include "llvm/Type.h"
   #include "llvm/Value.h"
   #include "llvm/Metadata.h"
+  #include "llvm/Function.h"
+  #include "llvm/Instruction.h"
 #else
   #include "llvm/IR/Type.h"
   #include "llvm/IR/Value.h"
   #include "llvm/IR/Metadata.h"
+  #include "llvm/IR/Function.h"
+  #include "llvm/IR/Instruction.h"
 #endif
 #include "llvm/Support/raw_ostream.h"
 
 #include <string>
 #include <sstream>
 #include <map>
+#include <algorithm>
+#include <vector>
 
 using namespace llvm;
 
@@ -52,8 +58,11 @@ namespace SPIR {
   INFO_INDIRECT_CALL,
   INFO_NAMED_METADATA,
   INFO_METADATA_KERNEL_ARG_INFO,
+  INFO_METADATA_KERNEL_ATTRIBUTE,
   INFO_METADATA_VERSION,
   INFO_MEM_FENCE,
+  INFO_BUILTIN,
+  INFO_ALIGNMENT,
 
   SPIR_INFO_NUM
 } SPIR_INFO_TYPE;
@@ -89,6 +98,22 @@ protected:
   std::string ErrMSG;
 };
 
+/// @brief Performance warning, found in the body of a function.
+struct ValidationWarning {
+  /// @brief Constructor.
+  /// @param T warning type
+  /// @param S warning message
+  /// @param F function the warning was found in
+  ValidationWarning(SPIR_WARNING_TYPE T, llvm::StringRef S,
+                    const llvm::Function *F) :
+    WarnType(T), WarnMSG(S), Func(F) {
+  }
+
+  SPIR_WARNING_TYPE WarnType;
+  std::string WarnMSG;
+  const llvm::Function *Func;
+};
+
 struct ErrorComperator {
   const ValidationError * LHS;
 
@@ -120,6 +145,12 @@ struct SPIR_INFO_DATA {
 
 typedef std::map<SPIR_INFO_TYPE, unsigned> SPIRInfoTypeNumMap;
 
+struct SPIR_WARNING_DATA {
+  SPIR_WARNING_TYPE T;
+  std::string MSG;
+  std::string WarnTypeStr;
+};
+
 const SPIR_ERROR_DATA g_ErrorData[SPIR_ERROR_NUM] = {
   // Module (general) errors
   {ERR_INVALID_TRIPLE, "Invalid triple",
@@ -156,6 +187,12 @@ const SPIR_ERROR_DATA g_ErrorData[SPIR_ERROR_NUM] = {
       {INFO_INDIRECT_CALL}, "ERR_INVALID_INDIRECT_CALL"},
   {ERR_INVALID_MEM_FENCE, "Invalid cl_mem_fence value",
       {INFO_MEM_FENCE}, "ERR_INVALID_MEM_FENCE"},
+  {ERR_UNKNOWN_BUILTIN, "Call to unknown built-in function",
+      {INFO_BUILTIN}, "ERR_UNKNOWN_BUILTIN"},
+  {ERR_MISALIGNED_MEMORY_ACCESS, "Load or store aligned below the alignment of its type",
+      {INFO_ALIGNMENT}, "ERR_MISALIGNED_MEMORY_ACCESS"},
+  {ERR_MISALIGNED_ALLOCA, "Allocation aligned below the alignment of its type",
+      {INFO_ALIGNMENT}, "ERR_MISALIGNED_ALLOCA"},
   // Function errors
   {ERR_INVALID_CALLING_CONVENTION, "Invalid calling convention",
       {INFO_CALLING_CONVENTION}, "ERR_INVALID_CALLING_CONVENTION"},
@@ -176,12 +213,28 @@ const SPIR_ERROR_DATA g_ErrorData[SPIR_ERROR_NUM] = {
       {INFO_METADATA_KERNEL_ARG_INFO}, "ERR_INVALID_METADATA_KERNEL_INFO"},
   {ERR_MISSING_METADATA_KERNEL_INFO, "Kernel metadata is missing ARG Info",
       {INFO_METADATA_KERNEL_ARG_INFO}, "ERR_MISSING_METADATA_KERNEL_INFO"},
+  {ERR_INVALID_METADATA_KERNEL_ATTRIBUTE, "Invalid kernel attribute qualifier metadata",
+      {INFO_METADATA_KERNEL_ATTRIBUTE}, "ERR_INVALID_METADATA_KERNEL_ATTRIBUTE"},
   {ERR_INVALID_METADATA_VERSION, "Invalid OpenCL (OCL/SPIR) version",
       {INFO_METADATA_VERSION}, "ERR_INVALID_METADATA_VERSION"},
   {ERR_MISMATCH_METADATA_ADDR_SPACE, "Address space mismatch between kernel prototype and metadata",
       {}, "ERR_MISMATCH_METADATA_ADDR_SPACE"}
 };
 
+const SPIR_WARNING_DATA g_WarningData[SPIR_WARNING_NUM] = {
+  {WARN_UNDERALIGNED_VECTOR_ACCESS,
+      "Vector load or store aligned below the natural alignment of its type",
+      "WARN_UNDERALIGNED_VECTOR_ACCESS"},
+  {WARN_LARGE_PRIVATE_ALLOCA,
+      "Large or variable sized allocation in the private address space",
+      "WARN_LARGE_PRIVATE_ALLOCA"},
+  {WARN_SCALARIZED_GLOBAL_VECTOR_ACCESS,
+      "Scalar access to the elements of a __global vector",
+      "WARN_SCALARIZED_GLOBAL_VECTOR_ACCESS"},
+  {WARN_SMALL_MEMCPY, "llvm.memcpy of a small constant size",
+      "WARN_SMALL_MEMCPY"}
+};
+
 const SPIR_INFO_DATA g_InfoData[SPIR_INFO_NUM] = {
   {INFO_NONE, NULL},
   {INFO_TRIPLE, getValidTripleMsg},
@@ -203,8 +256,11 @@ const SPIR_INFO_DATA g_InfoData[SPIR_INFO_NUM] = {
   {INFO_INDIRECT_CALL, getValidIndirectCallMsg},
   {INFO_NAMED_METADATA, getValidNamedMetadataMsg},
   {INFO_METADATA_KERNEL_ARG_INFO, getValidKernelArgInfoMsg},
+  {INFO_METADATA_KERNEL_ATTRIBUTE, getValidKernelAttributeMsg},
   {INFO_METADATA_VERSION, getValidVersionMsg},
-  {INFO_MEM_FENCE, getValidMemFenceMsg}
+  {INFO_MEM_FENCE, getValidMemFenceMsg},
+  {INFO_BUILTIN, getValidBuiltinMsg},
+  {INFO_ALIGNMENT, getValidAlignmentMsg}
 };
 
 static bool isValidTables() {
@@ -218,6 +274,11 @@ static bool isValidTables() {
       return false;
   }
 
+  for (unsigned i=0; i<SPIR_WARNING_NUM; i++) {
+    if (g_WarningData[i].T != (SPIR_WARNING_TYPE)i)
+      return false;
+  }
+
   return true;
 }
 
@@ -264,6 +325,10 @@ ErrorHolder::~ErrorHolder() {
     const ValidationError *Err = *ei;
     delete Err;
   }
+  for (WarningList::iterator wi=WL.begin(), we=WL.end(); wi!=we; wi++) {
+    const ValidationWarning *Warn = *wi;
+    delete Warn;
+  }
 }
 
 void ErrorHolder::addError(SPIR_ERROR_TYPE Err, const llvm::StringRef S) {
@@ -301,6 +366,13 @@ void ErrorHolder::addError(SPIR_ERROR_TYPE Err, const llvm::Type *T,
   EL.push_back(VE);
 }
 
+void ErrorHolder::addWarning(SPIR_WARNING_TYPE Warn,
+                             const llvm::Instruction *I) {
+  ValidationWarning *VW = new ValidationWarning(Warn, getObjectAsString(I),
+    I->getParent()->getParent());
+  WL.push_back(VW);
+}
+
 void ErrorHolder::print(llvm::raw_ostream &S, bool LITMode) const {
   ErrorList UEL;
   SPIRInfoTypeNumMap ITmap;
@@ -376,4 +448,92 @@ bool ErrorHolder::hasErrors() const {
   return !EL.empty();
 }
 
+static bool isKernel(const Function *F) {
+  return F->getCallingConv() == CallingConv::SPIR_KERNEL;
+}
+
+/// @brief Number of warnings of each type found in a kernel and the
+///        functions it calls, or in a function no kernel calls.
+struct FunctionWarningCount {
+  FunctionWarningCount(const Function *F) : Func(F), Total(0) {
+    std::fill(Count, Count + SPIR_WARNING_NUM, 0);
+  }
+
+  const Function *Func;
+  unsigned Total;
+  unsigned Count[SPIR_WARNING_NUM];
+};
+
+/// @brief Count a warning of given type for given function, adding it in
+///        the order the functions were first counted for.
+static void countWarning(std::vector<FunctionWarningCount> &Counts,
+                         std::map<const Function*, unsigned> &Index,
+                         const Function *F, SPIR_WARNING_TYPE WarnType) {
+  std::map<const Function*, unsigned>::iterator fi = Index.find(F);
+  if (fi == Index.end()) {
+    fi = Index.insert(std::make_pair(F, (unsigned)Counts.size())).first;
+    Counts.push_back(FunctionWarningCount(F));
+  }
+  Counts[fi->second].Count[WarnType]++;
+  Counts[fi->second].Total++;
+}
+
+static void printWarningCounts(llvm::raw_ostream &S,
+                               const std::vector<FunctionWarningCount> &Counts) {
+  for (unsigned i=0; i<Counts.size(); i++) {
+    const FunctionWarningCount &FC = Counts[i];
+    S << "  " << (isKernel(FC.Func) ? "kernel " : "function ")
+      << FC.Func->getName() << ": " << FC.Total << "\n";
+    for (unsigned t=0; t<SPIR_WARNING_NUM; t++) {
+      if (FC.Count[t] != 0)
+        S << "    " << g_WarningData[t].WarnTypeStr << ": " << FC.Count[t]
+          << "\n";
+    }
+  }
+}
+
+void ErrorHolder::printWarnings(llvm::raw_ostream &S, bool LITMode,
+                                const FunctionToKernelsMap &Callers) const {
+  // Count the warnings of each kernel, including the functions it calls,
+  // and of the functions no kernel calls, in the order they were first
+  // warned about.
+  std::vector<FunctionWarningCount> KernelCounts, UncalledCounts;
+  std::map<const Function*, unsigned> KernelIndex, UncalledIndex;
+  unsigned WarnNum = 0;
+
+  for (WarningList::const_iterator wi=WL.begin(), we=WL.end(); wi!=we; wi++) {
+    const ValidationWarning *Warn = *wi;
+    FunctionToKernelsMap::const_iterator ki = Callers.find(Warn->Func);
+    if (ki != Callers.end() && !ki->second.empty()) {
+      for (unsigned i=0; i<ki->second.size(); i++)
+        countWarning(KernelCounts, KernelIndex, ki->second[i], Warn->WarnType);
+    } else {
+      countWarning(UncalledCounts, UncalledIndex, Warn->Func, Warn->WarnType);
+    }
+
+    S << "(" << ++WarnNum << ") Warning ";
+    if (!LITMode)
+      S << g_WarningData[Warn->WarnType].MSG << ":\n";
+    else
+      S << g_WarningData[Warn->WarnType].WarnTypeStr << ":\n";
+    S << Warn->WarnMSG << "\n";
+    S << "Found in " << (isKernel(Warn->Func) ? "kernel" : "function") << ": "
+      << Warn->Func->getName() << "\n\n";
+  }
+
+  // Print the number of warnings of each type per kernel.
+  if (!KernelCounts.empty()) {
+    S << "Warnings per kernel:\n";
+    printWarningCounts(S, KernelCounts);
+  }
+  if (!UncalledCounts.empty()) {
+    S << "Warnings in functions not called by a kernel:\n";
+    printWarningCounts(S, UncalledCounts);
+  }
+}
+
+bool ErrorHolder::hasWarnings() const {
+  return !WL.empty();
+}
+
 } // End SPIR namespace
@@ -11,10 +11,14 @@
 #define __SPIR_ERRORS_H__
 
 #include <list>
+#include <map>
+#include <vector>
 
 namespace llvm {
+  class Function;
   class Type;
   class Value;
+  class Instruction;
   class MDNode;
   class NamedMDNode;
   class StringRef;
@@ -47,6 +51,9 @@ typedef enum {
   ERR_INVALID_ADDR_SPACE_CAST,
   ERR_INVALID_INDIRECT_CALL,
   ERR_INVALID_MEM_FENCE,
+  ERR_UNKNOWN_BUILTIN,
+  ERR_MISALIGNED_MEMORY_ACCESS,
+  ERR_MISALIGNED_ALLOCA,
   // Function errors
   ERR_INVALID_CALLING_CONVENTION,
   ERR_INVALID_LINKAGE_TYPE,
@@ -58,12 +65,30 @@ typedef enum {
   ERR_INVALID_METADATA_KERNEL,
   ERR_INVALID_METADATA_KERNEL_INFO,
   ERR_MISSING_METADATA_KERNEL_INFO,
+  ERR_INVALID_METADATA_KERNEL_ATTRIBUTE,
   ERR_INVALID_METADATA_VERSION,
   ERR_MISMATCH_METADATA_ADDR_SPACE,
 
   SPIR_ERROR_NUM
 } SPIR_ERROR_TYPE;
 
+//
+// Performance Warnings
+//
+
+typedef enum {
+  WARN_UNDERALIGNED_VECTOR_ACCESS,
+  WARN_LARGE_PRIVATE_ALLOCA,
+  WARN_SCALARIZED_GLOBAL_VECTOR_ACCESS,
+  WARN_SMALL_MEMCPY,
+
+  SPIR_WARNING_NUM
+} SPIR_WARNING_TYPE;
+
+/// @brief Kernels reaching each defined function through direct calls, in
+///        module order. A kernel reaches itself.
+typedef std::map<const Function*, std::vector<const Function*> > FunctionToKernelsMap;
+
 struct ErrorPrinter {
   /// @brief prints all errors to given output stream.
   /// @param S output stream.
@@ -73,6 +98,19 @@ struct ErrorPrinter {
   /// @brief Checks if the module has errors.
   /// @returns true if errors list is not emtpy.
   virtual bool hasErrors() const = 0;
+
+  /// @brief prints all warnings to given output stream, followed by the
+  ///        number of warnings found in each kernel, including the
+  ///        functions it calls.
+  /// @param S output stream.
+  /// @param LITMode prints warning names only in when set to true
+  /// @param Callers kernels reaching each function.
+  virtual void printWarnings(llvm::raw_ostream &S, bool LITMode,
+                             const FunctionToKernelsMap &Callers) const = 0;
+
+  /// @brief Checks if the module has warnings.
+  /// @returns true if warnings list is not emtpy.
+  virtual bool hasWarnings() const = 0;
 };
 
 struct ErrorCreator {
@@ -106,11 +144,20 @@ struct ErrorCreator {
   virtual void addError(SPIR_ERROR_TYPE Err, const llvm::Type *T,
                                              const llvm::Value *V) = 0;
 
+  /// @brief Creates and adds new warning to the warning list. Warnings
+  ///        do not make the module invalid.
+  /// @param Warn warning type to be added.
+  /// @param I llvm instruction that leaded to the warning.
+  virtual void addWarning(SPIR_WARNING_TYPE Warn,
+                          const llvm::Instruction *I) = 0;
 };
 
 struct ValidationError;
 typedef std::list<const ValidationError*> ErrorList;
 
+struct ValidationWarning;
+typedef std::list<const ValidationWarning*> WarningList;
+
 
 struct ErrorHolder : ErrorCreator, ErrorPrinter {
   ErrorHolder();
@@ -124,14 +171,21 @@ struct ErrorHolder : ErrorCreator, ErrorPrinter {
                                              const llvm::StringRef S);
   virtual void addError(SPIR_ERROR_TYPE Err, const llvm::Type *T,
                                              const llvm::Value *V);
+  virtual void addWarning(SPIR_WARNING_TYPE Warn,
+                          const llvm::Instruction *I);
 
   /// Implementation of the pure virtual methods of ErrorPrinter interface
   virtual void print(llvm::raw_ostream &S, bool LITMode) const;
   virtual bool hasErrors() const;
+  virtual void printWarnings(llvm::raw_ostream &S, bool LITMode,
+                             const FunctionToKernelsMap &Callers) const;
+  virtual bool hasWarnings() const;
 
 private:
   /// @brief List of errors found in the module
   ErrorList EL;
+  /// @brief List of warnings found in the module
+  WarningList WL;
 };
 
 
@@ -10,6 +10,7 @@
 #include "LLVMVersion.h"
 #include "SpirIterators.h"
 #include "SpirErrors.h"
+#include "SpirResources.h"
 #include "SpirTables.h"
 
 #if LLVM_VERSION==3200
@@ -17,14 +18,27 @@
   #include "llvm/Function.h"
   #include "llvm/Instruction.h"
   #include "llvm/Instructions.h"
+  #include "llvm/IntrinsicInst.h"
+  #include "llvm/Operator.h"
+  #include "llvm/DataLayout.h"
   #include "llvm/Value.h"
 #else
   #include "llvm/IR/Module.h"
   #include "llvm/IR/Function.h"
   #include "llvm/IR/Instruction.h"
   #include "llvm/IR/Instructions.h"
+  #include "llvm/IR/IntrinsicInst.h"
+  #include "llvm/IR/Operator.h"
+  #include "llvm/IR/DataLayout.h"
   #include "llvm/IR/Value.h"
 #endif
+#if LLVM_VERSION < 3500
+  #include "llvm/Support/GetElementPtrTypeIterator.h"
+#else
+  #include "llvm/IR/GetElementPtrTypeIterator.h"
+#endif
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/ManagedStatic.h"
 
 
 #include <sstream>
@@ -206,6 +220,44 @@ static bool isAllowedIntrinsic(StringRef FName) {
   return IsValidIntrinsic || IsIgnoredIntrinsic;
 }
 
+/// @brief Hashed index over the mangled built-in names tables, built once
+///        per process on first use.
+struct BuiltinIndex {
+  BuiltinIndex() {
+    for (unsigned i = 0; i < g_valid_builtins_len; i++) {
+      Builtins32.insert(g_valid_builtins[i]);
+      Builtins64.insert(g_valid_builtins[i]);
+    }
+    for (unsigned i = 0; i < g_valid_builtins32_len; i++)
+      Builtins32.insert(g_valid_builtins32[i]);
+    for (unsigned i = 0; i < g_valid_builtins64_len; i++)
+      Builtins64.insert(g_valid_builtins64[i]);
+  }
+
+  StringSet<> Builtins32;
+  StringSet<> Builtins64;
+};
+
+static ManagedStatic<BuiltinIndex> g_BuiltinIndex;
+
+/// @brief Check if given function is a declaration of an unknown built-in.
+///        Mangled functions are not allowed to be external in SPIR unless
+///        they are OpenCL C built-in functions.
+/// @param F function to check.
+/// @param D data holder.
+/// @returns true if F is a declared mangled function that is not a valid
+///          built-in for the module's pointer size.
+static bool isUnknownBuiltin(const Function *F, DataHolder *D) {
+  if (!F->isDeclaration() || F->isIntrinsic())
+    return false;
+  StringRef FName = F->getName();
+  if (!FName.startswith(g_builtin_prefix))
+    return false;
+  const StringSet<> &Builtins =
+    D->Is32Bit ? g_BuiltinIndex->Builtins32 : g_BuiltinIndex->Builtins64;
+  return !Builtins.count(FName);
+}
+
 //
 // LLVM types validaiton
 //
@@ -482,6 +534,116 @@ static bool isValidLinkageType(llvm::GlobalValue::LinkageTypes LT) {
       || LT == llvm::GlobalValue::AvailableExternallyLinkage;
 }
 
+/// @brief Get the type and alignment of the memory accessed by given
+///        instruction.
+/// @param I instruction to check.
+/// @param Ty set to the accessed type.
+/// @param Ptr set to the pointer operand.
+/// @param Align set to the alignment of the access, 0 for the ABI alignment.
+/// @returns true if I is a load or a store, false otherwise.
+static bool getMemoryAccess(const Instruction *I, Type *&Ty,
+                            const Value *&Ptr, unsigned &Align) {
+  if (const LoadInst *LI = dyn_cast<LoadInst>(I)) {
+    Ty = LI->getType();
+    Ptr = LI->getPointerOperand();
+    Align = LI->getAlignment();
+    return true;
+  }
+  if (const StoreInst *SI = dyn_cast<StoreInst>(I)) {
+    Ty = SI->getValueOperand()->getType();
+    Ptr = SI->getPointerOperand();
+    Align = SI->getAlignment();
+    return true;
+  }
+  return false;
+}
+
+static bool isVectorType(Type *Ty) {
+  return Ty->isVectorTy();
+}
+
+static bool isPackedStructType(Type *Ty) {
+  StructType *STy = dyn_cast<StructType>(Ty);
+  return STy && STy->isPacked();
+}
+
+/// @brief Check if given pointer points inside an object of a type matching
+///        given predicate, that is if it is derived by bitcasts and
+///        getelementptrs from a pointer to such a type, or indexes into one.
+/// @param Ptr pointer to check.
+/// @param Pred predicate on the types Ptr is derived from.
+/// @returns true if Ptr points inside a matching object, false otherwise.
+static bool isDerivedFromPointerTo(const Value *Ptr, bool (*Pred)(Type*)) {
+  // Bound the walk, long chains of casts are not what this looks for.
+  for (unsigned Depth = 0; Depth < 8; Depth++) {
+    const Operator *Op = dyn_cast<Operator>(Ptr);
+    if (!Op)
+      return false;
+
+    if (const GEPOperator *GEP = dyn_cast<GEPOperator>(Op)) {
+      gep_type_iterator ti = gep_type_begin(GEP), te = gep_type_end(GEP);
+      for (; ti != te; ++ti) {
+        if (Pred(*ti))
+          return true;
+      }
+      Ptr = GEP->getPointerOperand();
+    } else if (Op->getOpcode() == Instruction::BitCast) {
+      Ptr = Op->getOperand(0);
+    } else {
+      return false;
+    }
+
+    PointerType *PtrTy = dyn_cast<PointerType>(Ptr->getType());
+    if (PtrTy && Pred(PtrTy->getElementType()))
+      return true;
+  }
+  return false;
+}
+
+/// @brief Add the program scope variables in the local and constant
+///        address spaces used by given value, directly or through constant
+///        expressions.
+/// @param V value to check.
+/// @param Globals set of variables to add to.
+static void collectGlobalUses(const Value *V,
+                              std::set<const GlobalVariable*> &Globals) {
+  if (const GlobalVariable *GV = dyn_cast<GlobalVariable>(V)) {
+    unsigned AddrSpace = GV->getType()->getAddressSpace();
+    if (AddrSpace == LOCAL_ADDR_SPACE || AddrSpace == CONSTANT_ADDR_SPACE)
+      Globals.insert(GV);
+    return;
+  }
+  if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(V)) {
+    for (unsigned i = 0; i < CE->getNumOperands(); i++)
+      collectGlobalUses(CE->getOperand(i), Globals);
+  }
+}
+
+//
+// Data holder (impl).
+//
+
+DataHolder::~DataHolder() {
+  delete Layout;
+}
+
+const DataLayout &DataHolder::getDataLayout() {
+  if (!Layout)
+    Layout = new DataLayout(Is32Bit ? SPIR32_DATA_LAYOUT : SPIR64_DATA_LAYOUT);
+  return *Layout;
+}
+
+//
+// Type alignment cache (impl).
+//
+
+unsigned TypeAlignmentCache::getAlignment(Type *Ty) {
+  unsigned &Align = Alignments[Ty];
+  if (!Align)
+    Align = Data->getDataLayout().getABITypeAlignment(Ty);
+  return Align;
+}
+
 //
 // Verify Executor classes (impl).
 //
@@ -521,6 +683,11 @@ void VerifyCall::execute(const Instruction *I) {
   if (F->isIntrinsic() && !isAllowedIntrinsic(F->getName())) {
     ErrCreator->addError(ERR_INVALID_INTRINSIC, I);
   }
+
+  // Verify that called mangled declarations are known built-ins.
+  if (isUnknownBuiltin(F, Data)) {
+    ErrCreator->addError(ERR_UNKNOWN_BUILTIN, I);
+  }
 }
 
 void VerifyBitcast::execute(const Instruction *I) {
@@ -554,6 +721,45 @@ void VerifyInstructionType::execute(const Instruction *I) {
     ErrCreator->addError(ERR_INVALID_LLVM_TYPE, Ty, I);
 }
 
+void VerifyMemoryAlignment::execute(const Instruction *I) {
+  const Function *F = I->getParent()->getParent();
+
+  // An alignment of zero stands for the ABI alignment of the type.
+  if (const AllocaInst *AI = dyn_cast<AllocaInst>(I)) {
+    AlignmentCount &Count = Counts[F];
+    Count.Allocas++;
+    Type *Ty = AI->getAllocatedType();
+    if (AI->getAlignment() != 0 &&
+        AI->getAlignment() < Alignments->getAlignment(Ty)) {
+      ErrCreator->addError(ERR_MISALIGNED_ALLOCA, Ty, I);
+      Count.Misaligned++;
+    }
+    return;
+  }
+
+  Type *Ty;
+  const Value *Ptr;
+  unsigned Align;
+  if (!getMemoryAccess(I, Ty, Ptr, Align))
+    return;
+
+  AlignmentCount &Count = Counts[F];
+  if (isa<LoadInst>(I))
+    Count.Loads++;
+  else
+    Count.Stores++;
+
+  if (Align == 0 || Align >= Alignments->getAlignment(Ty))
+    return;
+
+  // Members of packed structures may be aligned below their type.
+  if (isDerivedFromPointerTo(Ptr, isPackedStructType))
+    return;
+
+  ErrCreator->addError(ERR_MISALIGNED_MEMORY_ACCESS, Ty, I);
+  Count.Misaligned++;
+}
+
 void VerifyFunctionPrototype::execute(const Function *F) {
   if (!F->isDeclaration()) {
     // Verify calling convention for user defined functions
@@ -623,7 +829,12 @@ void VerifyGlobalVariable::execute(const GlobalVariable *GV) {
     // it is a function-scope variable,
     // must contain a prefix that is equal to the name of a function
     // and should be used only in it
+#if LLVM_VERSION < 3500
     for (Value::const_use_iterator ib = GV->use_begin(), ie = GV->use_end(); ib != ie; ++ib) {
+#else
+    // Use iterators visit the Use objects since LLVM 3.5.
+    for (Value::const_user_iterator ib = GV->user_begin(), ie = GV->user_end(); ib != ie; ++ib) {
+#endif
       if (const Instruction *Inst = dyn_cast<Instruction>(*ib)) {
         const Function * func = Inst->getParent()->getParent();
         if (!(GV->getName().startswith(func->getName().str() + "."))) {
@@ -642,7 +853,11 @@ void VerifyGlobalVariable::execute(const GlobalVariable *GV) {
 
 void VerifyTripleAndDataLayout::execute(const Module *M) {
   StringRef Triple(M->getTargetTriple());
+#if LLVM_VERSION < 3500
   StringRef DL(M->getDataLayout());
+#else
+  StringRef DL(M->getDataLayoutStr());
+#endif
 
   bool isTriple32 = (Triple == SPIR32_TRIPLE);
   bool isTriple64 = (Triple == SPIR64_TRIPLE);
@@ -737,6 +952,118 @@ void VerifyMetadataArgBaseType::execute(const llvm::MDNode *Node) {
   }
 }
 
+/// @brief Get the OpenCL C name of given vec_type_hint type.
+/// @param Ty type of the hint.
+/// @param IsSigned indicates a signed integer type.
+/// @returns the name, or an empty string if Ty is not a valid hint type.
+static std::string getVecTypeHintName(Type *Ty, bool IsSigned) {
+  unsigned NumElements = 1;
+  if (VectorType *VTy = dyn_cast<VectorType>(Ty)) {
+    NumElements = VTy->getNumElements();
+    if (!isValidVectorElementsNum(NumElements))
+      return "";
+    Ty = VTy->getElementType();
+  }
+
+  std::stringstream Name;
+  if (Ty->isHalfTy()) {
+    Name << "half";
+  } else if (Ty->isFloatTy()) {
+    Name << "float";
+  } else if (Ty->isDoubleTy()) {
+    Name << "double";
+  } else if (Ty->isIntegerTy()) {
+    if (!IsSigned)
+      Name << "u";
+    switch (cast<IntegerType>(Ty)->getBitWidth()) {
+    case 8:  Name << "char";  break;
+    case 16: Name << "short"; break;
+    case 32: Name << "int";   break;
+    case 64: Name << "long";  break;
+    default:
+      return "";
+    }
+  } else {
+    return "";
+  }
+  if (NumElements > 1)
+    Name << NumElements;
+  return Name.str();
+}
+
+void VerifyMetadataWorkGroupSize::execute(const llvm::MDNode *Node) {
+  if (!isMDNodeTypeOf(Node, Hint ? WORK_GROUP_SIZE_HINT : REQD_WORK_GROUP_SIZE))
+    return;
+
+  // Verify that the attribute appears once, and only on a kernel.
+  if (WasFound || Func->getCallingConv() != CallingConv::SPIR_KERNEL) {
+    ErrCreator->addError(ERR_INVALID_METADATA_KERNEL_ATTRIBUTE, Node);
+    return;
+  }
+  WasFound = true;
+
+  if (Node->getNumOperands() != 4) {
+    ErrCreator->addError(ERR_INVALID_METADATA_KERNEL_ATTRIBUTE, Node);
+    return;
+  }
+  // Verify that each dimension is a positive i32, and that the number of
+  // work-items in the work-group fits in 32 bits.
+  unsigned Size[3];
+  uint64_t WorkItems = 1;
+  for (unsigned i=1; i<4; i++) {
+    ConstantInt *Dim = dyn_cast<ConstantInt>(Node->getOperand(i));
+    if (!Dim || !Dim->getType()->isIntegerTy(32) || Dim->isZero()) {
+      ErrCreator->addError(ERR_INVALID_METADATA_KERNEL_ATTRIBUTE, Node);
+      return;
+    }
+    Size[i-1] = (unsigned)Dim->getZExtValue();
+    WorkItems *= Size[i-1];
+    if (WorkItems > 0xFFFFFFFFULL) {
+      ErrCreator->addError(ERR_INVALID_METADATA_KERNEL_ATTRIBUTE, Node);
+      return;
+    }
+  }
+
+  bool &Has = Hint ? Attrs.HasWorkGroupSizeHint : Attrs.HasReqdWorkGroupSize;
+  unsigned *AttrSize = Hint ? Attrs.WorkGroupSizeHint : Attrs.ReqdWorkGroupSize;
+  Has = true;
+  std::copy(Size, Size + 3, AttrSize);
+}
+
+void VerifyMetadataVecTypeHint::execute(const llvm::MDNode *Node) {
+  if (!isMDNodeTypeOf(Node, VEC_TYPE_HINT))
+    return;
+
+  // Verify that the attribute appears once, and only on a kernel.
+  if (WasFound || Func->getCallingConv() != CallingConv::SPIR_KERNEL) {
+    ErrCreator->addError(ERR_INVALID_METADATA_KERNEL_ATTRIBUTE, Node);
+    return;
+  }
+  WasFound = true;
+
+  // The type is given by an undef value of it, followed by its signedness.
+  if (Node->getNumOperands() != 3) {
+    ErrCreator->addError(ERR_INVALID_METADATA_KERNEL_ATTRIBUTE, Node);
+    return;
+  }
+  Value *TypeValue = Node->getOperand(1);
+  ConstantInt *IsSigned = dyn_cast<ConstantInt>(Node->getOperand(2));
+  if (!TypeValue || !isa<UndefValue>(TypeValue) ||
+      !IsSigned || IsSigned->getValue().ugt(1)) {
+    ErrCreator->addError(ERR_INVALID_METADATA_KERNEL_ATTRIBUTE, Node);
+    return;
+  }
+  std::string Name = getVecTypeHintName(TypeValue->getType(),
+                                        !IsSigned->isZero());
+  if (Name.empty()) {
+    ErrCreator->addError(ERR_INVALID_METADATA_KERNEL_ATTRIBUTE, Node);
+    return;
+  }
+
+  Attrs.HasVecTypeHint = true;
+  Attrs.VecTypeHint = Name;
+}
+
 void VerifyMetadataKernel::execute(const llvm::MDNode *Node) {
   // Verify that first operand is a valid function type.
   if (Node->getNumOperands() < 1) {
@@ -771,10 +1098,22 @@ void VerifyMetadataKernel::execute(const llvm::MDNode *Node) {
   // kernel arg base type metadata verifier.
   VerifyMetadataArgBaseType vmdabt(ErrCreator, F, Data);
   nel.push_back(&vmdabt);
+  // Attribute qualifiers metadata verifiers.
+  KernelAttributes Attrs;
+  VerifyMetadataWorkGroupSize vmdrwgs(ErrCreator, F, false, Attrs);
+  nel.push_back(&vmdrwgs);
+  VerifyMetadataWorkGroupSize vmdwgsh(ErrCreator, F, true, Attrs);
+  nel.push_back(&vmdwgsh);
+  VerifyMetadataVecTypeHint vmdvth(ErrCreator, F, Attrs);
+  nel.push_back(&vmdvth);
 
   MetaDataIterator mdi(nel);
   mdi.execute(*Node);
 
+  if (F->getCallingConv() == CallingConv::SPIR_KERNEL) {
+    AttributesMap[F] = Attrs;
+  }
+
   // Varify that metadata arg address space exists.
   if (!vmdaas.found()) {
     ErrCreator->addError(ERR_MISSING_METADATA_KERNEL_INFO, Node);
@@ -830,9 +1169,11 @@ void VerifyMetadataKernels::execute(const llvm::Module *M) {
   // ...
   // !10 = {metadata !"kernel_arg_base_type", metadata !"<TY1>", ...}
   // !11 = {metadata !"kernel_arg_type", metadata !"<TY1>", ...}
+  // !12 = {metadata !"reqd_work_group_size", i32 <X>, i32 <Y>, i32 <Z>}
+  // !13 = {metadata !"vec_type_hint", <TY> undef, i32 <IsSigned>}
 
   FunctionToMDNodeMap FoundMap;
-  VerifyMetadataKernel vmk(ErrCreator, Data, FoundMap);
+  VerifyMetadataKernel vmk(ErrCreator, Data, FoundMap, AttributesMap);
   for (unsigned i = 0; i < NumMDKernels; i++) {
     MDNode *N = dyn_cast<MDNode>(MDKernels->getOperand(i));
     if (!N) {
@@ -1045,5 +1386,156 @@ void VerifyMetadataCompilerOptions::execute(const llvm::Module *M) {
   }
 }
 
-} // End SPIR namespace
+//
+// Performance lint executor classes (impl).
+//
+void LintUnderalignedVectorAccess::execute(const Instruction *I) {
+  Type *Ty;
+  const Value *Ptr;
+  unsigned Align;
+  if (!getMemoryAccess(I, Ty, Ptr, Align))
+    return;
+
+  // An alignment of zero stands for the ABI alignment of the type.
+  if (!Ty->isVectorTy() || Align == 0)
+    return;
+
+  if (Align < Data->getDataLayout().getABITypeAlignment(Ty))
+    ErrCreator->addWarning(WARN_UNDERALIGNED_VECTOR_ACCESS, I);
+}
+
+void LintLargePrivateAlloca::execute(const Instruction *I) {
+  const AllocaInst *AI = dyn_cast<AllocaInst>(I);
+  if (!AI)
+    return;
+
+  const ConstantInt *ArraySize = dyn_cast<ConstantInt>(AI->getArraySize());
+  if (!ArraySize) {
+    // The size is only known at run time.
+    ErrCreator->addWarning(WARN_LARGE_PRIVATE_ALLOCA, I);
+    return;
+  }
+
+  uint64_t Size =
+    Data->getDataLayout().getTypeAllocSize(AI->getAllocatedType()) *
+    ArraySize->getZExtValue();
+  if (Size > g_perf_lint_private_alloca_size)
+    ErrCreator->addWarning(WARN_LARGE_PRIVATE_ALLOCA, I);
+}
+
+void LintScalarizedGlobalVectorAccess::execute(const Instruction *I) {
+  Type *Ty;
+  const Value *Ptr;
+  unsigned Align;
+  if (!getMemoryAccess(I, Ty, Ptr, Align))
+    return;
+
+  if (Ty->isVectorTy() ||
+      Ptr->getType()->getPointerAddressSpace() != GLOBAL_ADDR_SPACE)
+    return;
+
+  if (isDerivedFromPointerTo(Ptr, isVectorType))
+    ErrCreator->addWarning(WARN_SCALARIZED_GLOBAL_VECTOR_ACCESS, I);
+}
 
+void LintSmallMemcpy::execute(const Instruction *I) {
+  const MemCpyInst *MCI = dyn_cast<MemCpyInst>(I);
+  if (!MCI)
+    return;
+
+  const ConstantInt *Length = dyn_cast<ConstantInt>(MCI->getLength());
+  if (Length && Length->getZExtValue() <= g_perf_lint_small_memcpy_size)
+    ErrCreator->addWarning(WARN_SMALL_MEMCPY, I);
+}
+
+//
+// Resource collector executor classes (impl).
+//
+void CollectInstructionResources::execute(const Instruction *I) {
+  FunctionResources &R = Estimator->getFunction(I->getParent()->getParent());
+
+  if (const AllocaInst *AI = dyn_cast<AllocaInst>(I)) {
+    uint64_t Size =
+      Data->getDataLayout().getTypeAllocSize(AI->getAllocatedType());
+    const ConstantInt *ArraySize = dyn_cast<ConstantInt>(AI->getArraySize());
+    if (ArraySize) {
+      R.PrivateBytes += Size * ArraySize->getZExtValue();
+    } else {
+      // Count a single element, the size is only known at run time.
+      R.PrivateBytes += Size;
+      R.HasDynamicAlloca = true;
+    }
+    return;
+  }
+
+  if (const CallInst *CI = dyn_cast<CallInst>(I)) {
+    const Function *Callee = CI->getCalledFunction();
+    if (Callee && !Callee->isDeclaration())
+      R.Callees.insert(Callee);
+  }
+
+  for (unsigned i = 0; i < I->getNumOperands(); i++)
+    collectGlobalUses(I->getOperand(i), R.Globals);
+}
+
+void CollectKernelArgResources::execute(const Function *F) {
+  if (F->isDeclaration() || F->getCallingConv() != CallingConv::SPIR_KERNEL)
+    return;
+
+  Function::const_arg_iterator ai = F->arg_begin(), ae = F->arg_end();
+  for (; ai != ae; ai++) {
+    if (PointerType *PtrTy = dyn_cast<PointerType>(ai->getType()))
+      Estimator->addPointerArg(F, PtrTy->getAddressSpace());
+  }
+}
+
+void CollectGlobalResources::execute(const GlobalVariable *GV) {
+  unsigned AddrSpace = GV->getType()->getAddressSpace();
+  if (AddrSpace != LOCAL_ADDR_SPACE && AddrSpace != CONSTANT_ADDR_SPACE)
+    return;
+
+  Type *Ty = GV->getType()->getElementType();
+  if (Ty->isSized())
+    Estimator->setGlobalSize(GV, Data->getDataLayout().getTypeAllocSize(Ty));
+}
+
+//
+// Report executor classes (impl).
+//
+void CollectKernelCallers::execute(const Module *M) {
+  // Direct calls to defined functions, collected in a single pass.
+  std::map<const Function*, std::set<const Function*> > Callees;
+  Module::const_iterator fi = M->begin(), fe = M->end();
+  for (; fi != fe; fi++) {
+    std::set<const Function*> &FC = Callees[&*fi];
+    Function::const_iterator bi = fi->begin(), be = fi->end();
+    for (; bi != be; bi++) {
+      BasicBlock::const_iterator ii = bi->begin(), ie = bi->end();
+      for (; ii != ie; ii++) {
+        const CallInst *CI = dyn_cast<CallInst>(&*ii);
+        const Function *Callee = CI ? CI->getCalledFunction() : 0;
+        if (Callee && !Callee->isDeclaration())
+          FC.insert(Callee);
+      }
+    }
+  }
+
+  for (fi = M->begin(); fi != fe; fi++) {
+    const Function *K = &*fi;
+    if (K->isDeclaration() || K->getCallingConv() != CallingConv::SPIR_KERNEL)
+      continue;
+
+    std::set<const Function*> Visited;
+    std::vector<const Function*> Worklist(1, K);
+    while (!Worklist.empty()) {
+      const Function *F = Worklist.back();
+      Worklist.pop_back();
+      if (!Visited.insert(F).second)
+        continue;
+      Callers[F].push_back(K);
+      Worklist.insert(Worklist.end(), Callees[F].begin(), Callees[F].end());
+    }
+  }
+}
+
+} // End SPIR namespace
@@ -10,10 +10,16 @@
 #ifndef __SPIR_ITERATORS_H__
 #define __SPIR_ITERATORS_H__
 
+#include "SpirErrors.h"
+#include "SpirResources.h"
+#include "llvm/ADT/DenseMap.h"
+
 #include <list>
 #include <map>
 
 namespace llvm {
+class DataLayout;
+class Type;
 class Value;
 class Instruction;
 class BasicBlock;
@@ -170,9 +176,16 @@ struct DataHolder {
   DataHolder() :
     Is32Bit(true),
     HasDoubleFeature(false), HasImageFeature(false),
-    HASFp16Extension(false) {
+    HASFp16Extension(false), Layout(0) {
   }
 
+  ~DataHolder();
+
+  /// @brief Get the SPIR data layout matching the module's pointer size. It
+  ///        is parsed on first use, and belongs to this validation run.
+  /// @returns SPIR32 or SPIR64 data layout.
+  const DataLayout &getDataLayout();
+
   /// @brief Sizeof pointer indectaor
   bool Is32Bit;
 
@@ -188,8 +201,46 @@ struct DataHolder {
 
   /// @brief indicator for presence of cl_khr_fp16 KHR extension
   bool HASFp16Extension;
+
+private:
+  DataHolder(const DataHolder &);            // Do not implement
+  void operator=(const DataHolder &);        // Do not implement
+
+  /// @brief SPIR data layout, parsed on first use.
+  DataLayout *Layout;
+};
+
+/// @brief ABI alignment of types in the SPIR data layout matching the
+///        module's pointer size, computed once per type.
+struct TypeAlignmentCache {
+  /// @brief Constructor.
+  /// @param D data holder.
+  TypeAlignmentCache(DataHolder *D) : Data(D) {
+  }
+
+  /// @brief Get the alignment of given type.
+  /// @param Ty sized type.
+  /// @returns alignment of Ty in bytes.
+  unsigned getAlignment(Type *Ty);
+
+private:
+  DataHolder *Data;
+  llvm::DenseMap<Type*, unsigned> Alignments;
+};
+
+/// @brief Number of memory accesses of a function checked for alignment.
+struct AlignmentCount {
+  AlignmentCount() : Loads(0), Stores(0), Allocas(0), Misaligned(0) {
+  }
+
+  unsigned Loads;
+  unsigned Stores;
+  unsigned Allocas;
+  unsigned Misaligned;
 };
 
+typedef std::map<const Function*, AlignmentCount> FunctionToAlignmentCountMap;
+
 //
 // Verify Executor classes.
 //
@@ -197,7 +248,8 @@ struct DataHolder {
 struct VerifyCall : public InstructionExecutor {
   /// @brief Constructor.
   /// @param EH error holder.
-  VerifyCall(ErrorCreator *EH) : ErrCreator(EH) {
+  /// @param D data holder.
+  VerifyCall(ErrorCreator *EH, DataHolder *D) : ErrCreator(EH), Data(D) {
   }
 
   /// @brief Verify that given instruction is not invalid call instruction.
@@ -206,6 +258,7 @@ struct VerifyCall : public InstructionExecutor {
 
 private:
   ErrorCreator *ErrCreator;
+  DataHolder *Data;
 };
 
 struct VerifyBitcast : public InstructionExecutor {
@@ -240,6 +293,27 @@ private:
   DataHolder *Data;
 };
 
+struct VerifyMemoryAlignment : public InstructionExecutor {
+  /// @brief Constructor.
+  /// @param EH error holder.
+  /// @param TAC type alignment cache.
+  /// @param Map counts of checked accesses per function.
+  VerifyMemoryAlignment(ErrorCreator *EH, TypeAlignmentCache *TAC,
+    FunctionToAlignmentCountMap& Map) :
+    ErrCreator(EH), Alignments(TAC), Counts(Map) {
+  }
+
+  /// @brief Verify that given load, store or alloca instruction is aligned
+  ///        at least to the alignment of its type.
+  /// @param I instruction to verify.
+  void execute(const Instruction *I);
+
+private:
+  ErrorCreator *ErrCreator;
+  TypeAlignmentCache *Alignments;
+  FunctionToAlignmentCountMap& Counts;
+};
+
 struct VerifyFunctionPrototype : public FunctionExecutor {
   /// @brief Constructor.
   /// @param EH error holder.
@@ -371,13 +445,64 @@ private:
   bool WasFound;
 };
 
+struct VerifyMetadataWorkGroupSize : public MDNodeExecutor {
+  /// @brief Constructor.
+  /// @param EH error holder.
+  /// @param F the function the kernel metadata is describing.
+  /// @param IsHint verify work_group_size_hint when set to true,
+  ///        reqd_work_group_size otherwise.
+  /// @param A attributes to store the parsed size in.
+  VerifyMetadataWorkGroupSize(ErrorCreator *EH, Function *F, bool IsHint,
+    KernelAttributes &A) :
+    ErrCreator(EH), Func(F), Hint(IsHint), Attrs(A), WasFound(false) {
+  }
+
+  /// @brief Verify that given metadata node is valid work-group size
+  ///        metadata.
+  /// @param Node metadata node to verify.
+  void execute(const MDNode *Node);
+
+private:
+  ErrorCreator *ErrCreator;
+  Function *Func;
+  bool Hint;
+  KernelAttributes &Attrs;
+  bool WasFound;
+};
+
+struct VerifyMetadataVecTypeHint : public MDNodeExecutor {
+  /// @brief Constructor.
+  /// @param EH error holder.
+  /// @param F the function the kernel metadata is describing.
+  /// @param A attributes to store the parsed type in.
+  VerifyMetadataVecTypeHint(ErrorCreator *EH, Function *F,
+    KernelAttributes &A) :
+    ErrCreator(EH), Func(F), Attrs(A), WasFound(false) {
+  }
+
+  /// @brief Verify that given metadata node is valid vec type hint metadata.
+  /// @param Node metadata node to verify.
+  void execute(const MDNode *Node);
+
+private:
+  ErrorCreator *ErrCreator;
+  Function *Func;
+  KernelAttributes &Attrs;
+  bool WasFound;
+};
+
 typedef std::map<const Function*, const MDNode*> FunctionToMDNodeMap;
 struct VerifyMetadataKernel : public MDNodeExecutor {
   /// @brief Constructor.
   /// @param EH error holder.
+  /// @param D data holder.
+  /// @param Map kernel metadata nodes found so far.
+  /// @param Attributes map to store the attribute qualifiers of each
+  ///        kernel in.
   VerifyMetadataKernel(ErrorCreator *EH,
-    DataHolder *D, FunctionToMDNodeMap& Map) :
-    ErrCreator(EH), Data(D), FoundMap(Map) {
+    DataHolder *D, FunctionToMDNodeMap& Map,
+    FunctionToKernelAttributesMap& Attributes) :
+    ErrCreator(EH), Data(D), FoundMap(Map), AttributesMap(Attributes) {
   }
 
   /// @brief Verify that given metadata node is valid arg type metadata.
@@ -388,14 +513,18 @@ private:
   ErrorCreator *ErrCreator;
   DataHolder *Data;
   FunctionToMDNodeMap& FoundMap;
+  FunctionToKernelAttributesMap& AttributesMap;
 };
 
 struct VerifyMetadataKernels : public ModuleExecutor {
   /// @brief Constructor.
   /// @param EH error holder.
   /// @param D data holder.
-  VerifyMetadataKernels(ErrorCreator *EH, DataHolder *D) :
-    ErrCreator(EH), Data(D) {
+  /// @param Attributes map to store the attribute qualifiers of each
+  ///        kernel in.
+  VerifyMetadataKernels(ErrorCreator *EH, DataHolder *D,
+    FunctionToKernelAttributesMap& Attributes) :
+    ErrCreator(EH), Data(D), AttributesMap(Attributes) {
   }
 
   void execute(const Module *M);
@@ -403,6 +532,7 @@ struct VerifyMetadataKernels : public ModuleExecutor {
 private:
   ErrorCreator *ErrCreator;
   DataHolder *Data;
+  FunctionToKernelAttributesMap& AttributesMap;
 };
 
 struct VerifyMetadataVersions : public ModuleExecutor {
@@ -472,6 +602,150 @@ private:
   DataHolder *Data;
 };
 
+//
+// Performance lint executor classes.
+//
+
+struct LintUnderalignedVectorAccess : public InstructionExecutor {
+  /// @brief Constructor.
+  /// @param EH error holder.
+  /// @param D data holder.
+  LintUnderalignedVectorAccess(ErrorCreator *EH, DataHolder *D) :
+    ErrCreator(EH), Data(D) {
+  }
+
+  /// @brief Warn if given instruction loads or stores a vector with an
+  ///        alignment below the alignment of the vector type.
+  /// @param I instruction to check.
+  void execute(const Instruction *I);
+
+private:
+  ErrorCreator *ErrCreator;
+  DataHolder *Data;
+};
+
+struct LintLargePrivateAlloca : public InstructionExecutor {
+  /// @brief Constructor.
+  /// @param EH error holder.
+  /// @param D data holder.
+  LintLargePrivateAlloca(ErrorCreator *EH, DataHolder *D) :
+    ErrCreator(EH), Data(D) {
+  }
+
+  /// @brief Warn if given instruction allocates more private memory than
+  ///        g_perf_lint_private_alloca_size, or a variable amount of it.
+  /// @param I instruction to check.
+  void execute(const Instruction *I);
+
+private:
+  ErrorCreator *ErrCreator;
+  DataHolder *Data;
+};
+
+struct LintScalarizedGlobalVectorAccess : public InstructionExecutor {
+  /// @brief Constructor.
+  /// @param EH error holder.
+  LintScalarizedGlobalVectorAccess(ErrorCreator *EH) : ErrCreator(EH) {
+  }
+
+  /// @brief Warn if given instruction loads or stores a single element of
+  ///        a vector in the global address space.
+  /// @param I instruction to check.
+  void execute(const Instruction *I);
+
+private:
+  ErrorCreator *ErrCreator;
+};
+
+struct LintSmallMemcpy : public InstructionExecutor {
+  /// @brief Constructor.
+  /// @param EH error holder.
+  LintSmallMemcpy(ErrorCreator *EH) : ErrCreator(EH) {
+  }
+
+  /// @brief Warn if given instruction is a llvm.memcpy of a constant size
+  ///        up to g_perf_lint_small_memcpy_size.
+  /// @param I instruction to check.
+  void execute(const Instruction *I);
+
+private:
+  ErrorCreator *ErrCreator;
+};
+
+//
+// Resource collector executor classes.
+//
+
+struct CollectInstructionResources : public InstructionExecutor {
+  /// @brief Constructor.
+  /// @param RE resource estimator.
+  /// @param D data holder.
+  CollectInstructionResources(ResourceEstimator *RE, DataHolder *D) :
+    Estimator(RE), Data(D) {
+  }
+
+  /// @brief Record the private allocation, the call, or the uses of
+  ///        __local and __constant variables of given instruction.
+  /// @param I instruction to record.
+  void execute(const Instruction *I);
+
+private:
+  ResourceEstimator *Estimator;
+  DataHolder *Data;
+};
+
+struct CollectKernelArgResources : public FunctionExecutor {
+  /// @brief Constructor.
+  /// @param RE resource estimator.
+  CollectKernelArgResources(ResourceEstimator *RE) : Estimator(RE) {
+  }
+
+  /// @brief Record the __local and __constant pointer arguments of given
+  ///        kernel.
+  /// @param F function to record.
+  void execute(const Function *F);
+
+private:
+  ResourceEstimator *Estimator;
+};
+
+struct CollectGlobalResources : public GlobalVariableExecutor {
+  /// @brief Constructor.
+  /// @param RE resource estimator.
+  /// @param D data holder.
+  CollectGlobalResources(ResourceEstimator *RE, DataHolder *D) :
+    Estimator(RE), Data(D) {
+  }
+
+  /// @brief Record the size of given __local or __constant variable.
+  /// @param GV global variable to record.
+  void execute(const GlobalVariable *GV);
+
+private:
+  ResourceEstimator *Estimator;
+  DataHolder *Data;
+};
+
+//
+// Report executor classes.
+//
+
+struct CollectKernelCallers : public ModuleExecutor {
+  /// @brief Constructor.
+  /// @param Map map to store the kernels reaching each function in.
+  CollectKernelCallers(FunctionToKernelsMap& Map) : Callers(Map) {
+  }
+
+  /// @brief Record the kernels of given module that reach each defined
+  ///        function, so that per function counts can be reported per
+  ///        kernel.
+  /// @param M module to record.
+  void execute(const Module *M);
+
+private:
+  FunctionToKernelsMap& Callers;
+};
+
 } // End SPIR namespace
 
 #endif // __SPIR_ITERATORS_H__
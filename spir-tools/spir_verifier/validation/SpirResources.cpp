@@ -0,0 +1,214 @@
+//===------------------------ SpirResources.cpp --------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+
+#include "LLVMVersion.h"
+#include "SpirResources.h"
+#include "SpirTables.h"
+
+#if LLVM_VERSION==3200
+  #include "llvm/Module.h"
+  #include "llvm/Function.h"
+  #include "llvm/GlobalVariable.h"
+#else
+  #include "llvm/IR/Module.h"
+  #include "llvm/IR/Function.h"
+  #include "llvm/IR/GlobalVariable.h"
+#endif
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+
+namespace SPIR {
+
+void ResourceEstimator::addPointerArg(const Function *F, unsigned AddrSpace) {
+  if (AddrSpace == LOCAL_ADDR_SPACE)
+    LocalPointerArgs[F]++;
+  else if (AddrSpace == CONSTANT_ADDR_SPACE)
+    ConstantPointerArgs[F]++;
+}
+
+const ResourceEstimator::CallTreeTotals &
+ResourceEstimator::getCallTreeTotals(const Function *F) {
+  std::map<const Function*, CallTreeTotals>::iterator ti = Totals.find(F);
+  if (ti != Totals.end())
+    return ti->second;
+
+  // The entry stays in progress while the callees are visited, a callee
+  // that is still in progress closes a recursive chain of calls.
+  CallTreeTotals &T = Totals[F];
+  const FunctionResources &R = Functions[F];
+  uint64_t CalleeBytes = 0;
+  std::set<const Function*>::const_iterator ci = R.Callees.begin(),
+                                            ce = R.Callees.end();
+  for (; ci != ce; ci++) {
+    ti = Totals.find(*ci);
+    if (ti != Totals.end() && ti->second.InProgress) {
+      T.IsRecursive = true;
+      continue;
+    }
+    const CallTreeTotals &CT = getCallTreeTotals(*ci);
+    CalleeBytes = std::max(CalleeBytes, CT.PrivateBytes);
+    T.HasDynamicAlloca |= CT.HasDynamicAlloca;
+    T.Depth = std::max(T.Depth, CT.Depth + 1);
+    T.IsRecursive |= CT.IsRecursive;
+  }
+  T.PrivateBytes = R.PrivateBytes + CalleeBytes;
+  T.HasDynamicAlloca |= R.HasDynamicAlloca;
+  T.InProgress = false;
+  return T;
+}
+
+void ResourceEstimator::collectGlobals(const Function *F,
+                                       std::set<const Function*> &Visited,
+                                       std::set<const GlobalVariable*> &Globals) {
+  if (!Visited.insert(F).second)
+    return;
+  const FunctionResources &R = Functions[F];
+  Globals.insert(R.Globals.begin(), R.Globals.end());
+  std::set<const Function*>::const_iterator ci = R.Callees.begin(),
+                                            ce = R.Callees.end();
+  for (; ci != ce; ci++)
+    collectGlobals(*ci, Visited, Globals);
+}
+
+void ResourceEstimator::estimate(const Module &M,
+                                 const FunctionToKernelAttributesMap &Attributes) {
+  Kernels.clear();
+  Totals.clear();
+
+  Module::const_iterator fi = M.begin(), fe = M.end();
+  for (; fi != fe; fi++) {
+    const Function *F = &*fi;
+    if (F->isDeclaration() || F->getCallingConv() != CallingConv::SPIR_KERNEL)
+      continue;
+
+    KernelResources K;
+    K.Name = F->getName().str();
+
+    const CallTreeTotals &T = getCallTreeTotals(F);
+    K.PrivateBytes = T.PrivateBytes;
+    K.PrivateIsLowerBound = T.HasDynamicAlloca || T.IsRecursive;
+    K.CallDepth = T.Depth;
+    K.IsRecursive = T.IsRecursive;
+
+    // Variables used by the kernel or by any function it calls.
+    std::set<const Function*> Visited;
+    std::set<const GlobalVariable*> Globals;
+    collectGlobals(F, Visited, Globals);
+    std::set<const GlobalVariable*>::const_iterator gi = Globals.begin(),
+                                                    ge = Globals.end();
+    for (; gi != ge; gi++) {
+      std::map<const GlobalVariable*, uint64_t>::const_iterator si =
+        GlobalSizes.find(*gi);
+      if (si == GlobalSizes.end())
+        continue;
+      if ((*gi)->getType()->getAddressSpace() == LOCAL_ADDR_SPACE)
+        K.LocalBytes += si->second;
+      else
+        K.ConstantBytes += si->second;
+    }
+
+    std::map<const Function*, unsigned>::const_iterator ai;
+    ai = LocalPointerArgs.find(F);
+    if (ai != LocalPointerArgs.end())
+      K.LocalPointerArgs = ai->second;
+    ai = ConstantPointerArgs.find(F);
+    if (ai != ConstantPointerArgs.end())
+      K.ConstantPointerArgs = ai->second;
+
+    FunctionToKernelAttributesMap::const_iterator ki = Attributes.find(F);
+    if (ki != Attributes.end())
+      K.Attributes = ki->second;
+
+    Kernels.push_back(K);
+  }
+}
+
+void ResourceEstimator::print(raw_ostream &S) const {
+  S << "Kernel resources:\n";
+  for (unsigned i=0; i<Kernels.size(); i++) {
+    const KernelResources &K = Kernels[i];
+    S << "  kernel " << K.Name << ":\n";
+    S << "    private memory per work-item: " << K.PrivateBytes << " bytes"
+      << (K.PrivateIsLowerBound ? " or more" : "") << "\n";
+    S << "    local memory per work-group: " << K.LocalBytes << " bytes, "
+      << K.LocalPointerArgs << " __local pointer arguments\n";
+    S << "    constant memory: " << K.ConstantBytes << " bytes, "
+      << K.ConstantPointerArgs << " __constant pointer arguments\n";
+    S << "    call depth: " << K.CallDepth
+      << (K.IsRecursive ? " (recursive)" : "") << "\n";
+
+    const KernelAttributes &A = K.Attributes;
+    if (A.HasReqdWorkGroupSize)
+      S << "    reqd_work_group_size: " << A.ReqdWorkGroupSize[0] << ", "
+        << A.ReqdWorkGroupSize[1] << ", " << A.ReqdWorkGroupSize[2] << "\n";
+    if (A.HasWorkGroupSizeHint)
+      S << "    work_group_size_hint: " << A.WorkGroupSizeHint[0] << ", "
+        << A.WorkGroupSizeHint[1] << ", " << A.WorkGroupSizeHint[2] << "\n";
+    if (A.HasVecTypeHint)
+      S << "    vec_type_hint: " << A.VecTypeHint << "\n";
+  }
+}
+
+/// @brief Print a work-group size as a JSON array, or null when absent.
+static void printJSONSize(raw_ostream &S, bool Has, const unsigned Size[3]) {
+  if (!Has) {
+    S << "null";
+    return;
+  }
+  S << "[" << Size[0] << ", " << Size[1] << ", " << Size[2] << "]";
+}
+
+/// @brief Print given string as a JSON string.
+static void printJSONString(raw_ostream &S, const std::string &Str) {
+  S << '"';
+  for (unsigned i=0; i<Str.size(); i++) {
+    unsigned char C = Str[i];
+    if (C == '"' || C == '\\')
+      S << '\\' << C;
+    else if (C < 0x20)
+      S << format("\\u%04x", C);
+    else
+      S << C;
+  }
+  S << '"';
+}
+
+void ResourceEstimator::printJSON(raw_ostream &S) const {
+  S << "{\n  \"kernels\": [";
+  for (unsigned i=0; i<Kernels.size(); i++) {
+    const KernelResources &K = Kernels[i];
+    S << (i ? ",\n" : "\n") << "    {\"name\": ";
+    printJSONString(S, K.Name);
+    S << ", \"private_bytes\": " << K.PrivateBytes
+      << ", \"private_is_lower_bound\": "
+      << (K.PrivateIsLowerBound ? "true" : "false")
+      << ", \"local_bytes\": " << K.LocalBytes
+      << ", \"local_pointer_args\": " << K.LocalPointerArgs
+      << ", \"constant_bytes\": " << K.ConstantBytes
+      << ", \"constant_pointer_args\": " << K.ConstantPointerArgs
+      << ", \"call_depth\": " << K.CallDepth
+      << ", \"recursive\": " << (K.IsRecursive ? "true" : "false");
+    const KernelAttributes &A = K.Attributes;
+    S << ", \"reqd_work_group_size\": ";
+    printJSONSize(S, A.HasReqdWorkGroupSize, A.ReqdWorkGroupSize);
+    S << ", \"work_group_size_hint\": ";
+    printJSONSize(S, A.HasWorkGroupSizeHint, A.WorkGroupSizeHint);
+    S << ", \"vec_type_hint\": ";
+    if (A.HasVecTypeHint)
+      printJSONString(S, A.VecTypeHint);
+    else
+      S << "null";
+    S << "}";
+  }
+  S << (Kernels.empty() ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+} // End SPIR namespace
@@ -0,0 +1,182 @@
+//===------------------------- SpirResources.h ---------------------------===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+
+#ifndef __SPIR_RESOURCES_H__
+#define __SPIR_RESOURCES_H__
+
+#include "llvm/Support/DataTypes.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class Function;
+class GlobalVariable;
+class Module;
+class raw_ostream;
+}
+
+using namespace llvm;
+
+namespace SPIR {
+
+/// @brief Resources used by the body of a function, not counting the
+///        functions it calls.
+struct FunctionResources {
+  FunctionResources() : PrivateBytes(0), HasDynamicAlloca(false) {
+  }
+
+  /// @brief Bytes allocated in the private address space.
+  uint64_t PrivateBytes;
+  /// @brief Indicates an allocation of a size only known at run time.
+  bool HasDynamicAlloca;
+  /// @brief Defined functions called.
+  std::set<const Function*> Callees;
+  /// @brief Program scope variables in the local and constant address
+  ///        spaces used.
+  std::set<const GlobalVariable*> Globals;
+};
+
+/// @brief Attribute qualifiers of a kernel, parsed from its valid
+///        reqd_work_group_size, work_group_size_hint and vec_type_hint
+///        metadata.
+struct KernelAttributes {
+  KernelAttributes() :
+    HasReqdWorkGroupSize(false), HasWorkGroupSizeHint(false),
+    HasVecTypeHint(false) {
+    for (unsigned i=0; i<3; i++) {
+      ReqdWorkGroupSize[i] = 0;
+      WorkGroupSizeHint[i] = 0;
+    }
+  }
+
+  bool HasReqdWorkGroupSize;
+  /// @brief Required work-group size in each dimension.
+  unsigned ReqdWorkGroupSize[3];
+  bool HasWorkGroupSizeHint;
+  /// @brief Work-group size hint in each dimension.
+  unsigned WorkGroupSizeHint[3];
+  bool HasVecTypeHint;
+  /// @brief OpenCL C name of the vec_type_hint type, such as "float4".
+  std::string VecTypeHint;
+};
+
+typedef std::map<const Function*, KernelAttributes> FunctionToKernelAttributesMap;
+
+/// @brief Estimated resources of a kernel, including the functions it
+///        calls.
+struct KernelResources {
+  KernelResources() :
+    PrivateBytes(0), PrivateIsLowerBound(false),
+    LocalBytes(0), LocalPointerArgs(0),
+    ConstantBytes(0), ConstantPointerArgs(0),
+    CallDepth(0), IsRecursive(false) {
+  }
+
+  std::string Name;
+  /// @brief Private memory per work-item: the allocations of the kernel
+  ///        and of its deepest chain of calls.
+  uint64_t PrivateBytes;
+  /// @brief Indicates dynamic allocations or recursion, PrivateBytes is
+  ///        then a lower bound.
+  bool PrivateIsLowerBound;
+  /// @brief Local memory per work-group used by __local variables.
+  uint64_t LocalBytes;
+  /// @brief Number of __local pointer arguments, sized at enqueue time.
+  unsigned LocalPointerArgs;
+  /// @brief Constant memory used by program scope __constant variables.
+  uint64_t ConstantBytes;
+  /// @brief Number of __constant pointer arguments, sized at enqueue time.
+  unsigned ConstantPointerArgs;
+  /// @brief Length of the longest chain of calls to defined functions.
+  unsigned CallDepth;
+  /// @brief Indicates that the kernel reaches a recursive call.
+  bool IsRecursive;
+  /// @brief Attribute qualifiers of the kernel.
+  KernelAttributes Attributes;
+};
+
+/// @brief Collects the resources used by each function while the module
+///        is iterated over, and estimates the resources of each kernel.
+class ResourceEstimator {
+public:
+  /// @brief Get the resources used by given function.
+  /// @param F function.
+  /// @returns resources of F, to be updated by the executors.
+  FunctionResources &getFunction(const Function *F) {
+    return Functions[F];
+  }
+
+  /// @brief Record the size of a program scope variable.
+  /// @param GV variable in the local or constant address space.
+  /// @param Bytes allocation size of its type.
+  void setGlobalSize(const GlobalVariable *GV, uint64_t Bytes) {
+    GlobalSizes[GV] = Bytes;
+  }
+
+  /// @brief Record a pointer argument of a kernel.
+  /// @param F kernel.
+  /// @param AddrSpace address space of the argument.
+  void addPointerArg(const Function *F, unsigned AddrSpace);
+
+  /// @brief Estimate the resources of the kernels of M from the collected
+  ///        data. Called once the module was iterated over.
+  /// @param M module.
+  /// @param Attributes attribute qualifiers of the kernels of M.
+  void estimate(const Module &M, const FunctionToKernelAttributesMap &Attributes);
+
+  /// @brief Get the estimated resources of each kernel, in module order.
+  const std::vector<KernelResources> &getKernels() const {
+    return Kernels;
+  }
+
+  /// @brief Print the estimated resources of each kernel as text.
+  /// @param S output stream.
+  void print(raw_ostream &S) const;
+
+  /// @brief Print the estimated resources of each kernel as a JSON object.
+  /// @param S output stream.
+  void printJSON(raw_ostream &S) const;
+
+private:
+  /// @brief Private memory and call depth of a function, including the
+  ///        functions it calls.
+  struct CallTreeTotals {
+    CallTreeTotals() :
+      PrivateBytes(0), HasDynamicAlloca(false), Depth(0),
+      IsRecursive(false), InProgress(true) {
+    }
+
+    uint64_t PrivateBytes;
+    bool HasDynamicAlloca;
+    unsigned Depth;
+    bool IsRecursive;
+    bool InProgress;
+  };
+
+  /// @brief Compute the totals of given function and of its callees.
+  const CallTreeTotals &getCallTreeTotals(const Function *F);
+
+  /// @brief Add the variables used by given function and by its callees.
+  void collectGlobals(const Function *F, std::set<const Function*> &Visited,
+                      std::set<const GlobalVariable*> &Globals);
+
+  std::map<const Function*, FunctionResources> Functions;
+  std::map<const GlobalVariable*, uint64_t> GlobalSizes;
+  std::map<const Function*, unsigned> LocalPointerArgs;
+  std::map<const Function*, unsigned> ConstantPointerArgs;
+  std::map<const Function*, CallTreeTotals> Totals;
+  std::vector<KernelResources> Kernels;
+};
+
+} // End SPIR namespace
+
+#endif // __SPIR_RESOURCES_H__
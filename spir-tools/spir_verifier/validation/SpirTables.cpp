@@ -206,6 +206,28 @@ const char *g_valid_sync_bi[] = {
 };
 DCL_ARRAY_LENGTH(g_valid_sync_bi);
 
+// Mangled names of the built-in functions declared in opencl_spir.h.
+// SpirBuiltins.inc is generated at build time by spir-builtins-gen.
+const char *g_builtin_prefix = "_Z";
+
+const char *g_valid_builtins[] = {
+#define SPIR_BUILTIN(Name) Name,
+#include "SpirBuiltins.inc"
+};
+DCL_ARRAY_LENGTH(g_valid_builtins);
+
+const char *g_valid_builtins32[] = {
+#define SPIR_BUILTIN32(Name) Name,
+#include "SpirBuiltins.inc"
+};
+DCL_ARRAY_LENGTH(g_valid_builtins32);
+
+const char *g_valid_builtins64[] = {
+#define SPIR_BUILTIN64(Name) Name,
+#include "SpirBuiltins.inc"
+};
+DCL_ARRAY_LENGTH(g_valid_builtins64);
+
 const char *g_valid_address_space[] = {
   "private",
   "global",
@@ -259,6 +281,10 @@ const char *g_valid_kernel_arg_info[] = {
 };
 DCL_ARRAY_LENGTH(g_valid_kernel_arg_info);
 
+const char *REQD_WORK_GROUP_SIZE = "reqd_work_group_size";
+const char *WORK_GROUP_SIZE_HINT = "work_group_size_hint";
+const char *VEC_TYPE_HINT = "vec_type_hint";
+
 const char *g_valid_version_names[] = {
   "opencl.ocl.version",
   "opencl.spir.version"
@@ -275,6 +301,11 @@ const char *g_valid_ocl_versions[][2] = {
 };
 DCL_ARRAY_LENGTH(g_valid_ocl_versions)/2;
 
+///
+/// Performance lint thresholds (in bytes)
+///
+const unsigned g_perf_lint_private_alloca_size = 512;
+const unsigned g_perf_lint_small_memcpy_size = 64;
 
 ///
 /// get error info message functions
@@ -467,6 +498,29 @@ std::string getValidKernelArgInfoMsg() {
   return Msg;
 }
 
+std::string getValidKernelAttributeMsg() {
+  std::string Msg;
+  Msg += "Valid kernel attribute qualifiers metadata in " + STR_SPIR +
+         " are:\n";
+  Msg += STR_IND1 + "!{metadata !\"" + REQD_WORK_GROUP_SIZE +
+         "\", i32 <X>, i32 <Y>, i32 <Z>}\n";
+  Msg += STR_IND1 + "!{metadata !\"" + WORK_GROUP_SIZE_HINT +
+         "\", i32 <X>, i32 <Y>, i32 <Z>}\n";
+  Msg += STR_IND1 + "!{metadata !\"" + VEC_TYPE_HINT +
+         "\", <type> undef, i32 <is signed>}\n";
+  Msg += STR_IND2 + "<X>, <Y> and <Z> are positive and their product "
+         "fits in 32 bits.\n";
+  Msg += STR_IND2 + "<type> is char, short, int, long, half, float or "
+         "double, or a vector of 2,\n";
+  Msg += STR_IND2 + "3, 4, 8 or 16 of them. <is signed> is 0 or 1.\n";
+  Msg += "\n" + STR_IND1 + STR_NOTE +
+         "Each may appear once in the metadata of a kernel, and only in "
+         "the metadata\n";
+  Msg += STR_IND1 + "of a function with the spir_kernel calling "
+         "convention.\n";
+  return Msg;
+}
+
 std::string getValidVersionMsg() {
   std::string Msg;
   Msg += "Module in " + STR_SPIR + " must have these metadata versions:\n";
@@ -502,6 +556,42 @@ std::string getValidMemFenceMsg() {
   return Msg;
 }
 
+std::string getValidBuiltinMsg() {
+  std::string Msg;
+  Msg += "Mangled functions that are only declared in the module must be "
+         "OpenCL C built-in functions.\n";
+  Msg += STR_IND1 + "Valid built-in functions are the ones declared in "
+         "opencl_spir.h, mangled\n";
+  Msg += STR_IND1 + "according to the " + STR_SPIR +
+         " name mangling scheme.\n";
+  Msg += "\n" + STR_IND1 + STR_NOTE +
+         "size_t, ptrdiff_t, intptr_t and uintptr_t arguments are mangled as "
+         "32-bit\n";
+  Msg += STR_IND1 + "integers in " + STR_SPIR + "32 and as 64-bit integers in " +
+         STR_SPIR + "64.\n";
+  return Msg;
+}
+
+std::string getValidAlignmentMsg() {
+  std::string Msg;
+  Msg += "Loads, stores and allocations must be aligned at least to the "
+         "alignment of their type\n";
+  Msg += STR_IND1 + "in the " + STR_SPIR + " data layout, which follows the "
+         "OpenCL C alignment rules:\n";
+  Msg += STR_IND2 + "Scalar types are aligned to their size.\n";
+  Msg += STR_IND2 + "Vector types are aligned to their size, 3-component "
+         "vectors as 4-component vectors.\n";
+  Msg += STR_IND2 + "Pointers are aligned to 4 bytes in " + STR_SPIR +
+         "32 and to 8 bytes in " + STR_SPIR + "64.\n";
+  Msg += STR_IND2 + "Arrays and structures are aligned to the largest "
+         "alignment of their elements.\n";
+  Msg += "\n" + STR_IND1 + STR_NOTE +
+         "An alignment of 0 stands for the alignment of the type. Members of "
+         "packed\n";
+  Msg += STR_IND1 + "structures may be aligned below it.\n";
+  return Msg;
+}
+
 std::string getMapOpenCLToLLVMMsg() {
   std::string Msg;
   Msg += "OpenCL C mapping to SPIR\n";
@@ -93,6 +93,17 @@ EXTREN_DCL_ARRAY_LENGTH(g_ignored_instrinsic);
 extern const char *g_valid_sync_bi[];
 EXTREN_DCL_ARRAY_LENGTH(g_valid_sync_bi);
 
+extern const char *g_builtin_prefix;
+
+extern const char *g_valid_builtins[];
+EXTREN_DCL_ARRAY_LENGTH(g_valid_builtins);
+
+extern const char *g_valid_builtins32[];
+EXTREN_DCL_ARRAY_LENGTH(g_valid_builtins32);
+
+extern const char *g_valid_builtins64[];
+EXTREN_DCL_ARRAY_LENGTH(g_valid_builtins64);
+
 extern const char *g_valid_address_space[];
 EXTREN_DCL_ARRAY_LENGTH(g_valid_address_space);
 
@@ -117,6 +128,10 @@ extern const char *KERNEL_ARG_BASE_TY;
 extern const char *g_valid_kernel_arg_info[];
 EXTREN_DCL_ARRAY_LENGTH(g_valid_kernel_arg_info);
 
+extern const char *REQD_WORK_GROUP_SIZE;
+extern const char *WORK_GROUP_SIZE_HINT;
+extern const char *VEC_TYPE_HINT;
+
 extern const char *g_valid_version_names[];
 EXTREN_DCL_ARRAY_LENGTH(g_valid_version_names);
 
@@ -126,6 +141,12 @@ EXTREN_DCL_ARRAY_LENGTH(g_valid_spir_versions);
 extern const char *g_valid_ocl_versions[][2];
 EXTREN_DCL_ARRAY_LENGTH(g_valid_ocl_versions);
 
+///
+/// Performance lint thresholds (in bytes)
+///
+extern const unsigned g_perf_lint_private_alloca_size;
+extern const unsigned g_perf_lint_small_memcpy_size;
+
 
 
 
@@ -161,10 +182,16 @@ extern std::string getValidKernelArgInfoMsg();
 
 extern std::string getValidKernelArgAddressSpaceMsg();
 
+extern std::string getValidKernelAttributeMsg();
+
 extern std::string getValidVersionMsg();
 
 extern std::string getValidMemFenceMsg();
 
+extern std::string getValidBuiltinMsg();
+
+extern std::string getValidAlignmentMsg();
+
 extern std::string getMapOpenCLToLLVMMsg();
 
 extern std::string getValidNamedMetadataMsg();
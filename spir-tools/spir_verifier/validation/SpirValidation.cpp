@@ -33,7 +33,10 @@ namespace SPIR {
 
 char SpirValidation::ID = 0;
 
-SpirValidation::SpirValidation() : ModulePass(ID) {
+SpirValidation::SpirValidation(bool EnablePerfLint, bool EnableResources,
+                               bool EnableAlignment) :
+  ModulePass(ID), PerfLint(EnablePerfLint),
+  EstimateResources(EnableResources), CheckAlignment(EnableAlignment) {
 }
 
 SpirValidation::~SpirValidation() {
@@ -46,6 +49,12 @@ const char* SpirValidation::getPassName() const {
 bool SpirValidation::runOnModule(Module& M) {
   // Holder for initialized data in the module
   DataHolder Data;
+  // Alignment of the types used in the module
+  TypeAlignmentCache Alignments(&Data);
+  AlignmentCounts.clear();
+  KernelCallers.clear();
+  KernelAttrs.clear();
+  Resources = ResourceEstimator();
 
   // Initialize instruction verifiers.
   InstructionExecutorList iel;
@@ -53,11 +62,38 @@ bool SpirValidation::runOnModule(Module& M) {
   VerifyBitcast vb(&ErrHolder);
   iel.push_back(&vb);
   // Call instruction verifier.
-  VerifyCall vc(&ErrHolder);
+  VerifyCall vc(&ErrHolder, &Data);
   iel.push_back(&vc);
   // Instruction type verifier.
   VerifyInstructionType vit(&ErrHolder, &Data);
   iel.push_back(&vit);
+  // Memory access alignment verifier, only run when asked for, as valid
+  // modules may access memory below the alignment of the type accessed.
+  VerifyMemoryAlignment vma(&ErrHolder, &Alignments, AlignmentCounts);
+  if (CheckAlignment)
+    iel.push_back(&vma);
+
+  // Initialize performance lint executors, only run when asked for.
+  // Vector access alignment lint.
+  LintUnderalignedVectorAccess luva(&ErrHolder, &Data);
+  // Private memory allocation size lint.
+  LintLargePrivateAlloca llpa(&ErrHolder, &Data);
+  // Scalar access to global vectors lint.
+  LintScalarizedGlobalVectorAccess lsgva(&ErrHolder);
+  // Small memcpy lint.
+  LintSmallMemcpy lsm(&ErrHolder);
+  if (PerfLint) {
+    iel.push_back(&luva);
+    iel.push_back(&llpa);
+    iel.push_back(&lsgva);
+    iel.push_back(&lsm);
+  }
+
+  // Initialize resource collectors, only run when asked for.
+  // Private allocations, calls and variable uses collector.
+  CollectInstructionResources cir(&Resources, &Data);
+  if (EstimateResources)
+    iel.push_back(&cir);
 
   // Initialize function verifiers.
   FunctionExecutorList fel;
@@ -67,12 +103,20 @@ bool SpirValidation::runOnModule(Module& M) {
   // Kernel prototype verifier
   VerifyKernelPrototype vkp(&ErrHolder, &Data);
   fel.push_back(&vkp);
+  // Kernel pointer arguments collector.
+  CollectKernelArgResources ckar(&Resources);
+  if (EstimateResources)
+    fel.push_back(&ckar);
 
   // Initialize global variable verifiers
   GlobalVariableExecutorList gel;
   // Global variable verifier
   VerifyGlobalVariable vgv(&ErrHolder, &Data);
   gel.push_back(&vgv);
+  // __local and __constant variable sizes collector.
+  CollectGlobalResources cgr(&Resources, &Data);
+  if (EstimateResources)
+    gel.push_back(&cgr);
 
   // Initialize module verifiers.
   ModuleExecutorList mel;
@@ -80,7 +124,7 @@ bool SpirValidation::runOnModule(Module& M) {
   VerifyTripleAndDataLayout vtdl(&ErrHolder, &Data);
   mel.push_back(&vtdl);
   // Module metadata kernels verifier.
-  VerifyMetadataKernels vkmd(&ErrHolder, &Data);
+  VerifyMetadataKernels vkmd(&ErrHolder, &Data, KernelAttrs);
   mel.push_back(&vkmd);
   // Module OCL version verifier.
   VerifyMetadataVersions voclv(
@@ -99,6 +143,10 @@ bool SpirValidation::runOnModule(Module& M) {
   // Module metadata compiler options verifier.
   VerifyMetadataCompilerOptions vmdco(&ErrHolder, &Data);
   mel.push_back(&vmdco);
+  // Kernel callers collector, for the per kernel summaries.
+  CollectKernelCallers ckc(KernelCallers);
+  if (CheckAlignment || PerfLint)
+    mel.push_back(&ckc);
 
   // Initialize basic block iterator.
   BasicBlockIterator BBI(iel);
@@ -115,6 +163,10 @@ bool SpirValidation::runOnModule(Module& M) {
   // Run validation.
   MI.execute(M);
 
+  // Estimate the resources of the kernels from the collected data.
+  if (EstimateResources)
+    Resources.estimate(M, KernelAttrs);
+
   return false;
 }
 
@@ -11,6 +11,8 @@
 #define __SPIR_VALIDATION_H__
 
 #include "SpirErrors.h"
+#include "SpirIterators.h"
+#include "SpirResources.h"
 #include "llvm/Pass.h"
 
 namespace SPIR {
@@ -24,7 +26,14 @@ public:
   static char ID;
 
   /// @brief Constructor.
-  SpirValidation();
+  /// @param EnablePerfLint also report performance warnings when set to true.
+  /// @param EnableResources also estimate the resources of each kernel
+  ///        when set to true.
+  /// @param EnableAlignment also report loads, stores and allocations
+  ///        aligned below their type as errors when set to true.
+  explicit SpirValidation(bool EnablePerfLint = false,
+                          bool EnableResources = false,
+                          bool EnableAlignment = false);
 
   /// @brief Distructor.
   virtual ~SpirValidation();
@@ -43,10 +52,60 @@ public:
     return &ErrHolder;
   }
 
+  /// @brief returns the number of loads, stores and allocations checked
+  ///        for alignment in each function, and how many were misaligned,
+  ///        when enabled.
+  /// @returns alignment counts of the last module validated.
+  const FunctionToAlignmentCountMap &getAlignmentCounts() const {
+    return AlignmentCounts;
+  }
+
+  /// @brief returns the kernels reaching each defined function, when
+  ///        the alignment checks or the performance lint are enabled.
+  /// @returns kernel callers of the last module validated.
+  const FunctionToKernelsMap &getKernelCallers() const {
+    return KernelCallers;
+  }
+
+  /// @brief returns the reqd_work_group_size, work_group_size_hint and
+  ///        vec_type_hint attributes of each kernel, as far as valid.
+  /// @returns kernel attributes of the last module validated.
+  const FunctionToKernelAttributesMap &getKernelAttributes() const {
+    return KernelAttrs;
+  }
+
+  /// @brief returns the resources estimated for each kernel, when
+  ///        enabled.
+  /// @returns resource estimator of the last module validated.
+  const ResourceEstimator &getResources() const {
+    return Resources;
+  }
+
 private:
 
   /// @brief Holder for errors found in the module
   ErrorHolder ErrHolder;
+
+  /// @brief Memory accesses checked for alignment in each function
+  FunctionToAlignmentCountMap AlignmentCounts;
+
+  /// @brief Kernels reaching each function
+  FunctionToKernelsMap KernelCallers;
+
+  /// @brief Attribute qualifiers of each kernel
+  FunctionToKernelAttributesMap KernelAttrs;
+
+  /// @brief Resources used by the functions of the module
+  ResourceEstimator Resources;
+
+  /// @brief Indicates whether to run the performance lint executors
+  bool PerfLint;
+
+  /// @brief Indicates whether to run the resource collector executors
+  bool EstimateResources;
+
+  /// @brief Indicates whether to run the memory alignment verifier
+  bool CheckAlignment;
 };
 
 } // End SPIR namespace
@@ -0,0 +1,35 @@
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir64-unknown-unknown"
+
+; RUN: llvm-as -o %t.bc %s
+; RUN: not spir_verifier -LIT-test-mode %t.bc 2>%t.out
+; RUN: FileCheck %s <%t.out
+
+; The tool shall report calls to mangled declarations that are not
+; OpenCL C built-ins, and accept the valid ones.
+; CHECK-NOT: _Z3absi
+; CHECK-NOT: _Z6vload4mPKU3AS1f
+; CHECK: ERR_UNKNOWN_BUILTIN
+; CHECK-NEXT: call spir_func <3 x float> @_Z5fractDv3_fPU3AS1S_
+; The tool shall report built-ins mangled for the wrong size_t
+; (size_t is ulong in SPIR64)
+; CHECK: ERR_UNKNOWN_BUILTIN
+; CHECK-NEXT: call spir_func <4 x float> @_Z6vload4jPKU3AS1f
+; CHECK-NOT: ERR_UNKNOWN_BUILTIN
+
+define spir_kernel void @builtins(<3 x float> addrspace(1)* %out, i32 addrspace(1)* %iout, float addrspace(1)* %in) nounwind {
+  %val = load i32 addrspace(1)* %iout, align 4
+  %abs = call spir_func i32 @_Z3absi(i32 %val) nounwind
+  store i32 %abs, i32 addrspace(1)* %iout, align 4
+  %v = load <3 x float> addrspace(1)* %out, align 16
+  %fract = call spir_func <3 x float> @_Z5fractDv3_fPU3AS1S_(<3 x float> %v, <3 x float> addrspace(1)* %out) nounwind
+  store <3 x float> %fract, <3 x float> addrspace(1)* %out, align 16
+  %ld64 = call spir_func <4 x float> @_Z6vload4mPKU3AS1f(i64 0, float addrspace(1)* %in) nounwind
+  %ld32 = call spir_func <4 x float> @_Z6vload4jPKU3AS1f(i32 0, float addrspace(1)* %in) nounwind
+  ret void
+}
+
+declare spir_func i32 @_Z3absi(i32) nounwind readnone
+declare spir_func <3 x float> @_Z5fractDv3_fPU3AS1S_(<3 x float>, <3 x float> addrspace(1)*) nounwind
+declare spir_func <4 x float> @_Z6vload4mPKU3AS1f(i64, float addrspace(1)*) nounwind readonly
+declare spir_func <4 x float> @_Z6vload4jPKU3AS1f(i32, float addrspace(1)*) nounwind readonly
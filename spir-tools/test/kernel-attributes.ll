@@ -0,0 +1,83 @@
+target datalayout = "e-p:32:32:32-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir-unknown-unknown"
+
+; RUN: llvm-as -o %t.bc %s
+; RUN: not spir_verifier -LIT-test-mode -resource-report=%t.txt %t.bc 2>%t.out
+; RUN: FileCheck %s <%t.out
+; RUN: FileCheck -check-prefix=REPORT %s <%t.txt
+; RUN: not spir_verifier -resource-report=%t.json -resource-report-format=json %t.bc
+; RUN: FileCheck -check-prefix=JSON %s <%t.json
+
+; The tool shall validate the reqd_work_group_size, work_group_size_hint and
+; vec_type_hint metadata of kernels, and report the valid ones per kernel.
+; CHECK-NOT: i32 64, i32 1, i32 1}
+; CHECK-NOT: <4 x float> undef
+; CHECK: ERR_INVALID_METADATA_KERNEL_ATTRIBUTE
+; CHECK-NEXT: i32 0, i32 1, i32 1}
+; CHECK: ERR_INVALID_METADATA_KERNEL_ATTRIBUTE
+; CHECK-NEXT: i32 16, i32 16}
+; CHECK: ERR_INVALID_METADATA_KERNEL_ATTRIBUTE
+; CHECK-NEXT: <5 x i32> undef
+; CHECK: ERR_INVALID_METADATA_KERNEL_ATTRIBUTE
+; CHECK-NEXT: i32 65536, i32 65536, i32 1}
+; Each attribute may appear once per kernel
+; CHECK: ERR_INVALID_METADATA_KERNEL_ATTRIBUTE
+; CHECK-NEXT: <2 x i1> undef
+; The attributes may not describe a function that is not a kernel
+; CHECK: ERR_INVALID_METADATA_KERNEL_ATTRIBUTE
+; CHECK-NEXT: <8 x i16> undef
+
+; REPORT: kernel good:
+; REPORT: call depth: 0
+; REPORT-NEXT: reqd_work_group_size: 64, 1, 1
+; REPORT-NEXT: work_group_size_hint: 16, 16, 1
+; REPORT-NEXT: vec_type_hint: float4
+; REPORT-NEXT: kernel bad:
+; REPORT: call depth: 0
+; REPORT-NEXT: kernel big:
+; REPORT: call depth: 0
+; REPORT-NEXT: vec_type_hint: uint
+; REPORT-NOT: vec_type_hint
+
+; JSON: {"name": "good", {{.*}}, "reqd_work_group_size": [64, 1, 1], "work_group_size_hint": [16, 16, 1], "vec_type_hint": "float4"},
+; JSON-NEXT: {"name": "bad", {{.*}}, "reqd_work_group_size": null, "work_group_size_hint": null, "vec_type_hint": null},
+; JSON-NEXT: {"name": "big", {{.*}}, "reqd_work_group_size": null, "work_group_size_hint": null, "vec_type_hint": "uint"}
+
+define spir_kernel void @good() nounwind {
+  ret void
+}
+
+define spir_kernel void @bad() nounwind {
+  ret void
+}
+
+define spir_kernel void @big() nounwind {
+  ret void
+}
+
+define spir_func void @helper() nounwind {
+  ret void
+}
+
+!opencl.kernels = !{!0, !10, !20, !30}
+
+!0 = metadata !{void ()* @good, metadata !1, metadata !2, metadata !3, metadata !4, metadata !5, metadata !6}
+!1 = metadata !{metadata !"kernel_arg_addr_space"}
+!2 = metadata !{metadata !"kernel_arg_type"}
+!3 = metadata !{metadata !"kernel_arg_base_type"}
+!4 = metadata !{metadata !"reqd_work_group_size", i32 64, i32 1, i32 1}
+!5 = metadata !{metadata !"work_group_size_hint", i32 16, i32 16, i32 1}
+!6 = metadata !{metadata !"vec_type_hint", <4 x float> undef, i32 0}
+
+!10 = metadata !{void ()* @bad, metadata !1, metadata !2, metadata !3, metadata !11, metadata !12, metadata !13}
+!11 = metadata !{metadata !"reqd_work_group_size", i32 0, i32 1, i32 1}
+!12 = metadata !{metadata !"work_group_size_hint", i32 16, i32 16}
+!13 = metadata !{metadata !"vec_type_hint", <5 x i32> undef, i32 1}
+
+!20 = metadata !{void ()* @big, metadata !1, metadata !2, metadata !3, metadata !21, metadata !22, metadata !23}
+!21 = metadata !{metadata !"reqd_work_group_size", i32 65536, i32 65536, i32 1}
+!22 = metadata !{metadata !"vec_type_hint", i32 undef, i32 0}
+!23 = metadata !{metadata !"vec_type_hint", <2 x i1> undef, i32 0}
+
+!30 = metadata !{void ()* @helper, metadata !1, metadata !2, metadata !3, metadata !31}
+!31 = metadata !{metadata !"vec_type_hint", <8 x i16> undef, i32 1}
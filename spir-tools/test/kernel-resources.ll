@@ -0,0 +1,64 @@
+target datalayout = "e-p:32:32:32-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir-unknown-unknown"
+
+@res.tile = internal addrspace(3) global [64 x float] zeroinitializer, align 4
+@table = addrspace(2) constant [4 x i32] [i32 1, i32 2, i32 3, i32 4], align 4
+
+; RUN: llvm-as -o %t.bc %s
+; RUN: not spir_verifier -resource-report=%t.txt %t.bc
+; RUN: FileCheck %s <%t.txt
+; RUN: not spir_verifier -resource-report=%t.json -resource-report-format=json %t.bc
+; RUN: FileCheck -check-prefix=JSON %s <%t.json
+
+; The tool shall estimate the private, local and constant memory and the
+; call depth of each kernel, including the functions it calls.
+; CHECK: Kernel resources:
+; CHECK-NEXT: kernel res:
+; CHECK-NEXT: private memory per work-item: 96 bytes
+; CHECK-NEXT: local memory per work-group: 256 bytes, 1 __local pointer arguments
+; CHECK-NEXT: constant memory: 16 bytes, 1 __constant pointer arguments
+; CHECK-NEXT: call depth: 2
+; CHECK-NEXT: kernel rec:
+; CHECK-NEXT: private memory per work-item: 4 bytes or more
+; CHECK-NEXT: local memory per work-group: 0 bytes, 0 __local pointer arguments
+; CHECK-NEXT: constant memory: 0 bytes, 0 __constant pointer arguments
+; CHECK-NEXT: call depth: 1 (recursive)
+
+; JSON: "kernels": [
+; JSON-NEXT: {"name": "res", "private_bytes": 96, "private_is_lower_bound": false, "local_bytes": 256, "local_pointer_args": 1, "constant_bytes": 16, "constant_pointer_args": 1, "call_depth": 2, "recursive": false, "reqd_work_group_size": null, "work_group_size_hint": null, "vec_type_hint": null},
+; JSON-NEXT: {"name": "rec", "private_bytes": 4, "private_is_lower_bound": true, "local_bytes": 0, "local_pointer_args": 0, "constant_bytes": 0, "constant_pointer_args": 0, "call_depth": 1, "recursive": true, "reqd_work_group_size": null, "work_group_size_hint": null, "vec_type_hint": null}
+; JSON-NEXT: ]
+
+define spir_kernel void @res(float addrspace(3)* %scratch, i32 addrspace(2)* %c, i32 %i) nounwind {
+  %buf = alloca [16 x float], align 4
+  call spir_func void @outer(i32 %i)
+  call spir_func void @leaf(i32 %i)
+  %l = getelementptr [64 x float] addrspace(3)* @res.tile, i32 0, i32 %i
+  store float 0.0, float addrspace(3)* %l, align 4
+  ret void
+}
+
+define spir_func void @outer(i32 %i) nounwind {
+  %tmp = alloca [4 x float], align 4
+  call spir_func void @leaf(i32 %i)
+  ret void
+}
+
+define spir_func void @leaf(i32 %i) nounwind {
+  %t = alloca [4 x float], align 4
+  %p = getelementptr [4 x i32] addrspace(2)* @table, i32 0, i32 %i
+  %v = load i32 addrspace(2)* %p, align 4
+  ret void
+}
+
+define spir_kernel void @rec(i32 %n) nounwind {
+  call spir_func void @walk(i32 %n)
+  ret void
+}
+
+define spir_func void @walk(i32 %n) nounwind {
+  %slot = alloca i32, align 4
+  %m = sub i32 %n, 1
+  call spir_func void @walk(i32 %m)
+  ret void
+}
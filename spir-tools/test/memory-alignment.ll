@@ -0,0 +1,69 @@
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir64-unknown-unknown"
+
+%struct.packed = type <{ i8, i32 }>
+
+; RUN: llvm-as -o %t.bc %s
+; RUN: not spir_verifier -check-alignment -LIT-test-mode %t.bc 2>%t.out
+; RUN: FileCheck %s <%t.out
+; RUN: not spir_verifier -alignment-summary -LIT-test-mode %t.bc >%t.sum 2>%t.out
+; RUN: FileCheck %s <%t.out
+; RUN: FileCheck -check-prefix=SUMMARY %s <%t.sum
+; RUN: not spir_verifier -LIT-test-mode %t.bc 2>%t.default
+; RUN: FileCheck -check-prefix=DEFAULT %s <%t.default
+
+; With -check-alignment, the tool shall report loads, stores and
+; allocations aligned below the alignment of their type in the SPIR data
+; layout. Valid modules may do so, the check is off by default.
+; DEFAULT-NOT: ERR_MISALIGNED
+; CHECK: ERR_MISALIGNED_ALLOCA
+; CHECK-NEXT: Type: <4 x i32>
+; CHECK-NEXT: %vec = alloca <4 x i32>, align 4
+; CHECK-NOT: %slot = alloca
+; CHECK: ERR_MISALIGNED_MEMORY_ACCESS
+; CHECK-NEXT: Type: <4 x float>
+; CHECK-NEXT: %v = load <4 x float> addrspace(1)* %in, align 4
+; 3-component vectors are aligned as 4-component vectors
+; CHECK: ERR_MISALIGNED_MEMORY_ACCESS
+; CHECK-NEXT: Type: <3 x float>
+; CHECK-NEXT: %v3 = load <3 x float> addrspace(1)* %in3, align 8
+; Members of packed structures may be underaligned
+; CHECK-NOT: %p = load
+; CHECK: ERR_MISALIGNED_MEMORY_ACCESS
+; CHECK-NEXT: Type: i64
+; CHECK-NEXT: store i64 0, i64 addrspace(1)* %out, align 4
+; Pointers are 8 bytes aligned in SPIR64
+; CHECK: ERR_MISALIGNED_MEMORY_ACCESS
+; CHECK-NEXT: Type: i32 addrspace(1)*
+; CHECK-NEXT: store i32 addrspace(1)* %ptr, i32 addrspace(1)** %slot, align 4
+; CHECK-NOT: ERR_MISALIGNED
+
+; The accesses of a function count for each kernel calling it.
+; SUMMARY: Memory alignment per kernel:
+; SUMMARY-NEXT: kernel align: 5 loads, 2 stores, 3 allocas, 5 misaligned
+; SUMMARY-NEXT: kernel other: 0 loads, 1 stores, 1 allocas, 1 misaligned
+
+define spir_kernel void @align(<4 x float> addrspace(1)* %in, <3 x float> addrspace(1)* %in3, i64 addrspace(1)* %out, %struct.packed addrspace(1)* %s) nounwind {
+  %vec = alloca <4 x i32>, align 4
+  %slot = alloca i32 addrspace(1)*, align 8
+  %v = load <4 x float> addrspace(1)* %in, align 4
+  %v3 = load <3 x float> addrspace(1)* %in3, align 8
+  %v3a = load <3 x float> addrspace(1)* %in3, align 16
+  %f = getelementptr %struct.packed addrspace(1)* %s, i32 0, i32 1
+  %p = load i32 addrspace(1)* %f, align 1
+  %n = load i32 addrspace(1)* %f
+  store i64 0, i64 addrspace(1)* %out, align 4
+  call spir_func void @helper(i32 addrspace(1)* null)
+  ret void
+}
+
+define spir_kernel void @other() nounwind {
+  call spir_func void @helper(i32 addrspace(1)* null)
+  ret void
+}
+
+define spir_func void @helper(i32 addrspace(1)* %ptr) nounwind {
+  %slot = alloca i32 addrspace(1)*, align 8
+  store i32 addrspace(1)* %ptr, i32 addrspace(1)** %slot, align 4
+  ret void
+}
@@ -0,0 +1,77 @@
+target datalayout = "e-p:32:32:32-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024"
+target triple = "spir-unknown-unknown"
+
+; RUN: llvm-as -o %t.bc %s
+; RUN: not spir_verifier -perf-lint -LIT-test-mode %t.bc 2>%t.out
+; RUN: FileCheck %s <%t.out
+; RUN: not spir_verifier -LIT-test-mode %t.bc 2>%t.nolint
+; RUN: FileCheck -check-prefix=NOLINT %s <%t.nolint
+
+; With -perf-lint, the tool shall report code that is valid but slow as
+; warnings, and count them per kernel, including the functions it calls.
+; NOLINT-NOT: WARN_
+; CHECK: The module contains the following performance warnings:
+; CHECK: Warning WARN_LARGE_PRIVATE_ALLOCA:
+; CHECK-NEXT: %big = alloca [256 x float]
+; CHECK-NEXT: Found in kernel: lint
+; CHECK-NOT: %small = alloca
+; CHECK: Warning WARN_UNDERALIGNED_VECTOR_ACCESS:
+; CHECK-NEXT: %v = load <4 x float> addrspace(1)* %in, align 4
+; CHECK-NOT: align 16
+; CHECK: Warning WARN_SCALARIZED_GLOBAL_VECTOR_ACCESS:
+; CHECK-NEXT: %x = load float addrspace(1)* %e
+; CHECK-NOT: store float %x
+; CHECK: Warning WARN_SMALL_MEMCPY:
+; CHECK-NEXT: i32 16, i32 4, i1 false)
+; CHECK-NOT: i32 1024, i32 4, i1 false)
+; CHECK: Warning WARN_LARGE_PRIVATE_ALLOCA:
+; CHECK-NEXT: %vla = alloca float, i32 %n
+; CHECK-NEXT: Found in function: helper
+; CHECK: Warning WARN_LARGE_PRIVATE_ALLOCA:
+; CHECK-NEXT: %unused.vla = alloca float, i32 %n
+; CHECK-NEXT: Found in function: unused
+; CHECK: Warnings per kernel:
+; CHECK-NEXT: kernel lint: 5
+; CHECK-NEXT: WARN_UNDERALIGNED_VECTOR_ACCESS: 1
+; CHECK-NEXT: WARN_LARGE_PRIVATE_ALLOCA: 2
+; CHECK-NEXT: WARN_SCALARIZED_GLOBAL_VECTOR_ACCESS: 1
+; CHECK-NEXT: WARN_SMALL_MEMCPY: 1
+; CHECK-NEXT: kernel caller: 1
+; CHECK-NEXT: WARN_LARGE_PRIVATE_ALLOCA: 1
+; CHECK-NEXT: Warnings in functions not called by a kernel:
+; CHECK-NEXT: function unused: 1
+; CHECK-NEXT: WARN_LARGE_PRIVATE_ALLOCA: 1
+
+define spir_kernel void @lint(<4 x float> addrspace(1)* %in, float addrspace(1)* %out) nounwind {
+  %big = alloca [256 x float], align 4
+  %small = alloca [4 x float], align 4
+  %v = load <4 x float> addrspace(1)* %in, align 4
+  %w = load <4 x float> addrspace(1)* %in, align 16
+  %p = bitcast <4 x float> addrspace(1)* %in to float addrspace(1)*
+  %e = getelementptr float addrspace(1)* %p, i32 2
+  %x = load float addrspace(1)* %e, align 4
+  store float %x, float addrspace(1)* %out, align 4
+  %dst = bitcast [4 x float]* %small to i8*
+  %src = bitcast [256 x float]* %big to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i32(i8* %dst, i8* %src, i32 16, i32 4, i1 false)
+  call void @llvm.memcpy.p0i8.p0i8.i32(i8* %src, i8* %src, i32 1024, i32 4, i1 false)
+  call spir_func void @helper(i32 4)
+  ret void
+}
+
+define spir_kernel void @caller(i32 %n) nounwind {
+  call spir_func void @helper(i32 %n)
+  ret void
+}
+
+define spir_func void @helper(i32 %n) nounwind {
+  %vla = alloca float, i32 %n
+  ret void
+}
+
+define spir_func void @unused(i32 %n) nounwind {
+  %unused.vla = alloca float, i32 %n
+  ret void
+}
+
+declare void @llvm.memcpy.p0i8.p0i8.i32(i8* nocapture, i8* nocapture, i32, i32, i1) nounwind
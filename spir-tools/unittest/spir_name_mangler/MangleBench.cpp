@@ -0,0 +1,573 @@
+//===------ MangleBench.cpp - Benchmarks for SPIR mangler -------*- C++ -*-===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// Performance benchmarks for the SPIR name mangler. Each workload is a list
+// of function descriptors modeled after a family of OpenCL C built-ins:
+//  - scalar:   scalar math and integer built-ins,
+//  - vector:   gentype overloads over all vector lengths and address spaces,
+//  - atomic:   SPIR 2.0 atomics on volatile pointers to atomic types,
+//  - block:    SPIR 2.0 enqueue_kernel overloads taking blocks,
+//  - udt:      functions on user defined types, exercising substitutions,
+//  - builtins: every built-in declared in opencl_spir.h (SPIR64).
+//
+// For each workload the suite measures NameMangler::mangle,
+// NameMangler::mangleGroups, FunctionDescriptor::toString and
+// FunctionDescriptor::operator< (while sorting the workload), and reports
+// nanoseconds and heap allocations per item. NameMangler::mangleBatch is
+// measured separately for 1..N threads over the vector workload.
+//
+// Usage: SpirNameManglerBench [-header <opencl_spir.h>] [-reps <n>]
+//                             [-threads <n>] [-format text|json|csv]
+//                             [-o <file>]
+//
+//===---------------------------------------------------------------------===//
+
+#include "spir_name_mangler/FunctionDescriptor.h"
+#include "spir_name_mangler/NameMangleAPI.h"
+#include "spir_name_mangler/ParameterType.h"
+#include "spir_name_mangler/Threading.h"
+#include "spir_verifier/builtins/OpenCLBuiltinParser.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#ifndef SPIR_OPENCL_HEADER_PATH
+#define SPIR_OPENCL_HEADER_PATH "opencl_spir.h"
+#endif
+
+using namespace SPIR;
+
+//
+// Heap allocation counting. Global operator new is replaced for the whole
+// executable; allocations are counted only while a single threaded
+// measurement is running.
+//
+
+static bool g_countAllocs = false;
+static unsigned long g_allocs = 0;
+
+static void *countedAlloc(size_t size) {
+  if (g_countAllocs)
+    ++g_allocs;
+  void *p = malloc(size ? size : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+#if __cplusplus >= 201103L
+#define SPIR_BENCH_THROW_BAD_ALLOC
+#else
+#define SPIR_BENCH_THROW_BAD_ALLOC throw(std::bad_alloc)
+#endif
+
+void *operator new(size_t size) SPIR_BENCH_THROW_BAD_ALLOC {
+  return countedAlloc(size);
+}
+
+void *operator new[](size_t size) SPIR_BENCH_THROW_BAD_ALLOC {
+  return countedAlloc(size);
+}
+
+void operator delete(void *p) throw() {
+  free(p);
+}
+
+void operator delete[](void *p) throw() {
+  free(p);
+}
+
+/// @brief Returns wall clock time in seconds.
+static double now() {
+#ifdef _WIN32
+  LARGE_INTEGER freq, count;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+  return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+#endif
+}
+
+//
+// Workloads
+//
+
+struct Workload {
+  std::string name;
+  SPIRversion version;
+  std::vector<FunctionDescriptor> fds;
+};
+
+static RefParamType prim(TypePrimitiveEnum p) {
+  return RefParamType(new PrimitiveType(p));
+}
+
+static RefParamType ptr(const RefParamType &pointee, TypeAttributeEnum as,
+                        bool isConst = false, bool isVolatile = false) {
+  PointerType *p = new PointerType(pointee);
+  p->setAddressSpace(as);
+  p->setQualifier(ATTR_CONST, isConst);
+  p->setQualifier(ATTR_VOLATILE, isVolatile);
+  return RefParamType(p);
+}
+
+static FunctionDescriptor func(const char *name, const RefParamType &a,
+                               const RefParamType &b = RefParamType(),
+                               const RefParamType &c = RefParamType()) {
+  FunctionDescriptor fd;
+  fd.name = name;
+  fd.parameters.push_back(a);
+  if (!b.isNull())
+    fd.parameters.push_back(b);
+  if (!c.isNull())
+    fd.parameters.push_back(c);
+  return fd;
+}
+
+static const TypePrimitiveEnum g_scalars[] = {
+  PRIMITIVE_UCHAR, PRIMITIVE_CHAR, PRIMITIVE_USHORT, PRIMITIVE_SHORT,
+  PRIMITIVE_UINT, PRIMITIVE_INT, PRIMITIVE_ULONG, PRIMITIVE_LONG,
+  PRIMITIVE_HALF, PRIMITIVE_FLOAT, PRIMITIVE_DOUBLE
+};
+static const unsigned g_numScalars = sizeof(g_scalars)/sizeof(g_scalars[0]);
+
+static const TypeAttributeEnum g_addrSpaces[] = {
+  ATTR_PRIVATE, ATTR_GLOBAL, ATTR_LOCAL
+};
+
+static Workload makeScalar() {
+  static const char *unary[] = { "abs", "clz", "popcount", "fabs", "sqrt" };
+  static const char *binary[] = { "max", "min", "add_sat", "hypot", "pow" };
+  Workload w;
+  w.name = "scalar";
+  w.version = SPIR12;
+  for (unsigned s = 0; s < g_numScalars; ++s) {
+    RefParamType t = prim(g_scalars[s]);
+    for (unsigned i = 0; i < 5; ++i)
+      w.fds.push_back(func(unary[i], t));
+    for (unsigned i = 0; i < 5; ++i)
+      w.fds.push_back(func(binary[i], t, t));
+    w.fds.push_back(func("mad", t, t, t));
+  }
+  return w;
+}
+
+static Workload makeVector() {
+  static const int lengths[] = { 2, 3, 4, 8, 16 };
+  static const char *names[] = { "fract", "modf", "sincos" };
+  Workload w;
+  w.name = "vector";
+  w.version = SPIR12;
+  // gentype f(gentype, __as gentype *)
+  for (unsigned n = 0; n < 3; ++n) {
+    for (unsigned s = 8; s < g_numScalars; ++s) {
+      for (unsigned l = 0; l < 5; ++l) {
+        RefParamType v(new VectorType(prim(g_scalars[s]), lengths[l]));
+        for (unsigned a = 0; a < 3; ++a)
+          w.fds.push_back(func(names[n], v, ptr(v, g_addrSpaces[a])));
+      }
+    }
+  }
+  // gentypen vloadn(size_t, const __as gentype *)
+  for (unsigned l = 0; l < 5; ++l) {
+    std::stringstream name;
+    name << "vload" << lengths[l];
+    for (unsigned s = 0; s < g_numScalars; ++s) {
+      for (unsigned a = 0; a < 3; ++a) {
+        w.fds.push_back(func(name.str().c_str(), prim(PRIMITIVE_ULONG),
+                             ptr(prim(g_scalars[s]), g_addrSpaces[a], true)));
+      }
+    }
+  }
+  return w;
+}
+
+static Workload makeAtomic() {
+  static const char *names[] = {
+    "atomic_fetch_add_explicit", "atomic_fetch_sub_explicit",
+    "atomic_exchange_explicit", "atomic_compare_exchange_strong_explicit"
+  };
+  static const TypePrimitiveEnum types[] = {
+    PRIMITIVE_INT, PRIMITIVE_UINT, PRIMITIVE_LONG, PRIMITIVE_ULONG
+  };
+  Workload w;
+  w.name = "atomic";
+  w.version = SPIR20;
+  RefParamType order(new UserDefinedType("memory_order"));
+  RefParamType scope(new UserDefinedType("memory_scope"));
+  for (unsigned n = 0; n < 4; ++n) {
+    for (unsigned t = 0; t < 4; ++t) {
+      RefParamType base = prim(types[t]);
+      RefParamType atomic(new AtomicType(base));
+      for (unsigned a = 0; a < 3; ++a) {
+        RefParamType object = ptr(atomic, g_addrSpaces[a], false, true);
+        FunctionDescriptor fd;
+        fd.name = names[n];
+        fd.parameters.push_back(object);
+        if (n == 3)
+          fd.parameters.push_back(ptr(base, g_addrSpaces[a]));
+        fd.parameters.push_back(base);
+        fd.parameters.push_back(order);
+        if (n == 3)
+          fd.parameters.push_back(order);
+        fd.parameters.push_back(scope);
+        w.fds.push_back(fd);
+      }
+    }
+  }
+  return w;
+}
+
+static Workload makeBlock() {
+  Workload w;
+  w.name = "block";
+  w.version = SPIR20;
+  RefParamType queue = prim(PRIMITIVE_QUEUE_T);
+  RefParamType ndrange = prim(PRIMITIVE_NDRANGE_T);
+  RefParamType flags(new UserDefinedType("kernel_enqueue_flags_t"));
+  RefParamType clkEvent = prim(PRIMITIVE_CLK_EVENT_T);
+  RefParamType localPtr = ptr(prim(PRIMITIVE_VOID), ATTR_LOCAL);
+  for (unsigned locals = 0; locals < 4; ++locals) {
+    BlockType *block = new BlockType();
+    for (unsigned i = 0; i < locals; ++i)
+      block->setParam(i, localPtr);
+    RefParamType blockRef(block);
+    for (unsigned events = 0; events < 2; ++events) {
+      FunctionDescriptor fd;
+      fd.name = "enqueue_kernel";
+      fd.parameters.push_back(queue);
+      fd.parameters.push_back(flags);
+      fd.parameters.push_back(ndrange);
+      if (events) {
+        fd.parameters.push_back(prim(PRIMITIVE_UINT));
+        fd.parameters.push_back(ptr(clkEvent, ATTR_PRIVATE, true));
+        fd.parameters.push_back(ptr(clkEvent, ATTR_PRIVATE));
+      }
+      fd.parameters.push_back(blockRef);
+      for (unsigned i = 0; i < locals; ++i)
+        fd.parameters.push_back(prim(PRIMITIVE_UINT));
+      w.fds.push_back(fd);
+    }
+  }
+  return w;
+}
+
+static Workload makeUDT() {
+  Workload w;
+  w.name = "udt";
+  w.version = SPIR12;
+  for (unsigned i = 0; i < 64; ++i) {
+    std::stringstream tyName, fName;
+    tyName << "struct_type_" << i;
+    fName << "process" << i % 8;
+    RefParamType udt(new UserDefinedType(tyName.str()));
+    RefParamType udtPtr = ptr(udt, g_addrSpaces[i % 3]);
+    FunctionDescriptor fd;
+    fd.name = fName.str();
+    fd.parameters.push_back(udtPtr);
+    fd.parameters.push_back(udt);
+    fd.parameters.push_back(udtPtr);
+    fd.parameters.push_back(ptr(udt, ATTR_GLOBAL, true));
+    w.fds.push_back(fd);
+  }
+  return w;
+}
+
+static bool makeBuiltins(const char *header, Workload &w) {
+  std::string src;
+  if (!readOpenCLHeader(header, src))
+    return false;
+  std::vector<std::string> errors;
+  w.name = "builtins";
+  w.version = SPIR12;
+  parseOpenCLBuiltins(src, false, w.fds, errors);
+  return !w.fds.empty();
+}
+
+//
+// Measurements
+//
+
+struct Result {
+  std::string benchmark;
+  std::string workload;
+  /// Number of items (signatures or comparisons) in the fastest run.
+  size_t items;
+  double nsPerItem;
+  double allocsPerItem;
+};
+
+// Minimal number of items per timed run, small workloads are repeated to keep
+// the timer resolution out of the results.
+static const size_t MinItemsPerRun = 20000;
+
+/// @brief Runs a benchmark body reps times, keeping the fastest run.
+///        The body's operator()() returns the number of items processed.
+template <typename Body>
+static Result measure(const char *benchmark, const Workload &w, Body body,
+                      unsigned reps) {
+  Result r;
+  r.benchmark = benchmark;
+  r.workload = w.name;
+  r.items = 0;
+  double best = 0;
+  unsigned long allocs = 0;
+  for (unsigned i = 0; i < reps; ++i) {
+    g_allocs = 0;
+    g_countAllocs = true;
+    double start = now();
+    size_t items = 0;
+    do {
+      items += body();
+    } while (items && items < MinItemsPerRun);
+    double elapsed = now() - start;
+    g_countAllocs = false;
+    if (i == 0 || elapsed < best) {
+      best = elapsed;
+      allocs = g_allocs;
+      r.items = items;
+    }
+  }
+  r.nsPerItem = r.items ? best * 1e9 / r.items : 0;
+  r.allocsPerItem = r.items ? (double)allocs / r.items : 0;
+  return r;
+}
+
+struct MangleBody {
+  const Workload *w;
+  std::string *name;
+  size_t operator()() {
+    NameMangler nm(w->version);
+    for (size_t i = 0; i < w->fds.size(); ++i)
+      nm.mangle(w->fds[i], *name);
+    return w->fds.size();
+  }
+};
+
+struct MangleGroupsBody {
+  const Workload *w;
+  MangledNamePool *pool;
+  size_t operator()() {
+    NameMangler nm(w->version);
+    nm.mangleGroups(&w->fds[0], w->fds.size(), *pool);
+    return w->fds.size();
+  }
+};
+
+struct ToStringBody {
+  const Workload *w;
+  size_t operator()() {
+    size_t total = 0;
+    for (size_t i = 0; i < w->fds.size(); ++i)
+      total += w->fds[i].toString().size();
+    return total ? w->fds.size() : 0;
+  }
+};
+
+static size_t g_comparisons = 0;
+
+static bool lessCounted(const FunctionDescriptor *a,
+                        const FunctionDescriptor *b) {
+  ++g_comparisons;
+  return *a < *b;
+}
+
+struct SortBody {
+  const Workload *w;
+  std::vector<const FunctionDescriptor*> *order;
+  size_t operator()() {
+    // Reverse order, so the sort has work to do for presorted workloads.
+    for (size_t i = 0; i < w->fds.size(); ++i)
+      (*order)[i] = &w->fds[w->fds.size() - 1 - i];
+    g_comparisons = 0;
+    std::sort(order->begin(), order->end(), lessCounted);
+    return g_comparisons;
+  }
+};
+
+static void runWorkload(const Workload &w, unsigned reps,
+                        std::vector<Result> &results) {
+  std::string name;
+  name.reserve(256);
+  MangleBody mangleBody = { &w, &name };
+  results.push_back(measure("mangle", w, mangleBody, reps));
+
+  MangledNamePool pool;
+  MangleGroupsBody groupsBody = { &w, &pool };
+  results.push_back(measure("mangleGroups", w, groupsBody, reps));
+
+  ToStringBody toStringBody = { &w };
+  results.push_back(measure("toString", w, toStringBody, reps));
+
+  std::vector<const FunctionDescriptor*> order(w.fds.size());
+  SortBody sortBody = { &w, &order };
+  results.push_back(measure("operator<", w, sortBody, reps));
+}
+
+static void runScaling(const Workload &w, unsigned reps, unsigned maxThreads,
+                       std::vector<Result> &results) {
+  // Replicate the workload, so each thread gets a meaningful slice.
+  std::vector<FunctionDescriptor> fds;
+  while (fds.size() < 100000)
+    fds.insert(fds.end(), w.fds.begin(), w.fds.end());
+  NameMangler nm(w.version);
+  std::vector<std::string> out;
+
+  for (unsigned threads = 1; ; threads *= 2) {
+    if (threads > maxThreads)
+      threads = maxThreads;
+    double best = 0;
+    for (unsigned r = 0; r < reps; ++r) {
+      double start = now();
+      nm.mangleBatch(&fds[0], fds.size(), out, threads);
+      double elapsed = now() - start;
+      if (r == 0 || elapsed < best)
+        best = elapsed;
+    }
+    std::stringstream name;
+    name << "mangleBatch/" << threads << "t";
+    Result res;
+    res.benchmark = name.str();
+    res.workload = w.name;
+    res.items = fds.size();
+    res.nsPerItem = best * 1e9 / fds.size();
+    // Allocations are not counted across threads.
+    res.allocsPerItem = -1;
+    results.push_back(res);
+    if (threads == maxThreads)
+      break;
+  }
+}
+
+//
+// Output
+//
+
+static void printText(FILE *out, const std::vector<Result> &results) {
+  fprintf(out, "%-16s %-10s %10s %12s %12s\n", "benchmark", "workload",
+          "items", "ns/item", "allocs/item");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    fprintf(out, "%-16s %-10s %10lu %12.1f ", r.benchmark.c_str(),
+            r.workload.c_str(), (unsigned long)r.items, r.nsPerItem);
+    if (r.allocsPerItem < 0)
+      fprintf(out, "%12s\n", "-");
+    else
+      fprintf(out, "%12.2f\n", r.allocsPerItem);
+  }
+}
+
+static void printCSV(FILE *out, const std::vector<Result> &results) {
+  fprintf(out, "benchmark,workload,items,ns_per_item,allocs_per_item\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    fprintf(out, "%s,%s,%lu,%.3f,", r.benchmark.c_str(), r.workload.c_str(),
+            (unsigned long)r.items, r.nsPerItem);
+    if (r.allocsPerItem >= 0)
+      fprintf(out, "%.3f", r.allocsPerItem);
+    fprintf(out, "\n");
+  }
+}
+
+static void printJSON(FILE *out, const std::vector<Result> &results) {
+  fprintf(out, "{\n  \"results\": [\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    fprintf(out, "    {\"benchmark\": \"%s\", \"workload\": \"%s\", "
+                 "\"items\": %lu, \"ns_per_item\": %.3f, "
+                 "\"allocs_per_item\": ",
+            r.benchmark.c_str(), r.workload.c_str(), (unsigned long)r.items,
+            r.nsPerItem);
+    if (r.allocsPerItem < 0)
+      fprintf(out, "null}");
+    else
+      fprintf(out, "%.3f}", r.allocsPerItem);
+    fprintf(out, "%s\n", i + 1 < results.size() ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+int main(int argc, char **argv) {
+  const char *header = SPIR_OPENCL_HEADER_PATH;
+  const char *format = "text";
+  const char *outFile = NULL;
+  unsigned reps = 5;
+  unsigned maxThreads = Thread::hardwareConcurrency();
+  bool badArgs = false;
+
+  for (int i = 1; i < argc; ++i) {
+    if (i + 1 < argc && !strcmp(argv[i], "-header"))
+      header = argv[++i];
+    else if (i + 1 < argc && !strcmp(argv[i], "-reps"))
+      reps = (unsigned)atoi(argv[++i]);
+    else if (i + 1 < argc && !strcmp(argv[i], "-threads"))
+      maxThreads = (unsigned)atoi(argv[++i]);
+    else if (i + 1 < argc && !strcmp(argv[i], "-format"))
+      format = argv[++i];
+    else if (i + 1 < argc && !strcmp(argv[i], "-o"))
+      outFile = argv[++i];
+    else
+      badArgs = true;
+  }
+  if (strcmp(format, "text") && strcmp(format, "json") &&
+      strcmp(format, "csv"))
+    badArgs = true;
+  if (badArgs || !reps || !maxThreads) {
+    fprintf(stderr, "usage: %s [-header <opencl_spir.h>] [-reps <n>] "
+                    "[-threads <n>] [-format text|json|csv] [-o <file>]\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::vector<Workload> workloads;
+  workloads.push_back(makeScalar());
+  workloads.push_back(makeVector());
+  workloads.push_back(makeAtomic());
+  workloads.push_back(makeBlock());
+  workloads.push_back(makeUDT());
+  Workload builtins;
+  if (makeBuiltins(header, builtins))
+    workloads.push_back(builtins);
+  else
+    fprintf(stderr, "warning: no built-ins read from %s, skipping the "
+                    "builtins workload\n", header);
+
+  std::vector<Result> results;
+  for (size_t i = 0; i < workloads.size(); ++i)
+    runWorkload(workloads[i], reps, results);
+  runScaling(workloads[1], reps, maxThreads, results);
+
+  FILE *out = stdout;
+  if (outFile && !(out = fopen(outFile, "w"))) {
+    fprintf(stderr, "cannot write %s\n", outFile);
+    return 1;
+  }
+  if (!strcmp(format, "json"))
+    printJSON(out, results);
+  else if (!strcmp(format, "csv"))
+    printCSV(out, results);
+  else
+    printText(out, results);
+  if (out != stdout)
+    fclose(out);
+  return 0;
+}
@@ -8,9 +8,12 @@
 //===---------------------------------------------------------------------===//
 
 #include "spir_name_mangler/FunctionDescriptor.h"
+#include "spir_name_mangler/MangleCache.h"
 #include "spir_name_mangler/NameMangleAPI.h"
 #include "spir_name_mangler/ParameterType.h"
 #include "gtest/gtest.h"
+#include <map>
+#include <vector>
 
 using namespace SPIR;
 
@@ -957,6 +960,184 @@ TEST(AttrOrderTest, removePtrQualifiers) {
   ASSERT_STREQ(s, mangled.c_str());
 }
 
+static FunctionDescriptor makeFract(TypePrimitiveEnum scalar, int len,
+                                    TypeAttributeEnum addrSpace) {
+  // fract(gentype, addrSpace gentype*)
+  RefParamType elem(new PrimitiveType(scalar));
+  RefParamType vec(new VectorType(elem, len));
+  PointerType *ptr = new PointerType(vec);
+  ptr->setAddressSpace(addrSpace);
+  FunctionDescriptor fd;
+  fd.name = "fract";
+  fd.parameters.push_back(vec);
+  fd.parameters.push_back(RefParamType(ptr));
+  return fd;
+}
+
+TEST(DescriptorCompare, structuralEquality) {
+  FunctionDescriptor a = makeFract(PRIMITIVE_FLOAT, 4, ATTR_GLOBAL);
+  FunctionDescriptor b = makeFract(PRIMITIVE_FLOAT, 4, ATTR_GLOBAL);
+  ASSERT_TRUE(a == b);
+  ASSERT_FALSE(a < b);
+  ASSERT_FALSE(b < a);
+  ASSERT_EQ(a.hash(), b.hash());
+  ASSERT_EQ(0, a.parameters[1]->compare(b.parameters[1]));
+}
+
+TEST(DescriptorCompare, structuralOrder) {
+  FunctionDescriptor descs[] = {
+    makeFract(PRIMITIVE_FLOAT, 4, ATTR_GLOBAL),
+    makeFract(PRIMITIVE_FLOAT, 4, ATTR_LOCAL),
+    makeFract(PRIMITIVE_FLOAT, 2, ATTR_GLOBAL),
+    makeFract(PRIMITIVE_DOUBLE, 4, ATTR_GLOBAL)
+  };
+  const size_t n = sizeof(descs)/sizeof(descs[0]);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      if (i == j)
+        continue;
+      ASSERT_FALSE(descs[i] == descs[j]);
+      // Exactly one of the two must order first.
+      ASSERT_NE(descs[i] < descs[j], descs[j] < descs[i]);
+    }
+  }
+  // Different kinds of types are ordered by their type id.
+  RefParamType prim(new PrimitiveType(PRIMITIVE_INT));
+  RefParamType udt(new UserDefinedType("int"));
+  ASSERT_LT(prim->compare(udt), 0);
+  ASSERT_GT(udt->compare(prim), 0);
+  ASSERT_FALSE(prim->equals(udt));
+}
+
+TEST(DescriptorCompare, mapKey) {
+  std::map<FunctionDescriptor, int> m;
+  m[makeFract(PRIMITIVE_FLOAT, 4, ATTR_GLOBAL)] = 1;
+  m[makeFract(PRIMITIVE_FLOAT, 4, ATTR_PRIVATE)] = 2;
+  m[makeFract(PRIMITIVE_FLOAT, 4, ATTR_GLOBAL)] = 3;
+  ASSERT_EQ(2U, m.size());
+  ASSERT_EQ(3, m[makeFract(PRIMITIVE_FLOAT, 4, ATTR_GLOBAL)]);
+}
+
+TEST(MangleCacheTest, cachedNames) {
+  NameMangler nm(SPIR12);
+  MangleCache cache(SPIR12);
+  TypeAttributeEnum addrSpaces[] = { ATTR_PRIVATE, ATTR_GLOBAL, ATTR_LOCAL };
+  int lengths[] = { 2, 3, 4, 8, 16 };
+  for (int pass = 0; pass < 2; ++pass) {
+    for (unsigned i = 0; i < 3; ++i) {
+      for (unsigned j = 0; j < 5; ++j) {
+        FunctionDescriptor fd =
+          makeFract(PRIMITIVE_FLOAT, lengths[j], addrSpaces[i]);
+        std::string expected, mangled;
+        ASSERT_EQ(MANGLE_SUCCESS, nm.mangle(fd, expected));
+        ASSERT_EQ(MANGLE_SUCCESS, cache.mangle(fd, mangled));
+        ASSERT_EQ(expected, mangled);
+      }
+    }
+    // The second pass is served from the cache.
+    ASSERT_EQ(15U, cache.size());
+  }
+  std::string mangled;
+  cache.mangle(makeFract(PRIMITIVE_FLOAT, 3, ATTR_GLOBAL), mangled);
+  ASSERT_STREQ("_Z5fractDv3_fPU3AS1Dv3_f", mangled.c_str());
+  cache.clear();
+  ASSERT_EQ(0U, cache.size());
+}
+
+TEST(MangleCacheTest, errorsNotCached) {
+  MangleCache cache(SPIR12);
+  FunctionDescriptor fd;
+  fd.name = "foo";
+  fd.parameters.push_back(RefParamType(new BlockType()));
+  std::string mangled;
+  ASSERT_EQ(MANGLE_TYPE_NOT_SUPPORTED, cache.mangle(fd, mangled));
+  ASSERT_EQ(0U, cache.size());
+}
+
+TEST(MangleCacheTest, sharedParameterObjects) {
+  // "fract_ret2ptr(float, float*, float*)", once with two pointer objects
+  // and once with a single one; the descriptors are structurally equal but
+  // the shared pointer is substituted.
+  RefParamType primitiveFloat(new PrimitiveType(PRIMITIVE_FLOAT));
+  RefParamType ptr1(new PointerType(primitiveFloat));
+  RefParamType ptr2(new PointerType(primitiveFloat));
+  FunctionDescriptor distinct, shared;
+  distinct.name = shared.name = "fract_ret2ptr";
+  distinct.parameters.push_back(primitiveFloat);
+  distinct.parameters.push_back(ptr1);
+  distinct.parameters.push_back(ptr2);
+  shared.parameters.push_back(primitiveFloat);
+  shared.parameters.push_back(ptr1);
+  shared.parameters.push_back(ptr1);
+  ASSERT_TRUE(distinct == shared);
+
+  NameMangler nm(SPIR12);
+  std::string expectedDistinct, expectedShared;
+  ASSERT_EQ(MANGLE_SUCCESS, nm.mangle(distinct, expectedDistinct));
+  ASSERT_EQ(MANGLE_SUCCESS, nm.mangle(shared, expectedShared));
+  ASSERT_STREQ("_Z13fract_ret2ptrfPfPf", expectedDistinct.c_str());
+  ASSERT_STREQ("_Z13fract_ret2ptrfPfS0_", expectedShared.c_str());
+
+  MangleCache cache(SPIR12);
+  for (int pass = 0; pass < 2; ++pass) {
+    std::string mangled;
+    ASSERT_EQ(MANGLE_SUCCESS, cache.mangle(distinct, mangled));
+    ASSERT_EQ(expectedDistinct, mangled);
+    ASSERT_EQ(MANGLE_SUCCESS, cache.mangle(shared, mangled));
+    ASSERT_EQ(expectedShared, mangled);
+  }
+  ASSERT_EQ(2U, cache.size());
+}
+
+TEST(MangleGroupsTest, matchesPerCall) {
+  // fract overloads across vector lengths and address spaces, followed by
+  // a different function and another fract overload.
+  std::vector<FunctionDescriptor> fds;
+  TypeAttributeEnum addrSpaces[] = { ATTR_PRIVATE, ATTR_GLOBAL, ATTR_LOCAL };
+  int lengths[] = { 2, 3, 4, 8, 16 };
+  for (unsigned i = 0; i < 3; ++i)
+    for (unsigned j = 0; j < 5; ++j)
+      fds.push_back(makeFract(PRIMITIVE_FLOAT, lengths[j], addrSpaces[i]));
+  FunctionDescriptor absFd;
+  absFd.name = "abs";
+  absFd.parameters.push_back(RefParamType(new PrimitiveType(PRIMITIVE_INT)));
+  fds.push_back(absFd);
+  fds.push_back(makeFract(PRIMITIVE_DOUBLE, 4, ATTR_GLOBAL));
+
+  NameMangler nm(SPIR12);
+  MangledNamePool pool;
+  ASSERT_EQ(MANGLE_SUCCESS, nm.mangleGroups(&fds[0], fds.size(), pool));
+  ASSERT_EQ(fds.size(), pool.size());
+  for (size_t i = 0; i < fds.size(); ++i) {
+    std::string expected;
+    ASSERT_EQ(MANGLE_SUCCESS, nm.mangle(fds[i], expected));
+    ASSERT_EQ(expected, pool.get(i));
+    ASSERT_EQ(expected.size(), pool.length(i));
+  }
+  ASSERT_EQ("_Z3absi", pool.get(15));
+}
+
+TEST(MangleGroupsTest, errorsInPool) {
+  FunctionDescriptor fds[3];
+  fds[0] = makeFract(PRIMITIVE_FLOAT, 4, ATTR_GLOBAL);
+  fds[1] = makeFract(PRIMITIVE_FLOAT, 4, ATTR_GLOBAL);
+  fds[1].parameters.push_back(RefParamType(new BlockType()));
+  fds[2] = makeFract(PRIMITIVE_FLOAT, 2, ATTR_GLOBAL);
+
+  NameMangler nm(SPIR12);
+  MangledNamePool pool;
+  ASSERT_EQ(MANGLE_TYPE_NOT_SUPPORTED, nm.mangleGroups(fds, 3, pool));
+  std::string expected;
+  ASSERT_EQ(MANGLE_TYPE_NOT_SUPPORTED, nm.mangle(fds[1], expected));
+  ASSERT_EQ(expected, pool.get(1));
+  nm.mangle(fds[2], expected);
+  ASSERT_EQ(expected, pool.get(2));
+
+  // The pool is reset by each call.
+  ASSERT_EQ(MANGLE_SUCCESS, nm.mangleGroups(fds, 1, pool));
+  ASSERT_EQ(1U, pool.size());
+}
+
 }// End namespace test
 }// End namespace namemangling
 
@@ -0,0 +1,154 @@
+//===--- MangleThreadTest.cpp - Threading tests for SPIR mangler -*- C++ -*-===//
+//
+//                              SPIR Tools
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===---------------------------------------------------------------------===//
+//
+// These tests share parameter types, manglers and caches between threads.
+// Build them with -DLLVM_USE_SANITIZER=Thread to have ThreadSanitizer check
+// them for data races.
+//
+//===---------------------------------------------------------------------===//
+
+#include "spir_name_mangler/FunctionDescriptor.h"
+#include "spir_name_mangler/MangleCache.h"
+#include "spir_name_mangler/NameMangleAPI.h"
+#include "spir_name_mangler/ParameterType.h"
+#include "spir_name_mangler/Threading.h"
+#include "gtest/gtest.h"
+#include <sstream>
+#include <vector>
+
+using namespace SPIR;
+
+namespace namemangling { namespace tests {
+
+static const unsigned NumThreads = 8;
+
+// Builds descriptors that share their parameter types:
+// fN(float4, __global float4*, myTy, myTy*).
+static std::vector<FunctionDescriptor> makeSharedBatch(size_t count) {
+  RefParamType vec(new VectorType(
+    RefParamType(new PrimitiveType(PRIMITIVE_FLOAT)), 4));
+  PointerType *ptr = new PointerType(vec);
+  ptr->setAddressSpace(ATTR_GLOBAL);
+  RefParamType vecPtr(ptr);
+  RefParamType udt(new UserDefinedType("myTy"));
+  RefParamType udtPtr(new PointerType(udt));
+
+  std::vector<FunctionDescriptor> fds(count);
+  for (size_t i = 0; i < count; ++i) {
+    std::stringstream name;
+    name << "f" << i;
+    fds[i].name = name.str();
+    fds[i].parameters.push_back(vec);
+    fds[i].parameters.push_back(vecPtr);
+    fds[i].parameters.push_back(udt);
+    fds[i].parameters.push_back(udtPtr);
+  }
+  return fds;
+}
+
+struct CopyJob {
+  const RefParamType *shared;
+  unsigned iterations;
+};
+
+static void copyShared(void *arg) {
+  CopyJob *job = static_cast<CopyJob*>(arg);
+  for (unsigned i = 0; i < job->iterations; ++i) {
+    RefParamType copy(*job->shared);
+    RefParamType other = copy;
+  }
+}
+
+TEST(MangleThreads, sharedRefCount) {
+  // Copies of a shared type are created and destroyed concurrently, the
+  // counter has to stay balanced.
+  RefParamType shared(new PrimitiveType(PRIMITIVE_INT));
+  CopyJob job = { &shared, 10000 };
+  Thread threads[NumThreads];
+  for (unsigned t = 0; t < NumThreads; ++t)
+    ASSERT_TRUE(threads[t].start(copyShared, &job));
+  for (unsigned t = 0; t < NumThreads; ++t)
+    threads[t].join();
+  ASSERT_EQ(PRIMITIVE_INT,
+    SPIR::dyn_cast<PrimitiveType>(&*shared)->getPrimitive());
+}
+
+TEST(MangleThreads, batchMatchesSerial) {
+  std::vector<FunctionDescriptor> fds = makeSharedBatch(1000);
+  NameMangler nm(SPIR12);
+  std::vector<std::string> batch;
+  ASSERT_EQ(MANGLE_SUCCESS,
+    nm.mangleBatch(&fds[0], fds.size(), batch, NumThreads));
+  ASSERT_EQ(fds.size(), batch.size());
+  for (size_t i = 0; i < fds.size(); ++i) {
+    std::string serial;
+    ASSERT_EQ(MANGLE_SUCCESS, nm.mangle(fds[i], serial));
+    ASSERT_EQ(serial, batch[i]);
+  }
+  ASSERT_STREQ("_Z2f0Dv4_fPU3AS1Dv4_f4myTyPS1_", batch[0].c_str());
+}
+
+TEST(MangleThreads, batchReportsFirstError) {
+  std::vector<FunctionDescriptor> fds = makeSharedBatch(500);
+  fds[300].parameters.push_back(RefParamType(new BlockType()));
+  fds[400] = FunctionDescriptor::null();
+  NameMangler nm(SPIR12);
+  std::vector<std::string> batch;
+  ASSERT_EQ(MANGLE_TYPE_NOT_SUPPORTED,
+    nm.mangleBatch(&fds[0], fds.size(), batch, NumThreads));
+  ASSERT_EQ(FunctionDescriptor::nullString(), batch[400]);
+  std::string serial;
+  nm.mangle(fds[299], serial);
+  ASSERT_EQ(serial, batch[299]);
+}
+
+TEST(MangleThreads, emptyBatch) {
+  NameMangler nm(SPIR12);
+  std::vector<std::string> batch(3);
+  ASSERT_EQ(MANGLE_SUCCESS, nm.mangleBatch(NULL, 0, batch));
+  ASSERT_TRUE(batch.empty());
+}
+
+struct CacheJob {
+  MangleCache *cache;
+  const std::vector<FunctionDescriptor> *fds;
+  bool ok;
+};
+
+static void mangleCached(void *arg) {
+  CacheJob *job = static_cast<CacheJob*>(arg);
+  NameMangler nm(SPIR12);
+  job->ok = true;
+  for (size_t i = 0; i < job->fds->size(); ++i) {
+    std::string cached, expected;
+    job->cache->mangle((*job->fds)[i], cached);
+    nm.mangle((*job->fds)[i], expected);
+    job->ok = job->ok && (cached == expected);
+  }
+}
+
+TEST(MangleThreads, sharedCache) {
+  std::vector<FunctionDescriptor> fds = makeSharedBatch(200);
+  MangleCache cache(SPIR12);
+  CacheJob jobs[NumThreads];
+  Thread threads[NumThreads];
+  for (unsigned t = 0; t < NumThreads; ++t) {
+    CacheJob job = { &cache, &fds, false };
+    jobs[t] = job;
+    ASSERT_TRUE(threads[t].start(mangleCached, &jobs[t]));
+  }
+  for (unsigned t = 0; t < NumThreads; ++t) {
+    threads[t].join();
+    ASSERT_TRUE(jobs[t].ok);
+  }
+  ASSERT_EQ(fds.size(), cache.size());
+}
+
+}// End namespace test
+}// End namespace namemangling